@@ -25,14 +25,69 @@ SOFTWARE.
 #define ORGLAB_DATA_HPP
 
 #include <exception>
+#include <stdexcept>
 #include <vector>
+#include <string>
+#include <string_view>
 #include <complex>
+#include <cmath>
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <climits>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <iterator>
+#include <tuple>
+#include <array>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory>
+#include <functional>
+#include <future>
+#include <type_traits>
+#if defined(_WIN32)
 #include <windows.h>
 #include <comutil.h>
 #include <comdef.h>
 #include <atlsafe.h>
+#elif !defined(ORGLAB_DATA_FAKE_HPP)
+#error "orglab_data.hpp needs the Windows COM headers. Elsewhere include orglab_data_fake.hpp first."
+#endif
 #include <ostream>
 #include <assert.h>
+#if (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L) || __cplusplus >= 202002L
+#include <span>
+#define ORGLAB_DATA_HAS_SPAN
+#endif
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#include <coroutine>
+#define ORGLAB_DATA_HAS_COROUTINE
+#endif
+#endif
+#if !defined(ORGLAB_DATA_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define ORGLAB_DATA_SSE2
+#if defined(_MSC_VER) || defined(__GNUC__) || defined(__clang__)
+#include <immintrin.h>
+#define ORGLAB_DATA_AVX2
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define ORGLAB_DATA_TARGET_AVX2
+#else
+#define ORGLAB_DATA_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#endif
 
 #ifndef ORGLAB_DATA_ORGLAB_NS
 #define ORGLAB_DATA_ORGLAB_NS origin
@@ -44,6 +99,24 @@ SOFTWARE.
 #define ORGLAB_DATA_CDT true
 #endif
 
+#ifdef ORGLAB_DATA_CONVERT_DATA_TYPE
+#define ORGLAB_DATA_CVT true
+#else
+#define ORGLAB_DATA_CVT false
+#endif
+
+#ifdef ORGLAB_DATA_ZERO_COPY
+#define ORGLAB_DATA_ZC true
+#else
+#define ORGLAB_DATA_ZC false
+#endif
+
+#ifdef ORGLAB_DATA_CHECK_BLOCK_FORMATS
+#define ORGLAB_DATA_CBF true
+#else
+#define ORGLAB_DATA_CBF false
+#endif
+
 namespace orglab_data {
 	using namespace ORGLAB_DATA_ORGLAB_NS;
 
@@ -51,46 +124,534 @@ namespace orglab_data {
 
 	namespace impl { // Begin namespace for internal implementation.
 
+		//// SIMD DISPATCH ////
+		// SSE2 is the compile-time baseline. AVX2 kernels are compiled regardless of compiler flags
+		// and picked at runtime when the CPU and OS support them.
+
+		enum class simd_level { scalar = 0, sse2 = 1, avx2 = 2 };
+
+		inline simd_level detect_simd_level() {
+#if defined(ORGLAB_DATA_AVX2) && defined(_MSC_VER) && !defined(__clang__)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] >= 7) {
+				__cpuid(info, 1);
+				bool os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (6 == (_xgetbv(0) & 6));
+				__cpuidex(info, 7, 0);
+				if (os_avx && (info[1] & (1 << 5)))
+					return simd_level::avx2;
+			}
+			return simd_level::sse2;
+#elif defined(ORGLAB_DATA_AVX2)
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2") ? simd_level::avx2 : simd_level::sse2;
+#elif defined(ORGLAB_DATA_SSE2)
+			return simd_level::sse2;
+#else
+			return simd_level::scalar;
+#endif
+		}
+
+		inline std::atomic<simd_level>& simd_level_state() {
+			static std::atomic<simd_level> level{ detect_simd_level() };
+			return level;
+		}
+
+		inline simd_level get_simd_level() {
+			return simd_level_state().load(std::memory_order_relaxed);
+		}
+
+		//// TRANSPOSE KERNELS ////
+		// Origin matrices travel row major and matrix_adapter is column major, so matrix uploads and
+		// matrix_adapter::transpose all transpose. The engine walks the matrix in tiles that fit L1
+		// and transposes each tile with a SIMD micro-kernel where the element size allows.
+
+		/* Elements that can be moved as raw bits of the same size */
+		template<class D, class S>
+		struct is_bitwise_transposable : std::integral_constant<bool, sizeof(D) == sizeof(S) && std::is_trivially_copyable<D>::value &&
+			(std::is_same<D, S>::value || (std::is_integral<D>::value && std::is_integral<S>::value))> {};
+
+		/* Tile edge in elements. Two tiles (source and destination) stay within 32 KiB. */
+		template<class T>
+		constexpr std::size_t transpose_block() {
+			return sizeof(T) > 4 ? 32 : 64;
+		}
+
+		/* Calls fn(r0, r1, c0, c1) for each block x block tile of a rows x cols range */
+		template<class Fn>
+		inline void for_each_tile(const std::size_t& rows, const std::size_t& cols, const std::size_t& block, Fn&& fn) {
+			for (std::size_t c0 = 0; c0 < cols; c0 += block) {
+				std::size_t c1 = (std::min)(cols, c0 + block);
+				for (std::size_t r0 = 0; r0 < rows; r0 += block)
+					fn(r0, (std::min)(rows, r0 + block), c0, c1);
+			}
+		}
+
+		/* dst[ldd * j + k] = src[lds * k + j] over the tile [r0, r1) x [c0, c1) */
+		/* Kernels take sizes by value so that char stores cannot force reloads. */
+		template<class D, class S>
+		inline void transpose_tile_scalar(D* dst, std::size_t ldd, const S* src, std::size_t lds,
+			std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1) {
+			for (std::size_t j = r0; j < r1; ++j)
+				for (std::size_t k = c0; k < c1; ++k)
+					dst[ldd * j + k] = static_cast<D>(src[lds * k + j]);
+		}
+
+#ifdef ORGLAB_DATA_SSE2
+		/* 2 x 2 micro-tiles of 8 byte elements */
+		template<class D, class S>
+		inline void transpose_tile_sse2_8(D* dst, std::size_t ldd, const S* src, std::size_t lds,
+			std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1) {
+			std::size_t j = r0;
+			for (; j + 2 <= r1; j += 2) {
+				std::size_t k = c0;
+				for (; k + 2 <= c1; k += 2) {
+					__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + lds * k + j));
+					__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + lds * (k + 1) + j));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + ldd * j + k), _mm_unpacklo_epi64(a0, a1));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + ldd * (j + 1) + k), _mm_unpackhi_epi64(a0, a1));
+				}
+				transpose_tile_scalar(dst, ldd, src, lds, j, j + 2, k, c1);
+			}
+			transpose_tile_scalar(dst, ldd, src, lds, j, r1, c0, c1);
+		}
+
+		/* 4 x 4 micro-tiles of 4 byte elements */
+		template<class D, class S>
+		inline void transpose_tile_sse2_4(D* dst, std::size_t ldd, const S* src, std::size_t lds,
+			std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1) {
+			std::size_t j = r0;
+			for (; j + 4 <= r1; j += 4) {
+				std::size_t k = c0;
+				for (; k + 4 <= c1; k += 4) {
+					__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + lds * k + j));
+					__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + lds * (k + 1) + j));
+					__m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + lds * (k + 2) + j));
+					__m128i a3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + lds * (k + 3) + j));
+					__m128i t0 = _mm_unpacklo_epi32(a0, a1); // a0[0] a1[0] a0[1] a1[1]
+					__m128i t1 = _mm_unpacklo_epi32(a2, a3);
+					__m128i t2 = _mm_unpackhi_epi32(a0, a1); // a0[2] a1[2] a0[3] a1[3]
+					__m128i t3 = _mm_unpackhi_epi32(a2, a3);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + ldd * j + k), _mm_unpacklo_epi64(t0, t1));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + ldd * (j + 1) + k), _mm_unpackhi_epi64(t0, t1));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + ldd * (j + 2) + k), _mm_unpacklo_epi64(t2, t3));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + ldd * (j + 3) + k), _mm_unpackhi_epi64(t2, t3));
+				}
+				transpose_tile_scalar(dst, ldd, src, lds, j, j + 4, k, c1);
+			}
+			transpose_tile_scalar(dst, ldd, src, lds, j, r1, c0, c1);
+		}
+
+		/* 8 x 8 micro-tiles of 2 byte elements */
+		template<class D, class S>
+		inline void transpose_tile_sse2_2(D* dst, std::size_t ldd, const S* src, std::size_t lds,
+			std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1) {
+			std::size_t j = r0;
+			for (; j + 8 <= r1; j += 8) {
+				std::size_t k = c0;
+				for (; k + 8 <= c1; k += 8) {
+					__m128i a[8], t[8];
+					for (int i = 0; i < 8; ++i)
+						a[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + lds * (k + i) + j));
+					for (int i = 0; i < 8; i += 2) {
+						t[i / 2] = _mm_unpacklo_epi16(a[i], a[i + 1]);
+						t[i / 2 + 4] = _mm_unpackhi_epi16(a[i], a[i + 1]);
+					}
+					for (int i = 0; i < 8; i += 4) { // Pairs (0,1),(2,3) then (4,5),(6,7) of t.
+						a[i / 2] = _mm_unpacklo_epi32(t[i], t[i + 1]);
+						a[i / 2 + 1] = _mm_unpackhi_epi32(t[i], t[i + 1]);
+						a[i / 2 + 4] = _mm_unpacklo_epi32(t[i + 2], t[i + 3]);
+						a[i / 2 + 5] = _mm_unpackhi_epi32(t[i + 2], t[i + 3]);
+					}
+					for (int i = 0; i < 4; ++i) {
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + ldd * (j + 2 * i) + k), _mm_unpacklo_epi64(a[i], a[i + 4]));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + ldd * (j + 2 * i + 1) + k), _mm_unpackhi_epi64(a[i], a[i + 4]));
+					}
+				}
+				transpose_tile_scalar(dst, ldd, src, lds, j, j + 8, k, c1);
+			}
+			transpose_tile_scalar(dst, ldd, src, lds, j, r1, c0, c1);
+		}
+#endif /* ORGLAB_DATA_SSE2 */
+
+#ifdef ORGLAB_DATA_AVX2
+		/* 4 x 4 micro-tiles of 8 byte elements */
+		template<class D, class S>
+		ORGLAB_DATA_TARGET_AVX2
+		inline void transpose_tile_avx2_8(D* dst, std::size_t ldd, const S* src, std::size_t lds,
+			std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1) {
+			std::size_t j = r0;
+			for (; j + 4 <= r1; j += 4) {
+				std::size_t k = c0;
+				for (; k + 4 <= c1; k += 4) {
+					__m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + lds * k + j));
+					__m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + lds * (k + 1) + j));
+					__m256i a2 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + lds * (k + 2) + j));
+					__m256i a3 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + lds * (k + 3) + j));
+					__m256i t0 = _mm256_unpacklo_epi64(a0, a1); // a0[0] a1[0] a0[2] a1[2]
+					__m256i t1 = _mm256_unpackhi_epi64(a0, a1); // a0[1] a1[1] a0[3] a1[3]
+					__m256i t2 = _mm256_unpacklo_epi64(a2, a3);
+					__m256i t3 = _mm256_unpackhi_epi64(a2, a3);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + ldd * j + k), _mm256_permute2x128_si256(t0, t2, 0x20));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + ldd * (j + 1) + k), _mm256_permute2x128_si256(t1, t3, 0x20));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + ldd * (j + 2) + k), _mm256_permute2x128_si256(t0, t2, 0x31));
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + ldd * (j + 3) + k), _mm256_permute2x128_si256(t1, t3, 0x31));
+				}
+				transpose_tile_scalar(dst, ldd, src, lds, j, j + 4, k, c1);
+			}
+			transpose_tile_scalar(dst, ldd, src, lds, j, r1, c0, c1);
+		}
+#endif /* ORGLAB_DATA_AVX2 */
+
+		template<class D, class S, std::size_t N>
+		inline void transpose_tile(D* dst, std::size_t ldd, const S* src, std::size_t lds,
+			std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1, simd_level, std::integral_constant<std::size_t, N>) {
+			transpose_tile_scalar(dst, ldd, src, lds, r0, r1, c0, c1);
+		}
+
+		template<class D, class S>
+		inline void transpose_tile(D* dst, std::size_t ldd, const S* src, std::size_t lds,
+			std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1, simd_level level, std::integral_constant<std::size_t, 8>) {
+			switch (level) {
+#ifdef ORGLAB_DATA_AVX2
+			case simd_level::avx2: transpose_tile_avx2_8(dst, ldd, src, lds, r0, r1, c0, c1); break;
+#endif
+#ifdef ORGLAB_DATA_SSE2
+			case simd_level::sse2: transpose_tile_sse2_8(dst, ldd, src, lds, r0, r1, c0, c1); break;
+#endif
+			default: transpose_tile_scalar(dst, ldd, src, lds, r0, r1, c0, c1); break;
+			}
+		}
+
+		template<class D, class S>
+		inline void transpose_tile(D* dst, std::size_t ldd, const S* src, std::size_t lds,
+			std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1, simd_level level, std::integral_constant<std::size_t, 4>) {
+#ifdef ORGLAB_DATA_SSE2
+			if (simd_level::scalar != level)
+				return transpose_tile_sse2_4(dst, ldd, src, lds, r0, r1, c0, c1);
+#endif
+			transpose_tile_scalar(dst, ldd, src, lds, r0, r1, c0, c1);
+		}
+
+		template<class D, class S>
+		inline void transpose_tile(D* dst, std::size_t ldd, const S* src, std::size_t lds,
+			std::size_t r0, std::size_t r1, std::size_t c0, std::size_t c1, simd_level level, std::integral_constant<std::size_t, 2>) {
+#ifdef ORGLAB_DATA_SSE2
+			if (simd_level::scalar != level)
+				return transpose_tile_sse2_2(dst, ldd, src, lds, r0, r1, c0, c1);
+#endif
+			transpose_tile_scalar(dst, ldd, src, lds, r0, r1, c0, c1);
+		}
+
+		/* Transposes rows x cols column major src (leading dimension lds) into row major */
+		/* dst (leading dimension ldd), i.e. dst[ldd * j + k] = src[lds * k + j]. */
+		/* Reading a row major matrix as column major makes the same call a transpose */
+		/* in the other direction. src and dst must not overlap. */
+		template<class D, class S>
+		inline void transpose(D* dst, const std::size_t& ldd, const S* src, const std::size_t& lds, const std::size_t& rows, const std::size_t& cols) {
+			using unit = std::integral_constant<std::size_t, is_bitwise_transposable<D, S>::value ? sizeof(D) : 0>;
+			simd_level level = get_simd_level();
+			// Measured: once 8 byte matrices outgrow L2, the micro-kernels' cache line split loads and
+			// stores cost more than they save and plain tiles (auto-vectorized) are faster.
+			if (8 == unit::value && rows * cols * sizeof(D) > 128 * 1024)
+				level = simd_level::scalar;
+			for_each_tile(rows, cols, transpose_block<D>(), [&](const std::size_t& r0, const std::size_t& r1, const std::size_t& c0, const std::size_t& c1) {
+				transpose_tile(dst, ldd, src, lds, r0, r1, c0, c1, level, unit());
+			});
+		}
+
+		/* In-place transposes. Column major rows x cols a becomes column major cols x rows. */
+		/* Extra memory is a few fixed size buffers on the stack, plus one bit per row or */
+		/* column on the heap past 65536 rows or columns. */
+
+		/* Visited flags for cycle following over up to 65536 rows (8 KiB) */
+		using transpose_marks = std::uint64_t[1024];
+		constexpr std::size_t transpose_marks_max = 1024 * 64;
+
+		/* Stack scratch for tiles and small matrices */
+		constexpr std::size_t transpose_scratch_bytes = 16 * 1024;
+
+		/* Square matrices: transposes tile pairs (I, J) and (J, I) through a stack buffer */
+		template<class T>
+		inline void transpose_square_in_place(T* a, std::size_t n) {
+			const std::size_t block = transpose_block<T>();
+			if (!std::is_trivially_copyable<T>::value || block * block * sizeof(T) > transpose_scratch_bytes) {
+				for (std::size_t c0 = 0; c0 < n; c0 += block) {
+					std::size_t c1 = (std::min)(n, c0 + block);
+					for (std::size_t r0 = c0; r0 < n; r0 += block) {
+						std::size_t r1 = (std::min)(n, r0 + block);
+						for (std::size_t k = c0; k < c1; ++k)
+							for (std::size_t j = (r0 == c0 ? k + 1 : r0); j < r1; ++j)
+								std::swap(a[n * k + j], a[n * j + k]);
+					}
+				}
+				return;
+			}
+			using unit = std::integral_constant<std::size_t, is_bitwise_transposable<T, T>::value ? sizeof(T) : 0>;
+			simd_level level = get_simd_level();
+			alignas(64) unsigned char scratch[transpose_scratch_bytes];
+			T* buf = reinterpret_cast<T*>(scratch);
+			for (std::size_t c0 = 0; c0 < n; c0 += block) {
+				std::size_t w = (std::min)(n, c0 + block) - c0;
+				for (std::size_t r0 = c0; r0 < n; r0 += block) {
+					std::size_t h = (std::min)(n, r0 + block) - r0;
+					for (std::size_t k = 0; k < w; ++k) // Tile (r0, c0) to buf.
+						memcpy(buf + h * k, a + n * (c0 + k) + r0, h * sizeof(T));
+					if (r0 != c0) // Mirror tile (c0, r0) to tile (r0, c0).
+						transpose_tile(a + n * c0 + r0, n, a + n * r0 + c0, n, 0, w, 0, h, level, unit());
+					transpose_tile(a + n * r0 + c0, n, buf, h, 0, h, 0, w, level, unit());
+				}
+			}
+		}
+
+		/* x / d and x % d for a fixed d and x < 2^32 without a hardware divide */
+		class small_divisor {
+			std::size_t d_;
+			double inv_;
+		public:
+			explicit small_divisor(std::size_t d) : d_(d), inv_(1.0 / static_cast<double>(d)) {}
+			inline std::size_t div(std::size_t x) const {
+				std::size_t q = static_cast<std::size_t>(static_cast<double>(x) * inv_);
+				if (q * d_ > x)
+					--q; // Off by at most one.
+				else if (x - q * d_ >= d_)
+					++q;
+				return q;
+			}
+			inline std::size_t mod(std::size_t x) const {
+				return x - div(x) * d_;
+			}
+		};
+
+		/* Rotates up by s the m rows of a, ld elements apart, over their first w elements. */
+		/* New row i takes row (i + s) % m. Whole row segments move along gcd(m, s) cycles. */
+		template<class T>
+		inline void rotate_rows_up(T* a, std::ptrdiff_t ld, std::size_t m, std::size_t w, std::size_t s, T* tmp) {
+			s %= m;
+			if (0 == s)
+				return;
+			std::size_t g = m, t = s;
+			while (t) { std::size_t u = g % t; g = t; t = u; }
+			for (std::size_t start = 0; start < g; ++start) {
+				std::move(a + ld * start, a + ld * start + w, tmp);
+				std::size_t cur = start;
+				for (std::size_t next = start + s; next != start; cur = next, next = (next + s) % m)
+					std::move(a + ld * next, a + ld * next + w, a + ld * cur);
+				std::move(tmp, tmp + w, a + ld * cur);
+			}
+		}
+
+		/* Rotates element k of the m rows of a, ld elements apart, up by r(k) < width rows */
+		/* for k in [0, w), so new a[i][k] = a[(i + r(k)) % m][k]. wrap holds the first rows. */
+		template<class T, std::size_t width, class R>
+		inline void skew_rows_up(T* a, std::ptrdiff_t ld, std::size_t m, std::size_t w, R r, T (&wrap)[width][width]) {
+			std::size_t saved = (std::min)(m, width), shift[width];
+			for (std::size_t k = 0; k < w; ++k)
+				shift[k] = r(k) % m;
+			for (std::size_t i = 0; i < saved; ++i)
+				for (std::size_t k = 0; k < w; ++k)
+					if (shift[k])
+						wrap[i][k] = std::move(a[ld * i + k]);
+			auto edge_row = [&](std::size_t i) { // Rows below i are untouched, rows above are in wrap.
+				for (std::size_t k = 0; k < w; ++k) {
+					if (0 == shift[k])
+						continue;
+					std::size_t from = i + shift[k] < m ? i + shift[k] : i + shift[k] - m;
+					a[ld * i + k] = std::move(from < saved ? wrap[from][k] : a[ld * from + k]);
+				}
+			};
+			std::size_t i = 0;
+			for (; i < m && (i < saved || i + width > m); ++i)
+				edge_row(i);
+			for (; i + width <= m; ++i) { // Neither reads wrap nor wraps around.
+				T* row = a + ld * i;
+				for (std::size_t k = 0; k < w; ++k)
+					if (shift[k])
+						row[k] = std::move(row[ld * static_cast<std::ptrdiff_t>(shift[k]) + k]);
+			}
+			for (; i < m; ++i)
+				edge_row(i);
+		}
+
+		/* Rectangular matrices, seen as row major m x n (m = cols, n = rows). Decomposes the */
+		/* transpose into shuffles within rows, column rotations and a permutation of whole */
+		/* rows, after Catanzaro, Keller and Garland, "A Decomposition for In-place Matrix */
+		/* Transposition" (2014). Element (i, j) ends up at linear position j * m + i. */
+		/* Column rotations run on blocks of 16 columns so that rows are touched in segments. */
+		template<class T>
+		inline void transpose_rect_in_place(T* a, std::size_t m, std::size_t n) {
+			std::size_t c = m, r = n;
+			while (r) { std::size_t t = c % r; c = r; r = t; } // gcd(m, n)
+			const std::size_t b = n / c;
+			constexpr std::size_t width = transpose_block<T>();
+			const std::ptrdiff_t ld = static_cast<std::ptrdiff_t>(n);
+			T tmp[width], wrap[width][width];
+			transpose_marks marks;
+			std::vector<std::uint64_t> heap_marks; // Only past transpose_marks_max, at max(m, n) / 8 bytes.
+			std::uint64_t* seen = marks;
+			if ((std::max)(m, n) > transpose_marks_max) {
+				heap_marks.resize(((std::max)(m, n) + 63) / 64);
+				seen = heap_marks.data();
+			}
+			// 1. Rotate column j down by j / b rows so each row holds one element bound for each
+			// destination column. Rotating down is rotating up with the row order reversed.
+			if (c > 1) {
+				for (std::size_t j0 = 0; j0 < n; j0 += width) {
+					std::size_t w = (std::min)(n, j0 + width) - j0, q0 = j0 / b;
+					T* last = a + n * (m - 1) + j0;
+					rotate_rows_up(last, -ld, m, w, q0, tmp);
+					skew_rows_up(last, -ld, m, w, [&](std::size_t k) { return (j0 + k) / b - q0; }, wrap);
+				}
+			}
+			// 2. Within each row, move element j to column (j * m + (i - j / b) % m) % n. Rows that
+			// fit the stack buffer are scattered into it in order, others follow cycles.
+			small_divisor by_b(b), by_n(n);
+			alignas(64) unsigned char scratch[transpose_scratch_bytes];
+			const bool buffered = std::is_trivially_copyable<T>::value && n * sizeof(T) <= sizeof(scratch);
+			for (std::size_t i = 0; i < m && buffered; ++i) {
+				T* row = a + n * i;
+				T* buf = reinterpret_cast<T*>(scratch);
+				std::size_t jm = 0, step = m % n; // j * m % n
+				for (std::size_t q = 0, j = 0; q < c; ++q) {
+					std::size_t src_row = i >= q ? i - q : i + m - q;
+					for (std::size_t e = 0; e < b; ++e, ++j) {
+						std::size_t dest = jm + src_row % n;
+						buf[dest < n ? dest : dest - n] = row[j];
+						jm += step;
+						if (jm >= n)
+							jm -= n;
+					}
+				}
+				memcpy(row, buf, n * sizeof(T));
+			}
+			for (std::size_t i = 0; i < m && !buffered; ++i) {
+				T* row = a + n * i;
+				std::fill(seen, seen + (n + 63) / 64, std::uint64_t(0));
+				for (std::size_t j = 0; j < n; ++j) {
+					if (seen[j / 64] & (std::uint64_t(1) << (j % 64)))
+						continue;
+					T carry = std::move(row[j]);
+					std::size_t cur = j;
+					do {
+						std::size_t src_row = i + m - by_b.div(cur); // j / b < c <= m
+						cur = by_n.mod(cur * m + (src_row < m ? src_row : src_row - m));
+						seen[cur / 64] |= std::uint64_t(1) << (cur % 64);
+						std::swap(carry, row[cur]);
+					} while (cur != j);
+				}
+			}
+			// 3. Rotate column f up by f rows.
+			for (std::size_t f0 = 0; f0 < n; f0 += width) {
+				std::size_t w = (std::min)(n, f0 + width) - f0;
+				rotate_rows_up(a + f0, ld, m, w, f0, tmp);
+				skew_rows_up(a + f0, ld, m, w, [](std::size_t k) { return k; }, wrap);
+			}
+			// 4. Row r takes row (r * n % m + r * n / m / b) % m. Whole rows move along cycles.
+			std::fill(seen, seen + (m + 63) / 64, std::uint64_t(0));
+			for (std::size_t x = 0; x < m; ++x) {
+				if (seen[x / 64] & (std::uint64_t(1) << (x % 64)))
+					continue;
+				seen[x / 64] |= std::uint64_t(1) << (x % 64);
+				for (std::size_t cur = x;;) {
+					std::size_t from = (cur * n % m + cur * n / m / b) % m;
+					if (from == x)
+						break;
+					std::swap_ranges(a + n * cur, a + n * (cur + 1), a + n * from);
+					seen[from / 64] |= std::uint64_t(1) << (from % 64);
+					cur = from;
+				}
+			}
+		}
+
+		/* Transposes column major rows x cols a in place. Small matrices go through a stack */
+		/* buffer and the tiled engine, which measured faster than the decomposition at every */
+		/* size that fits. */
+		template<class T>
+		inline void transpose_in_place(T* a, std::size_t rows, std::size_t cols) {
+			if (rows < 2 || cols < 2)
+				return; // Same layout either way.
+			if (rows == cols)
+				return transpose_square_in_place(a, rows);
+			if (std::is_trivially_copyable<T>::value && rows * cols * sizeof(T) <= transpose_scratch_bytes) {
+				alignas(64) unsigned char scratch[transpose_scratch_bytes];
+				memcpy(scratch, a, rows * cols * sizeof(T));
+				return transpose(a, cols, reinterpret_cast<const T*>(scratch), rows, rows, cols);
+			}
+			transpose_rect_in_place(a, cols, rows);
+		}
+
+		/* Storage order of a matrix in memory */
+		enum class storage_order { col_major, row_major };
+
 		/* Simple 2D C++ "matrix" class */
 		/* Meant to make it easier to interact with MatrixObjectPtr */
-		template<class T>
+		/* Column major unless O is row_major, which matches how matrices are set */
+		template<class T, storage_order O = storage_order::col_major>
 		class matrix_adapter {
 		protected:
-			unsigned short rows_, cols_;
+			std::size_t rows_, cols_;
 			T fill_;
 			std::vector<T> vec_;
+			std::size_t tile_ = 0; // Dirty tile edge, a power of 2. 0 when not tracking.
+			unsigned tile_shift_ = 0;
+			std::vector<std::uint64_t> dirty_; // One bit per tile, row major.
+
+			/* Returns number of tiles covering n elements */
+			inline std::size_t tiles(const std::size_t& n) const {
+				return (n + tile_ - 1) >> tile_shift_;
+			}
+
+			/* Tests bit of tile t */
+			inline bool test_tile(const std::size_t& t) const {
+				return 0 != (dirty_[t >> 6] & (std::uint64_t(1) << (t & 63)));
+			}
+
+			/* Marks all tiles when tracking, sizing the bitmap to the dimensions */
+			void mark_all() {
+				if (0 == tile_)
+					return;
+				std::size_t n = tiles(rows_) * tiles(cols_);
+				dirty_.assign((n + 63) >> 6, ~std::uint64_t(0));
+				if (n & 63)
+					dirty_.back() = (std::uint64_t(1) << (n & 63)) - 1;
+			}
 		public:
 			/* Constructor */
 			explicit matrix_adapter(const T& fill = T()) : rows_(0), cols_(0), fill_(fill) {}
 
 			/* Constructor */
-			explicit matrix_adapter(const unsigned short& rows, const unsigned short& cols, const T& fill = T()) :
+			explicit matrix_adapter(const std::size_t& rows, const std::size_t& cols, const T& fill = T()) :
 				rows_(rows), cols_(cols), fill_(fill) {
-				long sz = (long)(rows_ * cols_); // Avoids possible arith overflow per VS code analysis.
+				std::size_t sz = rows_ * cols_;
 				vec_.resize(sz);
 				std::fill(vec_.begin(), vec_.end(), fill_);
 			}
 
 			/* Constructor assigns raw array copying data */
-			explicit matrix_adapter(T* data, const unsigned short& rows, const unsigned short& cols)
+			explicit matrix_adapter(T* data, const std::size_t& rows, const std::size_t& cols)
 				: rows_(rows), cols_(cols) {
-				long sz = (long)(rows_ * cols_);
+				std::size_t sz = rows_ * cols_;
 				vec_.assign(data, data + sz);
 			}
 
 			~matrix_adapter() {}
 
 			matrix_adapter(const matrix_adapter& other) : rows_(other.rows_),
-				cols_(other.cols_), fill_(other.fill_), vec_(other.vec_) {}
+				cols_(other.cols_), fill_(other.fill_), vec_(other.vec_),
+				tile_(other.tile_), tile_shift_(other.tile_shift_), dirty_(other.dirty_) {}
 			matrix_adapter(matrix_adapter&& other) noexcept : rows_(std::exchange(other.rows_, 0)),
 				cols_(std::exchange(other.cols_, 0)), fill_(std::exchange(other.fill_, T())),
-				vec_(std::move(other.vec_)) {}
+				vec_(std::move(other.vec_)), tile_(std::exchange(other.tile_, 0)),
+				tile_shift_(std::exchange(other.tile_shift_, 0)), dirty_(std::move(other.dirty_)) {}
 			matrix_adapter& operator=(const matrix_adapter& other) noexcept {
 				if (this != &other) {
 					rows_ = other.rows_;
 					cols_ = other.cols_;
 					fill_ = other.fill_;
 					vec_ = other.vec_;
+					tile_ = other.tile_;
+					tile_shift_ = other.tile_shift_;
+					dirty_ = other.dirty_;
 				}
 				return *this;
 			}
@@ -100,31 +661,49 @@ namespace orglab_data {
 					cols_ = std::exchange(other.cols_, 0);
 					fill_ = std::exchange(other.fill_, T());
 					vec_ = std::move(other.vec_);
+					tile_ = std::exchange(other.tile_, 0);
+					tile_shift_ = std::exchange(other.tile_shift_, 0);
+					dirty_ = std::move(other.dirty_);
 				}
 				return *this;
 			}
 
+			/* Storage order */
+			static constexpr storage_order order = O;
+
 			/* Assignment operator. Returns reference for given row and column */
-			inline T& operator() (const unsigned short& row, const unsigned short& col) {
+			/* Marks its tile dirty when tracking. */
+			inline T& operator() (const std::size_t& row, const std::size_t& col) {
 				assert(row < rows_ && col < cols_);
-				long idx = (long)(rows_ * col + row); // Avoids possible arith overflow per VS code analysis.
-				return vec_[idx];
+				if (tile_) {
+					std::size_t t = (row >> tile_shift_) * tiles(cols_) + (col >> tile_shift_);
+					dirty_[t >> 6] |= std::uint64_t(1) << (t & 63);
+				}
+				return vec_[index(row, col)];
 			}
 
 			/* Read operator. Returns value for given row and column */
-			inline T operator() (const unsigned short& row, const unsigned short& col) const {
+			inline T operator() (const std::size_t& row, const std::size_t& col) const {
 				assert(row < rows_ && col < cols_);
-				long idx = (long)(rows_ * col + row); // Avoids possible arith overflow per VS code analysis.
-				return vec_[idx];
+				return vec_[index(row, col)];
+			}
+
+			/* Returns position of given row and column in internal storage */
+			inline std::size_t index(const std::size_t& row, const std::size_t& col) const {
+				if constexpr (storage_order::col_major == O)
+					return rows_ * col + row;
+				else
+					return cols_ * row + col;
 			}
 
 			/* Assigns raw array to matrix adapter */
-			matrix_adapter& assign(T* data, const unsigned short& rows, const unsigned short& cols) {
+			matrix_adapter& assign(T* data, const std::size_t& rows, const std::size_t& cols) {
 				rows_ = rows;
 				cols_ = cols;
-				long sz = (long)(rows_ * cols_); // Avoids possible arith overflow per VS code analysis.
+				std::size_t sz = rows_ * cols_;
 				vec_.assign(data, data + sz);
 				vec_.shrink_to_fit();
+				mark_all();
 				return *this;
 			}
 
@@ -135,19 +714,20 @@ namespace orglab_data {
 
 			/* Returns raw non-const (editable) array of internal storage */
 			/* Useful when third-party library like Armadillo or Eigen assumes */
-			/* control of the internal storage. */
+			/* control of the internal storage. Writes through it are not tracked, */
+			/* see mark_dirty. */
 			// Must not modify size of returned array */
 			T* data() {
 				return vec_.data();
 			}
 
 			/* Returns number of rows */
-			inline unsigned short rows() const {
+			inline std::size_t rows() const {
 				return rows_;
 			}
 
 			/* Returns number of columns */
-			inline unsigned short cols() const {
+			inline std::size_t cols() const {
 				return cols_;
 			}
 
@@ -155,19 +735,21 @@ namespace orglab_data {
 			/* Useful only when third-party library like Armadillo or Eigen assumes */
 			/* control of the internal storage and has changed the shape of */
 			/* storage. */
-			matrix_adapter& rows(const unsigned short& rows) {
+			matrix_adapter& rows(const std::size_t& rows) {
+				std::size_t n = rows_ * cols_;
 				if (0 == rows) {
-					cols_ = rows_ * cols_;
+					cols_ = n;
 					rows_ = 0;
 				}
-				else if (rows > rows_ * cols_) {
-					rows_ = rows_ * cols_;
-					cols_ == 0;
+				else if (rows > n) {
+					rows_ = n;
+					cols_ = 0;
 				}
 				else {
 					rows_ = rows;
-					cols_ = (rows_ * cols_) / rows_;
+					cols_ = n / rows_;
 				}
+				mark_all();
 				return *this;
 			}
 
@@ -175,19 +757,21 @@ namespace orglab_data {
 			/* Useful only when third-party library like Armadillo or Eigen assumes */
 			/* control of the internal storage and has changed the shape of */
 			/* storage. */
-			matrix_adapter& cols(const unsigned short& cols) {
+			matrix_adapter& cols(const std::size_t& cols) {
+				std::size_t n = rows_ * cols_;
 				if (0 == cols) {
-					rows_ = rows_ * cols_;
+					rows_ = n;
 					cols_ = 0;
 				}
-				else if (cols > rows_ * cols_) {
-					cols_ = rows_ * cols_;
-					rows_ == 0;
+				else if (cols > n) {
+					cols_ = n;
+					rows_ = 0;
 				}
 				else {
 					cols_ = cols;
-					rows_ = (rows_ * cols_) / cols_;
+					rows_ = n / cols_;
 				}
+				mark_all();
 				return *this;
 			}
 
@@ -197,12 +781,25 @@ namespace orglab_data {
 			}
 
 			/* Changes dimensions of matrix adapter clearing data */
-			matrix_adapter& resize(const unsigned short& rows, const unsigned short& cols) {
+			matrix_adapter& resize(const std::size_t& rows, const std::size_t& cols) {
 				rows_ = rows;
 				cols_ = cols;
-				long sz = (long)(rows * cols); // Avoids possible arith overflow per VS code analysis.
+				std::size_t sz = rows * cols;
 				std::vector<T>(sz).swap(vec_);
 				std::fill(vec_.begin(), vec_.end(), fill_);
+				mark_all();
+				return *this;
+			}
+
+			/* Changes dimensions of matrix adapter keeping its allocated storage */
+			/* Contents are unspecified afterwards. Meant for overwriting in full, */
+			/* e.g. when re-reading a matrix of the same size. */
+			matrix_adapter& resize_for_overwrite(const std::size_t& rows, const std::size_t& cols) {
+				rows_ = rows;
+				cols_ = cols;
+				std::size_t sz = rows * cols;
+				vec_.resize(sz, fill_);
+				mark_all();
 				return *this;
 			}
 
@@ -212,52 +809,138 @@ namespace orglab_data {
 				cols_ = 0;
 				std::vector<T>().swap(vec_);
 				vec_.shrink_to_fit();
+				mark_all();
 				return *this;
 			}
 
 			/* Transposes and returns copy of matrix adapter */
-			template <class T>
+			template <class U = T>
 			matrix_adapter transpose() const {
 				if (0 == vec_.size())
-					return matrix_adapter<T>();
-				// Clockwise rotation + horizontal flip.
-				std::vector<T> v(vec_.size());
-				long idx1 = 0, idx2 = 0;
-				for (unsigned short row = 0; row < rows_; ++row) {
-					for (unsigned short col = 0; col < cols_; ++col) {
-						idx1 = (long)(cols_ * row + col);
-						idx2 = (long)(rows_ * col + row);
-						v[idx1] = vec_[idx2];
-					}
-				}
-				return matrix_adapter<T>(v.data(), cols_, rows_); // Reverse.
+					return matrix_adapter();
+				// Clockwise rotation + horizontal flip. Row major storage is the column major
+				// transpose, so it transposes with rows and columns swapped.
+				matrix_adapter t(cols_, rows_, fill_); // Reverse.
+				if constexpr (storage_order::col_major == O)
+					impl::transpose(t.data(), cols_, vec_.data(), rows_, rows_, cols_);
+				else
+					impl::transpose(t.data(), rows_, vec_.data(), cols_, cols_, rows_);
+				return t;
 			}
 
 			/* Transposes matrix adapter in place */
 			matrix_adapter& transpose_self() {
 				if (0 == vec_.size())
 					return *this;
-				// Clockwise rotation + horizontal flip.
-				std::vector<T> v(vec_);
-				long idx1 = 0, idx2 = 0;
-				for (unsigned short row = 0; row < rows_; ++row) {
-					for (unsigned short col = 0; col < cols_; ++col) {
-						idx1 = (long)(cols_ * row + col);
-						idx2 = (long)(rows_ * col + row);
-						vec_[idx1] = v[idx2];
-					}
-				}
-				unsigned short r = rows_;
+				// Clockwise rotation + horizontal flip, without a copy of the matrix.
+				if constexpr (storage_order::col_major == O)
+					impl::transpose_in_place(vec_.data(), rows_, cols_);
+				else
+					impl::transpose_in_place(vec_.data(), cols_, rows_);
+				std::size_t r = rows_;
 				rows_ = cols_;
 				cols_ = r;
+				mark_all();
+				return *this;
+			}
+
+			/* Tracks changes in tiles of tile x tile elements, tile rounded up to a power */
+			/* of 2, for sync_matrix_data. Everything starts dirty. 0 stops tracking. */
+			matrix_adapter& track_dirty(const std::size_t& tile = 64) {
+				tile_ = 0;
+				tile_shift_ = 0;
+				dirty_.clear();
+				if (0 == tile)
+					return *this;
+				while ((std::size_t(1) << tile_shift_) < tile)
+					++tile_shift_;
+				tile_ = std::size_t(1) << tile_shift_;
+				mark_all();
+				return *this;
+			}
+
+			/* Returns tile edge in elements, 0 if not tracking */
+			inline std::size_t dirty_tile() const {
+				return tile_;
+			}
+
+			/* Marks everything dirty */
+			matrix_adapter& mark_dirty() {
+				mark_all();
+				return *this;
+			}
+
+			/* Marks the rows x cols region at row, col dirty, e.g. after writing through data() */
+			matrix_adapter& mark_dirty(const std::size_t& row, const std::size_t& col, const std::size_t& rows, const std::size_t& cols) {
+				if (0 == tile_ || 0 == rows || 0 == cols)
+					return *this;
+				assert(row + rows <= rows_ && col + cols <= cols_);
+				std::size_t n = tiles(cols_);
+				for (std::size_t tr = row >> tile_shift_; tr <= (row + rows - 1) >> tile_shift_; ++tr)
+					for (std::size_t tc = col >> tile_shift_; tc <= (col + cols - 1) >> tile_shift_; ++tc) {
+						std::size_t t = tr * n + tc;
+						dirty_[t >> 6] |= std::uint64_t(1) << (t & 63);
+					}
+				return *this;
+			}
+
+			/* Marks nothing dirty, e.g. once the matrix object holds the same data */
+			matrix_adapter& clear_dirty() {
+				std::fill(dirty_.begin(), dirty_.end(), std::uint64_t(0));
 				return *this;
 			}
 
+			/* True if anything is marked dirty */
+			bool is_dirty() const {
+				for (const std::uint64_t& w : dirty_)
+					if (w)
+						return true;
+				return false;
+			}
+
+			/* Calls fn(row, col, rows, cols) for each rectangle of a set covering the dirty */
+			/* tiles exactly. Runs of dirty tiles in a tile row merge with the same run in */
+			/* the tile rows below. */
+			template<class Fn>
+			void dirty_regions(Fn fn) const {
+				if (0 == tile_ || !is_dirty())
+					return;
+				struct run { std::size_t c0, c1, r0; };
+				std::size_t tile_rows = tiles(rows_), tile_cols = tiles(cols_);
+				std::vector<run> open, next;
+				auto emit = [&](const run& u, const std::size_t& r1) {
+					std::size_t row = u.r0 << tile_shift_, col = u.c0 << tile_shift_;
+					fn(row, col, (std::min)(rows_, r1 << tile_shift_) - row, (std::min)(cols_, u.c1 << tile_shift_) - col);
+				};
+				for (std::size_t tr = 0; tr <= tile_rows; ++tr) {
+					next.clear();
+					std::size_t k = 0; // Open runs are in column order.
+					for (std::size_t tc = 0; tr < tile_rows && tc < tile_cols;) {
+						if (!test_tile(tr * tile_cols + tc)) {
+							++tc;
+							continue;
+						}
+						std::size_t c0 = tc;
+						while (tc < tile_cols && test_tile(tr * tile_cols + tc))
+							++tc;
+						while (k < open.size() && open[k].c0 < c0)
+							emit(open[k++], tr);
+						if (k < open.size() && open[k].c0 == c0 && open[k].c1 == tc)
+							next.push_back(open[k++]);
+						else
+							next.push_back({ c0, tc, tr });
+					}
+					while (k < open.size())
+						emit(open[k++], tr);
+					open.swap(next);
+				}
+			}
+
 			/* Iterator */
 			using iterator = typename std::vector<T>::iterator;
 			/* Const iterator */
 			using const_iterator = typename std::vector<T>::const_iterator;
-			/* Iterator method */
+			/* Iterator method. Writes through it are not tracked, see mark_dirty. */
 			iterator begin() noexcept { return vec_.begin(); }
 			/* Iterator method */
 			iterator end() noexcept { return vec_.end(); }
@@ -271,14 +954,14 @@ namespace orglab_data {
 		/* Operator << for matrix_adapter */
 		/* Dumps to an output stream the contents of the matrix_adapter object */
 		/* E.g. std::cout << "Matrix:\n" << ma; */
-		template<class T, typename Char, typename Traits>
-		std::basic_ostream<typename Char, typename Traits>& operator<< (std::basic_ostream<typename Char, typename Traits>& out, const matrix_adapter<T>& ma)
+		template<class T, storage_order O, typename Char, typename Traits>
+		std::basic_ostream<Char, Traits>& operator<< (std::basic_ostream<Char, Traits>& out, const matrix_adapter<T, O>& ma)
 		{
-			unsigned short rows = ma.rows(), cols = ma.cols();
+			std::size_t rows = ma.rows(), cols = ma.cols();
 			if (rows * cols < 1)
 				return out;
-			for (unsigned short i = 0; i < rows; ++i) {
-				for (unsigned short j = 0; j < cols; ++j) {
+			for (std::size_t i = 0; i < rows; ++i) {
+				for (std::size_t j = 0; j < cols; ++j) {
 					if ((cols - 1) == j)
 						out << ma(i, j);
 					else
@@ -290,89 +973,502 @@ namespace orglab_data {
 			return out;
 		}
 
-		inline std::string from_wide(const std::wstring& wstr) {
-			if (wstr.empty())
-				return std::string();
-			int len = ::WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), static_cast<int>(wstr.size()), NULL, 0, NULL, NULL);
-			if (len < 1)
-				return std::string();
-			std::string str(len, '\0');
-			if (0 == ::WideCharToMultiByte(CP_UTF8, 0, wstr.c_str(), static_cast<int>(wstr.size()), &str[0], static_cast<int>(str.size()), NULL, NULL))
-				return std::string();
-			return str;
+		/* Non-owning view of a rows x cols matrix in caller memory, e.g. the buffer of an */
+		/* Armadillo or Eigen matrix, that matrix transfers pack from or unpack into directly. */
+		/* stride is the distance in elements between the starts of consecutive columns */
+		/* (col_major) or rows (row_major). 0 means packed. Set from matrix_view<const T>, */
+		/* get into matrix_view<T>. The memory must outlive the transfer. */
+		template<class T>
+		class matrix_view {
+		protected:
+			T* data_;
+			std::size_t rows_, cols_, stride_;
+			storage_order order_;
+		public:
+			/* Constructor */
+			matrix_view() : data_(nullptr), rows_(0), cols_(0), stride_(0), order_(storage_order::col_major) {}
+
+			/* Constructor */
+			matrix_view(T* data, const std::size_t& rows, const std::size_t& cols,
+				const storage_order& order = storage_order::col_major, const std::size_t& stride = 0)
+				: data_(data), rows_(rows), cols_(cols), stride_(stride), order_(order) {
+				std::size_t packed = storage_order::col_major == order_ ? rows_ : cols_;
+				if (0 == stride_)
+					stride_ = packed;
+				else if (stride_ < packed)
+					throw std::runtime_error("Matrix view stride too small");
+			}
+
+			/* Constructor views a matrix_adapter's storage */
+			template<storage_order O>
+			matrix_view(matrix_adapter<typename std::remove_const<T>::type, O>& ma)
+				: data_(ma.data()), rows_(ma.rows()), cols_(ma.cols()), stride_(storage_order::col_major == O ? ma.rows() : ma.cols()), order_(O) {}
+
+			/* Constructor views a const matrix_adapter's storage, for matrix_view<const T> */
+			template<storage_order O, class U = T, class = typename std::enable_if<std::is_const<U>::value>::type>
+			matrix_view(const matrix_adapter<typename std::remove_const<T>::type, O>& ma)
+				: data_(ma.data()), rows_(ma.rows()), cols_(ma.cols()), stride_(storage_order::col_major == O ? ma.rows() : ma.cols()), order_(O) {}
+
+			/* Constructor converts a matrix_view<U> to matrix_view<const U> */
+			template<class U, class = typename std::enable_if<std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type>
+			matrix_view(const matrix_view<U>& other)
+				: data_(other.data()), rows_(other.rows()), cols_(other.cols()), stride_(other.stride()), order_(other.order()) {}
+
+			/* Returns reference for given row and column */
+			inline T& operator() (const std::size_t& row, const std::size_t& col) const {
+				assert(row < rows_ && col < cols_);
+				return storage_order::col_major == order_ ? data_[stride_ * col + row] : data_[stride_ * row + col];
+			}
+
+			/* Returns view of rows x cols elements starting at row, col */
+			matrix_view block(const std::size_t& row, const std::size_t& col, const std::size_t& rows, const std::size_t& cols) const {
+				assert(row + rows <= rows_ && col + cols <= cols_);
+				T* p = storage_order::col_major == order_ ? data_ + stride_ * col + row : data_ + stride_ * row + col;
+				return matrix_view(p, rows, cols, order_, stride_);
+			}
+
+			/* Returns first element */
+			T* data() const {
+				return data_;
+			}
+
+			/* Returns number of rows */
+			inline std::size_t rows() const {
+				return rows_;
+			}
+
+			/* Returns number of columns */
+			inline std::size_t cols() const {
+				return cols_;
+			}
+
+			/* Returns elements between starts of consecutive columns or rows */
+			inline std::size_t stride() const {
+				return stride_;
+			}
+
+			/* Returns storage order */
+			inline storage_order order() const {
+				return order_;
+			}
+
+			/* Returns number of elements viewed */
+			inline std::size_t size() const {
+				return rows_ * cols_;
+			}
+
+			/* True if elements are contiguous */
+			inline bool is_packed() const {
+				return stride_ == (storage_order::col_major == order_ ? rows_ : cols_);
+			}
+		};
+
+		//// UTF-8 TRANSCODING ////
+		// std::string data is UTF-8 and BSTR cells are wchar_t: UTF-16 on Windows, UTF-32 elsewhere
+		// (orglab_data_fake.hpp). Runs of ASCII are widened or narrowed 16 characters at a time with
+		// SSE2 and the rest one code point at a time. Invalid input becomes U+FFFD, like
+		// MultiByteToWideChar and WideCharToMultiByte with CP_UTF8.
+
+		/* Decodes one UTF-8 sequence at s whose lead byte is not ASCII. Returns bytes used. An */
+		/* invalid sequence gives U+FFFD and uses its longest valid prefix, at least one byte. */
+		inline std::size_t decode_utf8(const unsigned char* s, const std::size_t& n, char32_t& cp) {
+			unsigned char c = s[0];
+			std::size_t len = 0;
+			if (c >= 0xC2 && c <= 0xDF) { len = 2; cp = c & 0x1F; }
+			else if (c >= 0xE0 && c <= 0xEF) { len = 3; cp = c & 0x0F; }
+			else if (c >= 0xF0 && c <= 0xF4) { len = 4; cp = c & 0x07; }
+			else { cp = 0xFFFD; return 1; }
+			for (std::size_t k = 1; k < len; ++k) {
+				unsigned char lo = 0x80, hi = 0xBF;
+				if (1 == k) { // Overlong forms, surrogates and values above U+10FFFF.
+					if (0xE0 == c) lo = 0xA0;
+					else if (0xED == c) hi = 0x9F;
+					else if (0xF0 == c) lo = 0x90;
+					else if (0xF4 == c) hi = 0x8F;
+				}
+				if (k >= n || s[k] < lo || s[k] > hi) {
+					cp = 0xFFFD;
+					return k;
+				}
+				cp = (cp << 6) | (s[k] & 0x3F);
+			}
+			return len;
 		}
 
-		inline std::wstring to_wide(const std::string& str) {
-			if (str.empty())
-				return std::wstring();
-			int len = ::MultiByteToWideChar(CP_UTF8, 0, str.c_str(), static_cast<int>(str.size()), NULL, 0);
-			if (len < 1)
-				return std::wstring();
-			std::wstring wstr(len, '\0');
-			if (0 == ::MultiByteToWideChar(CP_UTF8, 0, str.c_str(), static_cast<int>(str.size()), &wstr[0], static_cast<int>(wstr.size())))
-				return std::wstring();
-			return wstr;
+		/* Decodes one wchar_t code point at s. Returns units used. Lone surrogates give U+FFFD. */
+		inline std::size_t decode_wide(const wchar_t* s, const std::size_t& n, char32_t& cp) {
+			cp = static_cast<char32_t>(s[0]);
+			if (sizeof(wchar_t) == 2) {
+				cp &= 0xFFFF;
+				if (cp >= 0xD800 && cp <= 0xDBFF && n > 1) {
+					char32_t lo = static_cast<char32_t>(s[1]) & 0xFFFF;
+					if (lo >= 0xDC00 && lo <= 0xDFFF) {
+						cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+						return 2;
+					}
+				}
+			}
+			if ((cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF)
+				cp = 0xFFFD;
+			return 1;
 		}
 
-		inline std::wstring from_bstr(const BSTR& bstr) {
-			return std::wstring(bstr, ::SysStringLen(bstr));
+		inline bool is_ascii(const wchar_t& c) {
+			return static_cast<std::make_unsigned<wchar_t>::type>(c) < 0x80;
 		}
 
-		inline CComBSTR to_ccom_bstr(const std::wstring& wstr) {
-			if (wstr.empty())
-				return CComBSTR();
-			return CComBSTR(static_cast<int>(wstr.size()), wstr.data());
+		inline std::size_t wide_units(const char32_t& cp) {
+			return (sizeof(wchar_t) == 2 && cp >= 0x10000) ? 2 : 1;
 		}
 
-		inline CComBSTR to_ccom_bstr(const std::string& str) {
-			return to_ccom_bstr(to_wide(str));
+		inline std::size_t utf8_units(const char32_t& cp) {
+			return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
 		}
 
-		template <class T, typename std::enable_if<std::is_integral<T>::value>::type * = nullptr>
-		inline long to_non_negative_long(const T& t) {
-			if (t > LONG_MAX)
-				return LONG_MAX;
-			if (t < 0)
-				return 0;
-			return static_cast<long>(t);
+		inline std::size_t encode_wide(wchar_t* dst, const char32_t& cp) {
+			if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+				dst[0] = static_cast<wchar_t>(0xD800 + ((cp - 0x10000) >> 10));
+				dst[1] = static_cast<wchar_t>(0xDC00 + ((cp - 0x10000) & 0x3FF));
+				return 2;
+			}
+			dst[0] = static_cast<wchar_t>(cp);
+			return 1;
 		}
 
-		template <class T>
-		inline unsigned short to_unsigned_short(const T& t) {
-			static const T max_val = static_cast<T>((std::numeric_limits<unsigned short>::max)());
-			static const T min_val = static_cast<T>((std::numeric_limits<unsigned short>::min)());
-			if (t < min_val)
-				return (std::numeric_limits<unsigned short>::min)();
-			if (t > max_val)
-				return (std::numeric_limits<unsigned short>::max)();
-			return static_cast<unsigned short>(t);
+		inline std::size_t encode_utf8(char* dst, const char32_t& cp) {
+			unsigned char* d = reinterpret_cast<unsigned char*>(dst);
+			if (cp < 0x80) {
+				d[0] = static_cast<unsigned char>(cp);
+				return 1;
+			}
+			if (cp < 0x800) {
+				d[0] = static_cast<unsigned char>(0xC0 | (cp >> 6));
+				d[1] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+				return 2;
+			}
+			if (cp < 0x10000) {
+				d[0] = static_cast<unsigned char>(0xE0 | (cp >> 12));
+				d[1] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+				d[2] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+				return 3;
+			}
+			d[0] = static_cast<unsigned char>(0xF0 | (cp >> 18));
+			d[1] = static_cast<unsigned char>(0x80 | ((cp >> 12) & 0x3F));
+			d[2] = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+			d[3] = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+			return 4;
 		}
 
-		using com_compat_info_t = std::pair<COLDATAFORMAT, VARENUM>;
+		/* ASCII run kernels. Each handles whole blocks of 16 characters from the start while */
+		/* they are all ASCII and returns the number handled; the caller does the rest. */
+		inline std::size_t ascii_run_scalar(const char*, const std::size_t&) { return 0; }
+		inline std::size_t ascii_run_scalar(const wchar_t*, const std::size_t&) { return 0; }
+		inline std::size_t widen_ascii_scalar(wchar_t*, const char*, const std::size_t&) { return 0; }
+		inline std::size_t narrow_ascii_scalar(char*, const wchar_t*, const std::size_t&) { return 0; }
 
-		template< class T>
-		inline com_compat_info_t get_com_compat_info(const COLDATAFORMAT& fmt, bool is_matrix = false) {
-			if (COLDATAFORMAT::DF_DATE == fmt || COLDATAFORMAT::DF_TIME == fmt) return com_compat_info_t{ fmt, VT_R8 };
-			if (std::is_same<T, double>::value)						return com_compat_info_t{ is_matrix ? COLDATAFORMAT::DF_DOUBLE : COLDATAFORMAT::DF_TEXT_NUMERIC, VT_R8 };
-			if (std::is_same<T, float>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_FLOAT, VT_R4 };
-			if (std::is_same<T, int>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_LONG, VT_I4 };
-			if (std::is_same<T, long>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_LONG, VT_I4 };
-			if (std::is_same<T, unsigned long>::value)				return com_compat_info_t{ COLDATAFORMAT::DF_ULONG, VT_I4 };
-			if (std::is_same<T, short>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_SHORT, VT_I2 };
-			if (std::is_same<T, unsigned short>::value)				return com_compat_info_t{ COLDATAFORMAT::DF_USHORT, VT_I2 };
-			if (std::is_same<T, std::wstring>::value)				return com_compat_info_t{ COLDATAFORMAT::DF_TEXT_NUMERIC, VT_BSTR };
-			if (std::is_same<T, std::string>::value)				return com_compat_info_t{ COLDATAFORMAT::DF_TEXT_NUMERIC, VT_BSTR };
-			if (std::is_same<T, byte>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_BYTE, VT_I1 };
-			if (std::is_same<T, char>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_CHAR, VT_I1 };
-			if (std::is_same<T, std::complex<double>>::value)		return com_compat_info_t{ COLDATAFORMAT::DF_COMPLEX, VT_R8 };
+#ifdef ORGLAB_DATA_SSE2
+		/* Loads 16 wchar_t as 16 bytes. Lanes that are not ASCII get their high bit set. */
+		inline __m128i load_ascii_wide_sse2(const wchar_t* src) {
+			if (sizeof(wchar_t) == 2) {
+				__m128i a = _mm_loadu_si128((const __m128i*)src);
+				__m128i b = _mm_loadu_si128((const __m128i*)(src + 8));
+				__m128i high = _mm_set1_epi16(static_cast<short>(0xFF80));
+				__m128i zero = _mm_setzero_si128();
+				__m128i bad_a = _mm_xor_si128(_mm_cmpeq_epi16(_mm_and_si128(a, high), zero), _mm_set1_epi32(-1));
+				__m128i bad_b = _mm_xor_si128(_mm_cmpeq_epi16(_mm_and_si128(b, high), zero), _mm_set1_epi32(-1));
+				return _mm_or_si128(_mm_packus_epi16(_mm_and_si128(a, _mm_set1_epi16(0x7F)), _mm_and_si128(b, _mm_set1_epi16(0x7F))), _mm_packs_epi16(bad_a, bad_b));
+			}
+			else {
+				__m128i high = _mm_set1_epi32(static_cast<int>(0xFFFFFF80));
+				__m128i zero = _mm_setzero_si128();
+				__m128i v[4], bad[4];
+				for (int k = 0; k < 4; ++k) {
+					v[k] = _mm_loadu_si128((const __m128i*)(src + 4 * k));
+					bad[k] = _mm_xor_si128(_mm_cmpeq_epi32(_mm_and_si128(v[k], high), zero), _mm_set1_epi32(-1));
+					v[k] = _mm_and_si128(v[k], _mm_set1_epi32(0x7F));
+				}
+				__m128i bytes = _mm_packus_epi16(_mm_packs_epi32(v[0], v[1]), _mm_packs_epi32(v[2], v[3]));
+				__m128i flags = _mm_packs_epi16(_mm_packs_epi32(bad[0], bad[1]), _mm_packs_epi32(bad[2], bad[3]));
+				return _mm_or_si128(bytes, flags);
+			}
+		}
 
-			throw std::exception("Incompatible data types");
+		inline std::size_t ascii_run_sse2(const char* src, const std::size_t& n) {
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(src + i))))
+					break;
+			}
+			return i;
 		}
 
-		template<class T>
-		inline bool is_vector_type_compatible(const COLDATAFORMAT& fmt) {
-			if (std::is_same<T, double>::value&& COLDATAFORMAT::DF_TEXT_NUMERIC == fmt)			return true;
-			if (std::is_same<T, double>::value&& COLDATAFORMAT::DF_DOUBLE == fmt)				return true;
+		inline std::size_t ascii_run_sse2(const wchar_t* src, const std::size_t& n) {
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				if (_mm_movemask_epi8(load_ascii_wide_sse2(src + i)))
+					break;
+			}
+			return i;
+		}
+
+		inline std::size_t widen_ascii_sse2(wchar_t* dst, const char* src, const std::size_t& n) {
+			__m128i zero = _mm_setzero_si128();
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+				if (_mm_movemask_epi8(v))
+					break;
+				__m128i lo = _mm_unpacklo_epi8(v, zero);
+				__m128i hi = _mm_unpackhi_epi8(v, zero);
+				if (sizeof(wchar_t) == 2) {
+					_mm_storeu_si128((__m128i*)(dst + i), lo);
+					_mm_storeu_si128((__m128i*)(dst + i + 8), hi);
+				}
+				else {
+					_mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi16(lo, zero));
+					_mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(lo, zero));
+					_mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpacklo_epi16(hi, zero));
+					_mm_storeu_si128((__m128i*)(dst + i + 12), _mm_unpackhi_epi16(hi, zero));
+				}
+			}
+			return i;
+		}
+
+		inline std::size_t narrow_ascii_sse2(char* dst, const wchar_t* src, const std::size_t& n) {
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m128i v = load_ascii_wide_sse2(src + i);
+				if (_mm_movemask_epi8(v))
+					break;
+				_mm_storeu_si128((__m128i*)(dst + i), v);
+			}
+			return i;
+		}
+#endif /* ORGLAB_DATA_SSE2 */
+
+		inline std::size_t ascii_run(const char* src, const std::size_t& n) {
+#ifdef ORGLAB_DATA_SSE2
+			if (simd_level::scalar != get_simd_level())
+				return ascii_run_sse2(src, n);
+#endif
+			return ascii_run_scalar(src, n);
+		}
+
+		inline std::size_t ascii_run(const wchar_t* src, const std::size_t& n) {
+#ifdef ORGLAB_DATA_SSE2
+			if (simd_level::scalar != get_simd_level())
+				return ascii_run_sse2(src, n);
+#endif
+			return ascii_run_scalar(src, n);
+		}
+
+		inline std::size_t widen_ascii(wchar_t* dst, const char* src, const std::size_t& n) {
+#ifdef ORGLAB_DATA_SSE2
+			if (simd_level::scalar != get_simd_level())
+				return widen_ascii_sse2(dst, src, n);
+#endif
+			return widen_ascii_scalar(dst, src, n);
+		}
+
+		inline std::size_t narrow_ascii(char* dst, const wchar_t* src, const std::size_t& n) {
+#ifdef ORGLAB_DATA_SSE2
+			if (simd_level::scalar != get_simd_level())
+				return narrow_ascii_sse2(dst, src, n);
+#endif
+			return narrow_ascii_scalar(dst, src, n);
+		}
+
+		/* Number of wchar_t that n bytes of UTF-8 at src become */
+		inline std::size_t utf8_to_wide_length(const char* src, const std::size_t& n) {
+			const unsigned char* s = reinterpret_cast<const unsigned char*>(src);
+			std::size_t i = 0, len = 0;
+			while (i < n) {
+				std::size_t run = ascii_run(src + i, n - i);
+				i += run;
+				len += run;
+				for (; i < n && s[i] < 0x80; ++i, ++len) {}
+				while (i < n && s[i] >= 0x80) {
+					char32_t cp;
+					i += decode_utf8(s + i, n - i, cp);
+					len += wide_units(cp);
+				}
+			}
+			return len;
+		}
+
+		/* Transcodes n bytes of UTF-8 at src into dst, which holds utf8_to_wide_length(src, n) */
+		/* wchar_t. Returns number written. */
+		inline std::size_t utf8_to_wide(wchar_t* dst, const char* src, const std::size_t& n) {
+			const unsigned char* s = reinterpret_cast<const unsigned char*>(src);
+			std::size_t i = 0, o = 0;
+			while (i < n) {
+				std::size_t run = widen_ascii(dst + o, src + i, n - i);
+				i += run;
+				o += run;
+				for (; i < n && s[i] < 0x80; ++i)
+					dst[o++] = static_cast<wchar_t>(s[i]);
+				while (i < n && s[i] >= 0x80) {
+					char32_t cp;
+					i += decode_utf8(s + i, n - i, cp);
+					o += encode_wide(dst + o, cp);
+				}
+			}
+			return o;
+		}
+
+		/* Number of UTF-8 bytes that n wchar_t at src become */
+		inline std::size_t wide_to_utf8_length(const wchar_t* src, const std::size_t& n) {
+			std::size_t i = 0, len = 0;
+			while (i < n) {
+				std::size_t run = ascii_run(src + i, n - i);
+				i += run;
+				len += run;
+				for (; i < n && is_ascii(src[i]); ++i, ++len) {}
+				while (i < n && !is_ascii(src[i])) {
+					char32_t cp;
+					i += decode_wide(src + i, n - i, cp);
+					len += utf8_units(cp);
+				}
+			}
+			return len;
+		}
+
+		/* Transcodes n wchar_t at src into dst, which holds wide_to_utf8_length(src, n) bytes. */
+		/* Returns number written. */
+		inline std::size_t wide_to_utf8(char* dst, const wchar_t* src, const std::size_t& n) {
+			std::size_t i = 0, o = 0;
+			while (i < n) {
+				std::size_t run = narrow_ascii(dst + o, src + i, n - i);
+				i += run;
+				o += run;
+				for (; i < n && is_ascii(src[i]); ++i)
+					dst[o++] = static_cast<char>(src[i]);
+				while (i < n && !is_ascii(src[i])) {
+					char32_t cp;
+					i += decode_wide(src + i, n - i, cp);
+					o += encode_utf8(dst + o, cp);
+				}
+			}
+			return o;
+		}
+
+		/* Sets str to n wchar_t at src as UTF-8. Reuses str's capacity. */
+		inline void assign_utf8(std::string& str, const wchar_t* src, const std::size_t& n) {
+			str.resize(wide_to_utf8_length(src, n));
+			if (!str.empty())
+				wide_to_utf8(&str[0], src, n);
+		}
+
+		/* Sets wstr to n bytes of UTF-8 at src. Reuses wstr's capacity. */
+		inline void assign_wide(std::wstring& wstr, const char* src, const std::size_t& n) {
+			wstr.resize(utf8_to_wide_length(src, n));
+			if (!wstr.empty())
+				utf8_to_wide(&wstr[0], src, n);
+		}
+
+		inline std::string from_wide(const std::wstring& wstr) {
+			std::string str;
+			assign_utf8(str, wstr.data(), wstr.size());
+			return str;
+		}
+
+		inline std::wstring to_wide(const std::string& str) {
+			std::wstring wstr;
+			assign_wide(wstr, str.data(), str.size());
+			return wstr;
+		}
+
+		inline std::wstring from_bstr(const BSTR& bstr) {
+			return std::wstring(bstr, ::SysStringLen(bstr));
+		}
+
+		/* Sets a string cell from a BSTR. Reuses the cell's capacity. */
+		inline void assign_bstr(std::wstring& wstr, const BSTR& bstr) {
+			wstr.assign(bstr, ::SysStringLen(bstr));
+		}
+
+		inline void assign_bstr(std::string& str, const BSTR& bstr) {
+			assign_utf8(str, bstr, ::SysStringLen(bstr));
+		}
+
+		/* Allocates a BSTR for a string cell and writes it in place. Empty cells are NULL. */
+		inline BSTR make_bstr(const std::wstring_view& wstr) {
+			if (wstr.empty())
+				return nullptr;
+			BSTR bstr = ::SysAllocStringLen(wstr.data(), static_cast<UINT>(wstr.size()));
+			if (!bstr)
+				throw std::bad_alloc();
+			return bstr;
+		}
+
+		/* UTF-8 is sized, then transcoded straight into the BSTR. */
+		inline BSTR make_bstr(const std::string_view& str) {
+			if (str.empty())
+				return nullptr;
+			BSTR bstr = ::SysAllocStringLen(nullptr, static_cast<UINT>(utf8_to_wide_length(str.data(), str.size())));
+			if (!bstr)
+				throw std::bad_alloc();
+			utf8_to_wide(bstr, str.data(), str.size());
+			return bstr;
+		}
+
+		/* C++ types of string cells that can be written */
+		template<class T>
+		struct is_string_cell : std::integral_constant<bool, std::is_same<T, std::wstring>::value || std::is_same<T, std::string>::value ||
+			std::is_same<T, std::wstring_view>::value || std::is_same<T, std::string_view>::value> {};
+
+		template <class T, typename std::enable_if<std::is_integral<T>::value>::type * = nullptr>
+		inline long to_non_negative_long(const T& t) {
+			if (t > LONG_MAX)
+				return LONG_MAX;
+			if (t < 0)
+				return 0;
+			return static_cast<long>(t);
+		}
+
+		/* Element type as it travels in a SAFEARRAY. Same as T except where the platform's */
+		/* long is wider than the 32-bit VT_I4 (LP64 builds against orglab_data_fake.hpp). */
+		template<class T> struct wire { using type = T; };
+		template<> struct wire<long> { using type = std::int32_t; };
+		template<> struct wire<unsigned long> { using type = std::uint32_t; };
+		template<class T> using wire_t = typename wire<T>::type;
+
+		template<class T>
+		inline void copy_to_wire(wire_t<T>* dst, const T* src, const std::size_t& count) {
+			if (sizeof(wire_t<T>) == sizeof(T))
+				memcpy(dst, src, count * sizeof(T));
+			else
+				for (std::size_t i = 0; i < count; ++i)
+					dst[i] = static_cast<wire_t<T>>(src[i]);
+		}
+
+		using com_compat_info_t = std::pair<COLDATAFORMAT, VARENUM>;
+
+		template< class T>
+		inline com_compat_info_t get_com_compat_info(const COLDATAFORMAT& fmt, bool is_matrix = false) {
+			if (COLDATAFORMAT::DF_DATE == fmt || COLDATAFORMAT::DF_TIME == fmt) return com_compat_info_t{ fmt, VT_R8 };
+			if (std::is_same<T, double>::value)						return com_compat_info_t{ is_matrix ? COLDATAFORMAT::DF_DOUBLE : COLDATAFORMAT::DF_TEXT_NUMERIC, VT_R8 };
+			if (std::is_same<T, float>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_FLOAT, VT_R4 };
+			if (std::is_same<T, int>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_LONG, VT_I4 };
+			if (std::is_same<T, long>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_LONG, VT_I4 };
+			if (std::is_same<T, unsigned long>::value)				return com_compat_info_t{ COLDATAFORMAT::DF_ULONG, VT_I4 };
+			if (std::is_same<T, short>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_SHORT, VT_I2 };
+			if (std::is_same<T, unsigned short>::value)				return com_compat_info_t{ COLDATAFORMAT::DF_USHORT, VT_I2 };
+			if (std::is_same<T, std::wstring>::value)				return com_compat_info_t{ COLDATAFORMAT::DF_TEXT_NUMERIC, VT_BSTR };
+			if (std::is_same<T, std::string>::value)				return com_compat_info_t{ COLDATAFORMAT::DF_TEXT_NUMERIC, VT_BSTR };
+			if (std::is_same<T, std::wstring_view>::value)			return com_compat_info_t{ COLDATAFORMAT::DF_TEXT_NUMERIC, VT_BSTR };
+			if (std::is_same<T, std::string_view>::value)			return com_compat_info_t{ COLDATAFORMAT::DF_TEXT_NUMERIC, VT_BSTR };
+			if (std::is_same<T, byte>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_BYTE, VT_I1 };
+			if (std::is_same<T, char>::value)						return com_compat_info_t{ COLDATAFORMAT::DF_CHAR, VT_I1 };
+			if (std::is_same<T, std::complex<double>>::value)		return com_compat_info_t{ COLDATAFORMAT::DF_COMPLEX, VT_R8 };
+
+			throw std::runtime_error("Incompatible data types");
+		}
+
+		template<class T>
+		inline bool is_vector_type_compatible(const COLDATAFORMAT& fmt) {
+			if (std::is_same<T, double>::value&& COLDATAFORMAT::DF_TEXT_NUMERIC == fmt)			return true;
+			if (std::is_same<T, double>::value&& COLDATAFORMAT::DF_DOUBLE == fmt)				return true;
 			if (std::is_same<T, double>::value&& COLDATAFORMAT::DF_DATE == fmt)					return true;
 			if (std::is_same<T, double>::value&& COLDATAFORMAT::DF_TIME == fmt)					return true;
 			if (std::is_same<T, float>::value&& COLDATAFORMAT::DF_FLOAT == fmt)					return true;
@@ -391,17 +1487,499 @@ namespace orglab_data {
 			return false;
 		}
 
-		void do_set_col_data(const ColumnPtr& col, const _variant_t& vt_array, const long& offset) {
+		//// CONVERSION KERNELS ////
+		// Used when ORGLAB_DATA_CONVERT_DATA_TYPE is defined to move numeric data between the
+		// caller's type and the column's native type. Floating point to integer rounds to nearest,
+		// ties to even (default floating point environment), saturates, and maps NaN to 0.
+		// Double to float saturates finite values to +/-FLT_MAX and keeps infinities and NaN.
+
+		template<std::size_t N, bool Signed> struct sized_int;
+		template<> struct sized_int<1, true> { using type = std::int8_t; };
+		template<> struct sized_int<1, false> { using type = std::uint8_t; };
+		template<> struct sized_int<2, true> { using type = std::int16_t; };
+		template<> struct sized_int<2, false> { using type = std::uint16_t; };
+		template<> struct sized_int<4, true> { using type = std::int32_t; };
+		template<> struct sized_int<4, false> { using type = std::uint32_t; };
+		template<> struct sized_int<8, true> { using type = std::int64_t; };
+		template<> struct sized_int<8, false> { using type = std::uint64_t; };
+
+		/* Fixed width type kernels operate on for T */
+		template<class T, bool = std::is_integral<T>::value> struct kernel { using type = T; };
+		template<class T> struct kernel<T, true> { using type = typename sized_int<sizeof(T), std::is_signed<T>::value>::type; };
+		template<class T> using kernel_t = typename kernel<T>::type;
+
+		template<class D, class S>
+		inline D convert_value(const S& s) {
+			if constexpr (std::is_same<D, float>::value && std::is_same<S, double>::value) {
+				if (s > FLT_MAX && s <= DBL_MAX) return FLT_MAX;
+				if (s < -FLT_MAX && s >= -DBL_MAX) return -FLT_MAX;
+				return static_cast<float>(s);
+			}
+			else if constexpr (std::is_floating_point<D>::value) {
+				return static_cast<D>(s);
+			}
+			else if constexpr (std::is_floating_point<S>::value) {
+				if (s != s)
+					return 0;
+				double r = std::nearbyint(static_cast<double>(s));
+				if (r <= static_cast<double>((std::numeric_limits<D>::min)()))
+					return (std::numeric_limits<D>::min)();
+				if (r >= static_cast<double>((std::numeric_limits<D>::max)()))
+					return (std::numeric_limits<D>::max)();
+				return static_cast<D>(r);
+			}
+			else if constexpr (std::is_signed<S>::value) {
+				if (std::is_unsigned<D>::value && s < 0)
+					return 0;
+				if (static_cast<long long>(s) < static_cast<long long>((std::numeric_limits<D>::min)()))
+					return (std::numeric_limits<D>::min)();
+				if (s > 0 && static_cast<unsigned long long>(s) > static_cast<unsigned long long>((std::numeric_limits<D>::max)()))
+					return (std::numeric_limits<D>::max)();
+				return static_cast<D>(s);
+			}
+			else {
+				if (static_cast<unsigned long long>(s) > static_cast<unsigned long long>((std::numeric_limits<D>::max)()))
+					return (std::numeric_limits<D>::max)();
+				return static_cast<D>(s);
+			}
+		}
+
+		/* Vectorized head of a conversion. Returns number of values converted. */
+		template<class D, class S>
+		inline std::size_t convert_values_simd(D*, const S*, const std::size_t&) {
+			return 0;
+		}
+
+#ifdef ORGLAB_DATA_SSE2
+		inline void store_epi32_as_pd(double* dst, const __m128i& v) {
+			_mm_storeu_pd(dst, _mm_cvtepi32_pd(v));
+			_mm_storeu_pd(dst + 2, _mm_cvtepi32_pd(_mm_srli_si128(v, 8)));
+		}
+
+		inline std::size_t convert_values_simd(double* dst, const float* src, const std::size_t& n) {
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				__m128 v = _mm_loadu_ps(src + i);
+				_mm_storeu_pd(dst + i, _mm_cvtps_pd(v));
+				_mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(double* dst, const std::int32_t* src, const std::size_t& n) {
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+				store_epi32_as_pd(dst + i, _mm_loadu_si128((const __m128i*)(src + i)));
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(double* dst, const std::uint32_t* src, const std::size_t& n) {
+			const __m128i bias = _mm_set1_epi32(INT_MIN);
+			const __m128d offset = _mm_set1_pd(2147483648.0);
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				__m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(src + i)), bias);
+				_mm_storeu_pd(dst + i, _mm_add_pd(_mm_cvtepi32_pd(v), offset));
+				_mm_storeu_pd(dst + i + 2, _mm_add_pd(_mm_cvtepi32_pd(_mm_srli_si128(v, 8)), offset));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(double* dst, const std::int16_t* src, const std::size_t& n) {
+			std::size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+				store_epi32_as_pd(dst + i, _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16));
+				store_epi32_as_pd(dst + i + 4, _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(double* dst, const std::uint16_t* src, const std::size_t& n) {
+			const __m128i zero = _mm_setzero_si128();
+			std::size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+				store_epi32_as_pd(dst + i, _mm_unpacklo_epi16(v, zero));
+				store_epi32_as_pd(dst + i + 4, _mm_unpackhi_epi16(v, zero));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(double* dst, const std::int8_t* src, const std::size_t& n) {
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+				__m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+				__m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+				store_epi32_as_pd(dst + i, _mm_srai_epi32(_mm_unpacklo_epi16(lo, lo), 16));
+				store_epi32_as_pd(dst + i + 4, _mm_srai_epi32(_mm_unpackhi_epi16(lo, lo), 16));
+				store_epi32_as_pd(dst + i + 8, _mm_srai_epi32(_mm_unpacklo_epi16(hi, hi), 16));
+				store_epi32_as_pd(dst + i + 12, _mm_srai_epi32(_mm_unpackhi_epi16(hi, hi), 16));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(double* dst, const std::uint8_t* src, const std::size_t& n) {
+			const __m128i zero = _mm_setzero_si128();
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+				__m128i lo = _mm_unpacklo_epi8(v, zero);
+				__m128i hi = _mm_unpackhi_epi8(v, zero);
+				store_epi32_as_pd(dst + i, _mm_unpacklo_epi16(lo, zero));
+				store_epi32_as_pd(dst + i + 4, _mm_unpackhi_epi16(lo, zero));
+				store_epi32_as_pd(dst + i + 8, _mm_unpacklo_epi16(hi, zero));
+				store_epi32_as_pd(dst + i + 12, _mm_unpackhi_epi16(hi, zero));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(float* dst, const double* src, const std::size_t& n) {
+			const __m128d abs_mask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+			const __m128d dbl_max = _mm_set1_pd(DBL_MAX);
+			const __m128d flt_max = _mm_set1_pd(FLT_MAX);
+			const __m128d flt_min = _mm_set1_pd(-FLT_MAX);
+			auto saturate = [&](const __m128d& x) {
+				__m128d finite = _mm_cmple_pd(_mm_and_pd(x, abs_mask), dbl_max);
+				__m128d clamped = _mm_min_pd(_mm_max_pd(x, flt_min), flt_max);
+				return _mm_or_pd(_mm_and_pd(finite, clamped), _mm_andnot_pd(finite, x));
+			};
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				__m128 lo = _mm_cvtpd_ps(saturate(_mm_loadu_pd(src + i)));
+				__m128 hi = _mm_cvtpd_ps(saturate(_mm_loadu_pd(src + i + 2)));
+				_mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
+			}
+			return i;
+		}
+
+		/* Rounds 4 doubles to int32 after mapping NaN to 0 and clamping to [lo, hi] */
+		inline __m128i round_clamp_epi32(const double* src, const __m128d& lo, const __m128d& hi) {
+			__m128d a = _mm_loadu_pd(src);
+			__m128d b = _mm_loadu_pd(src + 2);
+			a = _mm_min_pd(_mm_max_pd(_mm_and_pd(a, _mm_cmpord_pd(a, a)), lo), hi);
+			b = _mm_min_pd(_mm_max_pd(_mm_and_pd(b, _mm_cmpord_pd(b, b)), lo), hi);
+			return _mm_unpacklo_epi64(_mm_cvtpd_epi32(a), _mm_cvtpd_epi32(b));
+		}
+
+		inline std::size_t convert_values_simd(std::int32_t* dst, const double* src, const std::size_t& n) {
+			const __m128d lo = _mm_set1_pd(INT_MIN), hi = _mm_set1_pd(INT_MAX);
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+				_mm_storeu_si128((__m128i*)(dst + i), round_clamp_epi32(src + i, lo, hi));
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(std::uint32_t* dst, const double* src, const std::size_t& n) {
+			// Shift [0, UINT_MAX] into int32 range, convert, then flip the sign bit back.
+			const __m128d lo = _mm_set1_pd(0.0), hi = _mm_set1_pd(UINT_MAX), offset = _mm_set1_pd(2147483648.0);
+			const __m128i bias = _mm_set1_epi32(INT_MIN);
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				__m128d a = _mm_loadu_pd(src + i);
+				__m128d b = _mm_loadu_pd(src + i + 2);
+				a = _mm_sub_pd(_mm_min_pd(_mm_max_pd(_mm_and_pd(a, _mm_cmpord_pd(a, a)), lo), hi), offset);
+				b = _mm_sub_pd(_mm_min_pd(_mm_max_pd(_mm_and_pd(b, _mm_cmpord_pd(b, b)), lo), hi), offset);
+				__m128i v = _mm_unpacklo_epi64(_mm_cvtpd_epi32(a), _mm_cvtpd_epi32(b));
+				_mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(v, bias));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(std::int16_t* dst, const double* src, const std::size_t& n) {
+			const __m128d lo = _mm_set1_pd(SHRT_MIN), hi = _mm_set1_pd(SHRT_MAX);
+			std::size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				__m128i a = round_clamp_epi32(src + i, lo, hi);
+				__m128i b = round_clamp_epi32(src + i + 4, lo, hi);
+				_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(std::uint16_t* dst, const double* src, const std::size_t& n) {
+			// SSE2 has no unsigned 32 to 16 bit pack. Bias into signed range and back.
+			const __m128d lo = _mm_set1_pd(0.0), hi = _mm_set1_pd(USHRT_MAX);
+			const __m128i bias32 = _mm_set1_epi32(32768);
+			const __m128i bias16 = _mm_set1_epi16(SHRT_MIN);
+			std::size_t i = 0;
+			for (; i + 8 <= n; i += 8) {
+				__m128i a = _mm_sub_epi32(round_clamp_epi32(src + i, lo, hi), bias32);
+				__m128i b = _mm_sub_epi32(round_clamp_epi32(src + i + 4, lo, hi), bias32);
+				_mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(_mm_packs_epi32(a, b), bias16));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(std::int8_t* dst, const double* src, const std::size_t& n) {
+			const __m128d lo = _mm_set1_pd(SCHAR_MIN), hi = _mm_set1_pd(SCHAR_MAX);
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m128i a = _mm_packs_epi32(round_clamp_epi32(src + i, lo, hi), round_clamp_epi32(src + i + 4, lo, hi));
+				__m128i b = _mm_packs_epi32(round_clamp_epi32(src + i + 8, lo, hi), round_clamp_epi32(src + i + 12, lo, hi));
+				_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi16(a, b));
+			}
+			return i;
+		}
+
+		inline std::size_t convert_values_simd(std::uint8_t* dst, const double* src, const std::size_t& n) {
+			const __m128d lo = _mm_set1_pd(0.0), hi = _mm_set1_pd(UCHAR_MAX);
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16) {
+				__m128i a = _mm_packs_epi32(round_clamp_epi32(src + i, lo, hi), round_clamp_epi32(src + i + 4, lo, hi));
+				__m128i b = _mm_packs_epi32(round_clamp_epi32(src + i + 8, lo, hi), round_clamp_epi32(src + i + 12, lo, hi));
+				_mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(a, b));
+			}
+			return i;
+		}
+#endif /* ORGLAB_DATA_SSE2 */
+
+		template<class D, class S>
+		inline void convert_values(D* dst, const S* src, const std::size_t& n) {
+			std::size_t i = simd_level::scalar == get_simd_level() ? 0 : convert_values_simd(dst, src, n);
+			for (; i < n; ++i)
+				dst[i] = convert_value<D>(src[i]);
+		}
+
+		/* Column formats whose data can be converted, i.e. stored as one numeric type */
+		inline bool is_convertible_format(const COLDATAFORMAT& fmt) {
+			switch (fmt) {
+			case COLDATAFORMAT::DF_TEXT_NUMERIC:
+			case COLDATAFORMAT::DF_DOUBLE:
+			case COLDATAFORMAT::DF_DATE:
+			case COLDATAFORMAT::DF_TIME:
+			case COLDATAFORMAT::DF_FLOAT:
+			case COLDATAFORMAT::DF_LONG:
+			case COLDATAFORMAT::DF_ULONG:
+			case COLDATAFORMAT::DF_SHORT:
+			case COLDATAFORMAT::DF_USHORT:
+			case COLDATAFORMAT::DF_CHAR:
+			case COLDATAFORMAT::DF_BYTE:
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		/* Calls fn with a null pointer to the type a convertible column format is stored as */
+		template<class Fn>
+		inline void visit_native_type(const COLDATAFORMAT& fmt, Fn&& fn) {
+			switch (fmt) {
+			case COLDATAFORMAT::DF_FLOAT: fn(static_cast<float*>(nullptr)); break;
+			case COLDATAFORMAT::DF_LONG: fn(static_cast<std::int32_t*>(nullptr)); break;
+			case COLDATAFORMAT::DF_ULONG: fn(static_cast<std::uint32_t*>(nullptr)); break;
+			case COLDATAFORMAT::DF_SHORT: fn(static_cast<std::int16_t*>(nullptr)); break;
+			case COLDATAFORMAT::DF_USHORT: fn(static_cast<std::uint16_t*>(nullptr)); break;
+			case COLDATAFORMAT::DF_CHAR: fn(static_cast<std::int8_t*>(nullptr)); break;
+			case COLDATAFORMAT::DF_BYTE: fn(static_cast<std::uint8_t*>(nullptr)); break;
+			default: fn(static_cast<double*>(nullptr)); break; // Double, text & numeric, date, time.
+			}
+		}
+
+		/* SAFEARRAY type a native type travels as. Same as get_com_compat_info. */
+		template<class S>
+		inline VARENUM get_native_vt() {
+			if (std::is_same<S, double>::value) return VT_R8;
+			if (std::is_same<S, float>::value) return VT_R4;
+			if (sizeof(S) == 4) return VT_I4;
+			if (sizeof(S) == 2) return VT_I2;
+			return VT_I1;
+		}
+
+		//// COMPLEX KERNELS ////
+		// std::complex<double> arrays are laid out re,im,re,im (guaranteed by the standard), which is
+		// what Origin uses for complex columns, so column transfers are plain copies. Complex matrices
+		// travel as separate real and imaginary planes, row major when set and column major when got.
+
+		/* Joins n values of re and im planes into dst */
+		inline void interleave_complex_scalar(std::complex<double>* dst, const double* re, const double* im, const std::size_t& begin, const std::size_t& end) {
+			for (std::size_t i = begin; i < end; ++i)
+				dst[i] = std::complex<double>{ re[i], im[i] };
+		}
+
+		/* Splits rows x cols column major src into row major re and im planes over */
+		/* the block [r0, r1) x [c0, c1) */
+		inline void deinterleave_transpose_complex_scalar(double* re, double* im, const std::complex<double>* src, const std::size_t& rows, const std::size_t& cols,
+			const std::size_t& r0, const std::size_t& r1, const std::size_t& c0, const std::size_t& c1) {
+			for (std::size_t j = r0; j < r1; ++j) {
+				for (std::size_t k = c0; k < c1; ++k) {
+					const std::complex<double>& c = src[rows * k + j];
+					re[cols * j + k] = c.real();
+					im[cols * j + k] = c.imag();
+				}
+			}
+		}
+
+#ifdef ORGLAB_DATA_SSE2
+		inline void interleave_complex_sse2(std::complex<double>* dst, const double* re, const double* im, const std::size_t& n) {
+			double* p = reinterpret_cast<double*>(dst);
+			std::size_t i = 0;
+			for (; i + 2 <= n; i += 2) {
+				__m128d r = _mm_loadu_pd(re + i);
+				__m128d m = _mm_loadu_pd(im + i);
+				_mm_storeu_pd(p + 2 * i, _mm_unpacklo_pd(r, m));
+				_mm_storeu_pd(p + 2 * i + 2, _mm_unpackhi_pd(r, m));
+			}
+			interleave_complex_scalar(dst, re, im, i, n);
+		}
+
+		inline void deinterleave_transpose_complex_sse2(double* re, double* im, const std::complex<double>* src, const std::size_t& rows, const std::size_t& cols,
+			const std::size_t& r0, const std::size_t& r1, const std::size_t& c0, const std::size_t& c1) {
+			const double* p = reinterpret_cast<const double*>(src);
+			for (std::size_t j = r0; j < r1; ++j) {
+				std::size_t k = c0;
+				for (; k + 2 <= c1; k += 2) {
+					// One row, two columns: [re,im] of (j,k) and (j,k+1).
+					__m128d a = _mm_loadu_pd(p + 2 * (rows * k + j));
+					__m128d b = _mm_loadu_pd(p + 2 * (rows * (k + 1) + j));
+					_mm_storeu_pd(re + cols * j + k, _mm_unpacklo_pd(a, b));
+					_mm_storeu_pd(im + cols * j + k, _mm_unpackhi_pd(a, b));
+				}
+				deinterleave_transpose_complex_scalar(re, im, src, rows, cols, j, j + 1, k, c1);
+			}
+		}
+#endif /* ORGLAB_DATA_SSE2 */
+
+#ifdef ORGLAB_DATA_AVX2
+		ORGLAB_DATA_TARGET_AVX2
+		inline void interleave_complex_avx2(std::complex<double>* dst, const double* re, const double* im, const std::size_t& n) {
+			double* p = reinterpret_cast<double*>(dst);
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4) {
+				__m256d r = _mm256_loadu_pd(re + i);
+				__m256d m = _mm256_loadu_pd(im + i);
+				__m256d lo = _mm256_unpacklo_pd(r, m); // r0 m0 r2 m2
+				__m256d hi = _mm256_unpackhi_pd(r, m); // r1 m1 r3 m3
+				_mm256_storeu_pd(p + 2 * i, _mm256_permute2f128_pd(lo, hi, 0x20));
+				_mm256_storeu_pd(p + 2 * i + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+			}
+			interleave_complex_scalar(dst, re, im, i, n);
+		}
+
+		ORGLAB_DATA_TARGET_AVX2
+		inline void deinterleave_transpose_complex_avx2(double* re, double* im, const std::complex<double>* src, const std::size_t& rows, const std::size_t& cols,
+			const std::size_t& r0, const std::size_t& r1, const std::size_t& c0, const std::size_t& c1) {
+			const double* p = reinterpret_cast<const double*>(src);
+			std::size_t j = r0;
+			for (; j + 2 <= r1; j += 2) {
+				std::size_t k = c0;
+				for (; k + 4 <= c1; k += 4) {
+					// Two rows, four columns. Column k holds (j,k),(j+1,k) contiguously.
+					__m256d a0 = _mm256_loadu_pd(p + 2 * (rows * k + j));
+					__m256d a1 = _mm256_loadu_pd(p + 2 * (rows * (k + 1) + j));
+					__m256d a2 = _mm256_loadu_pd(p + 2 * (rows * (k + 2) + j));
+					__m256d a3 = _mm256_loadu_pd(p + 2 * (rows * (k + 3) + j));
+					__m256d r01 = _mm256_unpacklo_pd(a0, a1); // re(j,k) re(j,k+1) re(j+1,k) re(j+1,k+1)
+					__m256d r23 = _mm256_unpacklo_pd(a2, a3);
+					__m256d m01 = _mm256_unpackhi_pd(a0, a1);
+					__m256d m23 = _mm256_unpackhi_pd(a2, a3);
+					_mm256_storeu_pd(re + cols * j + k, _mm256_permute2f128_pd(r01, r23, 0x20));
+					_mm256_storeu_pd(re + cols * (j + 1) + k, _mm256_permute2f128_pd(r01, r23, 0x31));
+					_mm256_storeu_pd(im + cols * j + k, _mm256_permute2f128_pd(m01, m23, 0x20));
+					_mm256_storeu_pd(im + cols * (j + 1) + k, _mm256_permute2f128_pd(m01, m23, 0x31));
+				}
+				deinterleave_transpose_complex_scalar(re, im, src, rows, cols, j, j + 2, k, c1);
+			}
+			deinterleave_transpose_complex_scalar(re, im, src, rows, cols, j, r1, c0, c1);
+		}
+#endif /* ORGLAB_DATA_AVX2 */
+
+		inline void interleave_complex(std::complex<double>* dst, const double* re, const double* im, const std::size_t& n) {
+			switch (get_simd_level()) {
+#ifdef ORGLAB_DATA_AVX2
+			case simd_level::avx2: interleave_complex_avx2(dst, re, im, n); break;
+#endif
+#ifdef ORGLAB_DATA_SSE2
+			case simd_level::sse2: interleave_complex_sse2(dst, re, im, n); break;
+#endif
+			default: interleave_complex_scalar(dst, re, im, 0, n); break;
+			}
+		}
+
+		/* Splits rows x cols column major src (leading dimension lds) into row major re and im planes */
+		inline void deinterleave_transpose_complex(double* re, double* im, const std::complex<double>* src, const std::size_t& lds, const std::size_t& rows, const std::size_t& cols) {
+			simd_level level = get_simd_level();
+			for_each_tile(rows, cols, transpose_block<std::complex<double>>(), [&](const std::size_t& r0, const std::size_t& r1, const std::size_t& c0, const std::size_t& c1) {
+				switch (level) {
+#ifdef ORGLAB_DATA_AVX2
+				case simd_level::avx2: deinterleave_transpose_complex_avx2(re, im, src, lds, cols, r0, r1, c0, c1); break;
+#endif
+#ifdef ORGLAB_DATA_SSE2
+				case simd_level::sse2: deinterleave_transpose_complex_sse2(re, im, src, lds, cols, r0, r1, c0, c1); break;
+#endif
+				default: deinterleave_transpose_complex_scalar(re, im, src, lds, cols, r0, r1, c0, c1); break;
+				}
+			});
+		}
+
+		/* Splits n values of src into re and im. Row major sources need no transpose. */
+		inline void deinterleave_complex(double* re, double* im, const std::complex<double>* src, const std::size_t& n) {
+			for (std::size_t i = 0; i < n; ++i) {
+				re[i] = src[i].real();
+				im[i] = src[i].imag();
+			}
+		}
+
+		/* Joins rows x cols column major re and im planes into row major dst (leading dimension ldd) */
+		inline void interleave_transpose_complex(std::complex<double>* dst, const std::size_t& ldd, const double* re, const double* im, const std::size_t& rows, const std::size_t& cols) {
+			for_each_tile(rows, cols, transpose_block<std::complex<double>>(), [&](const std::size_t& r0, const std::size_t& r1, const std::size_t& c0, const std::size_t& c1) {
+				for (std::size_t j = r0; j < r1; ++j)
+					for (std::size_t k = c0; k < c1; ++k)
+						dst[ldd * j + k] = std::complex<double>{ re[rows * k + j], im[rows * k + j] };
+			});
+		}
+
+		//// TRANSPORT BACKEND ////
+		// Every round-trip to Origin goes through the do_* functions below. They use only the
+		// methods #import generates for the Column and MatrixObject interfaces (GetDataFormat,
+		// PutDataFormat, SetData and GetData) and for Worksheet and Columns (Cols, Columns,
+		// Item, SetData and GetData), so any namespace that provides ColumnPtr, MatrixObjectPtr,
+		// WorksheetPtr and ColumnsPtr of that shape can be plugged in with ORGLAB_DATA_ORGLAB_NS.
+		// orglab_data_fake.hpp provides an in-process one for testing and benchmarking.
+
+		inline COLDATAFORMAT do_get_col_fmt(const ColumnPtr& col) {
+			return col->GetDataFormat();
+		}
+
+		inline void do_set_col_fmt(const ColumnPtr& col, const COLDATAFORMAT& fmt) {
+			col->PutDataFormat(fmt);
+		}
+
+		inline void do_set_col_data(const ColumnPtr& col, const _variant_t& vt_array, const long& offset) {
+			try {
+				_variant_t v_offset(offset);
+				col->SetData(vt_array, v_offset);
+			}
+			catch (...) {
+				throw std::runtime_error("ColumnPtr set data fail");
+			}
+		}
+
+		/* True for the HRESULTs a server gives when it will not take an array it does not */
+		/* own, which a copy of the same data gets past. Anything else is a real failure. */
+		inline bool is_zero_copy_refusal(HRESULT hr) {
+			return DISP_E_ARRAYISLOCKED == hr || E_INVALIDARG == hr;
+		}
+
+		/* As do_set_col_data, but returns false if the server refuses the array */
+		inline bool do_try_set_col_data(const ColumnPtr& col, const _variant_t& vt_array, const long& offset) {
 			try {
 				_variant_t v_offset(offset);
 				col->SetData(vt_array, v_offset);
+				return true;
+			}
+			catch (const _com_error& e) {
+				if (is_zero_copy_refusal(e.Error()))
+					return false;
+				throw std::runtime_error("ColumnPtr set data fail");
 			}
 			catch (...) {
-				throw std::exception("ColumnPtr set data fail");
+				throw std::runtime_error("ColumnPtr set data fail");
 			}
 		}
 
-		_variant_t do_get_col_data(const ColumnPtr& col, const ARRAYDATAFORMAT& fmt, const long& offset, const long& rows) {
+		inline _variant_t do_get_col_data(const ColumnPtr& col, const ARRAYDATAFORMAT& fmt, const long& offset, const long& rows) {
 			if (0 == rows)
 				return _variant_t();
 			long r2 = rows < -1 ? -1 : rows;
@@ -413,384 +1991,3242 @@ namespace orglab_data {
 			return col->GetData(fmt, v_r1, v_r2, v_lbound);
 		}
 
-		template<class T>
-		void set_arithmetic_column_data(const ColumnPtr& col, const T* data, const std::size_t& rows, const std::size_t& offset, bool change_type = true) {
-			if (!data || 0 == rows)
-				return;
-			com_compat_info_t info = get_com_compat_info<T>(col->DataFormat);
-			if (change_type && (info.first != col->DataFormat))
-				col->DataFormat = info.first;
-			try {
-				long long_rows = to_non_negative_long(rows);
-				SAFEARRAYBOUND sa_bounds = { static_cast<unsigned long>(long_rows), 0 };
-				SAFEARRAY* pSA = ::SafeArrayCreate(info.second, 1, &sa_bounds);
-				_variant_t vt_array;
-				vt_array.vt = info.second | VT_ARRAY;
-				vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
-				T* p_val = nullptr;
-				::SafeArrayAccessData(pSA, (void**)&p_val);
-				memcpy(p_val, data, long_rows * sizeof(T));
-				::SafeArrayUnaccessData(pSA);
-				do_set_col_data(col, vt_array, to_non_negative_long(offset));
-			}
-			catch (...) {
-				throw std::exception("ColumnPtr set data fail");
-			}
+		inline long do_get_wks_cols(const WorksheetPtr& wks) {
+			return wks->GetCols();
 		}
 
-		void set_complex_column_data(const ColumnPtr& col, const std::complex<double>* data, const std::size_t& rows, const std::size_t& offset, bool change_type = true) {
-			if (!data || 0 == rows)
-				return;
-			com_compat_info_t info = get_com_compat_info<std::complex<double>>(col->DataFormat);
-			if (change_type && (info.first != col->DataFormat))
-				col->DataFormat = info.first;
+		inline void do_set_wks_cols(const WorksheetPtr& wks, const long& cols) {
+			wks->PutCols(cols);
+		}
+
+		inline ColumnsPtr do_get_wks_columns(const WorksheetPtr& wks) {
+			return wks->GetColumns();
+		}
+
+		inline ColumnPtr do_get_wks_col(const ColumnsPtr& cols, const long& index) {
+			ColumnPtr col = cols->GetItem(_variant_t(index));
+			if (!col)
+				throw std::runtime_error("ColumnPtr is invalid");
+			return col;
+		}
+
+		/* Sets a 2D array, dimension 1 columns and dimension 2 rows, at row and col */
+		inline void do_set_wks_data(const WorksheetPtr& wks, const _variant_t& vt_array, const long& row, const long& col) {
 			try {
-				long long_rows = to_non_negative_long(rows);
-				SAFEARRAYBOUND sa_bounds = { static_cast<unsigned long>(long_rows) * 2, 0 };
-				SAFEARRAY* pSA = ::SafeArrayCreate(info.second, 1, &sa_bounds);
-				_variant_t vt_array;
-				vt_array.vt = info.second | VT_ARRAY;
-				vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
-				double* p_val = nullptr;
-				::SafeArrayAccessData(pSA, (void**)&p_val);
-				for (std::size_t i = 0; i < long_rows; ++i) {
-					*p_val = data[i].real();
-					*(++p_val) = data[i].imag();
-					++p_val;
-				}
-				::SafeArrayUnaccessData(pSA);
-				do_set_col_data(col, vt_array, to_non_negative_long(offset));
+				_variant_t v_row(row);
+				_variant_t v_col(col);
+				wks->SetData(vt_array, v_row, v_col);
 			}
 			catch (...) {
-				throw std::exception("ColumnPtr set data fail");
+				throw std::runtime_error("WorksheetPtr set data fail");
 			}
 		}
 
-		template<class T>
-		void set_string_column_data(const ColumnPtr& col, const std::vector<T>& data, const std::size_t& offset, bool change_type = true) {
-			if (0 == data.size())
-				return;
-			com_compat_info_t info = get_com_compat_info<T>(col->DataFormat);
-			if (change_type && (info.first != col->DataFormat))
-				col->DataFormat = info.first;
-			try {
-				long long_rows = to_non_negative_long(data.size());
-				CComSafeArray<BSTR> csa(long_rows);
-				for (long i = 0; i < long_rows; i++) {
-					csa.SetAt(i, to_ccom_bstr(data[i]).Detach(), false);
+		/* Gets rows r1 to r2 (-1 for the last) of columns c1 to c2 as a 2D array, dimension 1 */
+		/* rows and dimension 2 columns */
+		inline _variant_t do_get_wks_data(const WorksheetPtr& wks, const ARRAYDATAFORMAT& fmt, const long& r1, const long& c1, const long& r2, const long& c2) {
+			_variant_t v_r1(r1);
+			_variant_t v_c1(c1);
+			_variant_t v_r2(r2);
+			_variant_t v_c2(c2);
+			_variant_t v_lbound(0);
+			return wks->GetData(v_r1, v_c1, v_r2, v_c2, fmt, v_lbound);
+		}
+
+		/* Hands a column or matrix to another thread. COM interface pointers are marshaled into */
+		/* the receiving thread's apartment; the fake backend's objects are free-threaded. */
+#if !defined(ORGLAB_DATA_FAKE_HPP)
+		template<class P>
+		class marshaled_ptr {
+			IStream* stream_ = nullptr;
+		public:
+			explicit marshaled_ptr(const P& ptr) {
+				if (FAILED(::CoMarshalInterThreadInterfaceInStream(P::GetIID(), ptr.GetInterfacePtr(), &stream_)))
+					throw std::runtime_error("COM pointer marshal fail");
+			}
+			marshaled_ptr(const marshaled_ptr&) = delete;
+			marshaled_ptr& operator=(const marshaled_ptr&) = delete;
+			~marshaled_ptr() {
+				if (stream_) { // Never unmarshaled.
+					LARGE_INTEGER zero = {};
+					stream_->Seek(zero, STREAM_SEEK_SET, nullptr);
+					::CoReleaseMarshalData(stream_);
+					stream_->Release();
 				}
-				_variant_t vt_array;
-				vt_array.vt = VT_BSTR | VT_ARRAY;
-				vt_array.parray = csa.Detach(); // Let _variant_t take ownership of CComSafeArray's SAFEARRAY.
+			}
+			/* Call once, on the receiving thread after CoInitializeEx */
+			P get() {
+				P ptr;
+				IStream* stream = stream_;
+				stream_ = nullptr;
+				if (!stream || FAILED(::CoGetInterfaceAndReleaseStream(stream, P::GetIID(), (void**)&ptr)))
+					throw std::runtime_error("COM pointer unmarshal fail");
+				return ptr;
+			}
+		};
+#else
+		template<class P>
+		class marshaled_ptr {
+			P ptr_;
+		public:
+			explicit marshaled_ptr(const P& ptr) : ptr_(ptr) {}
+			P get() { return std::move(ptr_); }
+		};
+#endif
+		using marshaled_column = marshaled_ptr<ColumnPtr>;
+
+		/* Counters of the SAFEARRAY pool. pooled_bytes is held by idle arrays. */
+		struct array_pool_stats {
+			std::uint64_t hits = 0;
+			std::uint64_t misses = 0;
+			std::uint64_t recycled = 0;
+			std::uint64_t released = 0;
+			std::size_t pooled_bytes = 0;
+			std::size_t cap = 0;
+		};
+
+		/* Reuses numeric SAFEARRAYs that writes pack their data into, across calls and threads. */
+		/* Arrays are keyed by element type and exact bounds, so a reused array already has the */
+		/* shape of the write and its descriptor is never touched. Off while cap, the most bytes */
+		/* held by idle arrays, is 0. */
+		class array_pool {
+		public:
+			static array_pool& instance() {
+				static array_pool pool;
+				return pool;
+			}
+			array_pool(const array_pool&) = delete;
+			array_pool& operator=(const array_pool&) = delete;
+			~array_pool() {
+				set_cap(0);
+			}
+
+			void set_cap(const std::size_t& cap) {
+				std::vector<SAFEARRAY*> released;
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+					cap_ = cap;
+					trim(released);
+				}
+				for (SAFEARRAY* psa : released)
+					::SafeArrayDestroy(psa);
+			}
+
+			array_pool_stats stats() {
+				std::lock_guard<std::mutex> lock(mtx_);
+				array_pool_stats st = stats_;
+				st.pooled_bytes = pooled_bytes_;
+				st.cap = cap_;
+				return st;
+			}
+
+			/* Same as SafeArrayCreate, from the pool when it is on */
+			SAFEARRAY* create(VARENUM vt, const UINT& dims, const SAFEARRAYBOUND* bounds) {
+				std::size_t count = 1;
+				for (UINT i = 0; i < dims; ++i)
+					count *= bounds[i].cElements;
+				std::size_t elem_size = 0;
+				bool on = false;
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+					on = cap_ > 0;
+				}
+				if (on)
+					elem_size = vt_size(vt);
+				if (!on || 0 == elem_size || 0 == count || dims > max_dims)
+					return ::SafeArrayCreate(vt, dims, const_cast<SAFEARRAYBOUND*>(bounds));
+				key_t key{ vt, dims, count * elem_size };
+				for (UINT i = 0; i < dims; ++i) {
+					key.counts[i] = bounds[i].cElements;
+					key.lbounds[i] = bounds[i].lLbound;
+				}
+				std::size_t bytes = key.bytes;
+				SAFEARRAY* psa = nullptr;
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+					std::vector<SAFEARRAY*>& idle = idle_[key];
+					if (!idle.empty()) {
+						psa = idle.back();
+						idle.pop_back();
+						pooled_bytes_ -= bytes;
+						++stats_.hits;
+					}
+					else
+						++stats_.misses;
+				}
+				if (!psa) {
+					psa = ::SafeArrayCreate(vt, dims, const_cast<SAFEARRAYBOUND*>(bounds));
+					if (!psa)
+						return nullptr;
+					std::lock_guard<std::mutex> lock(mtx_);
+					owned_[psa] = key;
+				}
+				return psa;
+			}
+
+			/* Takes back an array from create, or returns false if it did not come from the pool */
+			bool recycle(SAFEARRAY* psa) {
+				std::vector<SAFEARRAY*> released;
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+					auto it = owned_.find(psa);
+					if (it == owned_.end())
+						return false;
+					if (psa->cLocks || pooled_bytes_ + it->second.bytes > cap_) {
+						owned_.erase(it);
+						++stats_.released;
+						released.push_back(psa);
+					}
+					else {
+						idle_[it->second].push_back(psa);
+						pooled_bytes_ += it->second.bytes;
+						++stats_.recycled;
+					}
+				}
+				for (SAFEARRAY* p : released)
+					::SafeArrayDestroy(p);
+				return true;
+			}
+
+		private:
+			static const UINT max_dims = 3;
+
+			struct key_t {
+				VARENUM vt;
+				UINT dims;
+				std::size_t bytes;
+				std::array<ULONG, max_dims> counts{};
+				std::array<LONG, max_dims> lbounds{};
+				bool operator<(const key_t& other) const {
+					return std::tie(vt, dims, counts, lbounds) < std::tie(other.vt, other.dims, other.counts, other.lbounds);
+				}
+			};
+
+			array_pool() = default;
+
+			static std::size_t vt_size(VARENUM vt) {
+				switch (vt) {
+				case VT_R8: return sizeof(double);
+				case VT_R4: return sizeof(float);
+				case VT_I4: case VT_UI4: return 4;
+				case VT_I2: case VT_UI2: return 2;
+				case VT_I1: case VT_UI1: return 1;
+				default: return 0; // Not pooled.
+				}
+			}
+
+			/* Drops idle arrays until they fit in cap_. Called with mtx_ held. */
+			void trim(std::vector<SAFEARRAY*>& released) {
+				for (auto it = idle_.begin(); it != idle_.end() && pooled_bytes_ > cap_; ++it) {
+					while (!it->second.empty() && pooled_bytes_ > cap_) {
+						SAFEARRAY* psa = it->second.back();
+						it->second.pop_back();
+						owned_.erase(psa);
+						pooled_bytes_ -= it->first.bytes;
+						++stats_.released;
+						released.push_back(psa);
+					}
+				}
+			}
+
+			std::mutex mtx_;
+			std::map<key_t, std::vector<SAFEARRAY*>> idle_;
+			std::map<SAFEARRAY*, key_t> owned_; // Every array from create not yet released.
+			std::size_t pooled_bytes_ = 0;
+			std::size_t cap_ = 0;
+			array_pool_stats stats_;
+		};
+
+		inline SAFEARRAY* create_array(VARENUM vt, const UINT& dims, const SAFEARRAYBOUND* bounds) {
+			return array_pool::instance().create(vt, dims, bounds);
+		}
+
+		/* Returns the array of a packed write to the pool once the round-trip is done. Arrays */
+		/* from create_array must come back here rather than be destroyed elsewhere. */
+		inline void recycle_array(_variant_t& vt_array) {
+			if ((VT_ARRAY & vt_array.vt) && !(VT_BYREF & vt_array.vt) && vt_array.parray && array_pool::instance().recycle(vt_array.parray)) {
+				vt_array.parray = nullptr;
+				vt_array.vt = VT_EMPTY;
+			}
+			vt_array.Clear();
+		}
+
+		/* Recycles a packed array on scope exit, error or not */
+		struct recycle_guard {
+			_variant_t& vt_array;
+			~recycle_guard() { recycle_array(vt_array); }
+		};
+
+		/* How T is written to a column: SAFEARRAY type, or native format to convert to */
+		struct column_write_format {
+			COLDATAFORMAT fmt;
+			VARENUM vt;
+			bool converting;
+		};
+
+		/* Reads the column format and changes it to suit T if change_type. One or two round-trips. */
+		template<class T>
+		column_write_format prepare_column_write(const ColumnPtr& col, bool change_type, bool convert) {
+			COLDATAFORMAT fmt = do_get_col_fmt(col);
+			if (std::is_arithmetic<T>::value && convert && !is_vector_type_compatible<T>(fmt) && is_convertible_format(fmt))
+				return column_write_format{ fmt, VT_EMPTY, true };
+			com_compat_info_t info = get_com_compat_info<T>(fmt);
+			if (change_type && (info.first != fmt))
+				do_set_col_fmt(col, info.first);
+			return column_write_format{ info.first, info.second, false };
+		}
 
+		/* Packing fills vt_array with the array SetData takes, replacing what it held. Packing */
+		/* makes no round-trip, so it can run on any thread. Numeric arrays come from create_array; */
+		/* pass them to recycle_array when done. */
+
+		/* Packs data converted to the column's native type, keeping the column format */
+		template<class T>
+		void pack_converted_column_data(const COLDATAFORMAT& fmt, const T* data, const std::size_t& rows, _variant_t& vt_array) {
+			recycle_array(vt_array);
+			try {
+				long long_rows = to_non_negative_long(rows);
+				visit_native_type(fmt, [&](auto* tag) {
+					using S = typename std::remove_pointer<decltype(tag)>::type;
+					SAFEARRAYBOUND sa_bounds = { static_cast<unsigned long>(long_rows), 0 };
+					VARENUM vt = get_native_vt<S>();
+					SAFEARRAY* pSA = create_array(vt, 1, &sa_bounds);
+					vt_array.vt = vt | VT_ARRAY;
+					vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
+					S* p_val = nullptr;
+					::SafeArrayAccessData(pSA, (void**)&p_val);
+					convert_values(p_val, reinterpret_cast<const kernel_t<T>*>(data), long_rows);
+					::SafeArrayUnaccessData(pSA);
+					});
+			}
+			catch (...) {
+				recycle_array(vt_array);
+				throw std::runtime_error("ColumnPtr set data fail");
+			}
+		}
+
+		/* Packs rows of data with a format from prepare_column_write */
+		template<class T>
+		void pack_column_data(const column_write_format& wf, const T* data, const std::size_t& rows, _variant_t& vt_array) {
+			if (wf.converting)
+				return pack_converted_column_data(wf.fmt, data, rows, vt_array);
+			recycle_array(vt_array);
+			try {
+				long long_rows = to_non_negative_long(rows);
+				SAFEARRAYBOUND sa_bounds = { static_cast<unsigned long>(long_rows), 0 };
+				SAFEARRAY* pSA = create_array(wf.vt, 1, &sa_bounds);
+				vt_array.vt = wf.vt | VT_ARRAY;
+				vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
+				wire_t<T>* p_val = nullptr;
+				::SafeArrayAccessData(pSA, (void**)&p_val);
+				copy_to_wire(p_val, data, long_rows);
+				::SafeArrayUnaccessData(pSA);
+			}
+			catch (...) {
+				recycle_array(vt_array);
+				throw std::runtime_error("ColumnPtr set data fail");
+			}
+		}
+
+		inline void pack_column_data(const column_write_format& wf, const std::complex<double>* data, const std::size_t& rows, _variant_t& vt_array) {
+			recycle_array(vt_array);
+			try {
+				long long_rows = to_non_negative_long(rows);
+				SAFEARRAYBOUND sa_bounds = { static_cast<unsigned long>(long_rows) * 2, 0 };
+				SAFEARRAY* pSA = create_array(wf.vt, 1, &sa_bounds);
+				vt_array.vt = wf.vt | VT_ARRAY;
+				vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
+				double* p_val = nullptr;
+				::SafeArrayAccessData(pSA, (void**)&p_val);
+				memcpy(p_val, data, static_cast<std::size_t>(long_rows) * sizeof(std::complex<double>)); // Same re,im layout.
+				::SafeArrayUnaccessData(pSA);
+			}
+			catch (...) {
+				recycle_array(vt_array);
+				throw std::runtime_error("ColumnPtr set data fail");
+			}
+		}
+
+		/* Fills vt_array with rows BSTRs from make(i), built in place in the SAFEARRAY */
+		template<class F>
+		void pack_bstr_cells(const std::size_t& rows, _variant_t& vt_array, F make) {
+			recycle_array(vt_array);
+			SAFEARRAYBOUND sa_bounds = { static_cast<unsigned long>(to_non_negative_long(rows)), 0 };
+			SAFEARRAY* pSA = ::SafeArrayCreate(VT_BSTR, 1, &sa_bounds);
+			if (!pSA)
+				throw std::runtime_error("ColumnPtr set data fail");
+			vt_array.vt = VT_BSTR | VT_ARRAY;
+			vt_array.parray = pSA; // Let _variant_t take ownership of the SAFEARRAY and the BSTRs made so far.
+			BSTR* cells = nullptr;
+			::SafeArrayAccessData(pSA, (void**)&cells);
+			try {
+				for (unsigned long i = 0; i < sa_bounds.cElements; ++i)
+					cells[i] = make(static_cast<std::size_t>(i));
+			}
+			catch (...) {
+				::SafeArrayUnaccessData(pSA);
+				vt_array.Clear();
+				throw std::runtime_error("ColumnPtr set data fail");
+			}
+			::SafeArrayUnaccessData(pSA);
+		}
+
+		/* Builds each BSTR in place in the SAFEARRAY, with no temporary string per cell */
+		template<class T>
+		void pack_string_column_data(const T* data, const std::size_t& rows, _variant_t& vt_array) {
+			pack_bstr_cells(rows, vt_array, [&](const std::size_t& i) { return make_bstr(data[i]); });
+		}
+
+		inline void pack_column_data(const column_write_format&, const std::wstring* data, const std::size_t& rows, _variant_t& vt_array) {
+			pack_string_column_data(data, rows, vt_array);
+		}
+
+		inline void pack_column_data(const column_write_format&, const std::string* data, const std::size_t& rows, _variant_t& vt_array) {
+			pack_string_column_data(data, rows, vt_array);
+		}
+
+		inline void pack_column_data(const column_write_format&, const std::wstring_view* data, const std::size_t& rows, _variant_t& vt_array) {
+			pack_string_column_data(data, rows, vt_array);
+		}
+
+		inline void pack_column_data(const column_write_format&, const std::string_view* data, const std::size_t& rows, _variant_t& vt_array) {
+			pack_string_column_data(data, rows, vt_array);
+		}
+
+		/* Sends a packed array. One round-trip. */
+		inline void send_column_data(const ColumnPtr& col, const _variant_t& vt_array, const std::size_t& offset) {
+			try {
 				do_set_col_data(col, vt_array, to_non_negative_long(offset));
 			}
 			catch (...) {
-				throw std::exception("ColumnPtr set data fail");
+				throw std::runtime_error("ColumnPtr set data fail");
+			}
+		}
+
+		/* Columns and matrices, by interface address, whose server refused a wrapped array */
+		/* that a copy then passed. An address the server reuses for a new object inherits */
+		/* the refusal, which only costs a copy. */
+		class zero_copy_refusals {
+			std::mutex mtx_;
+			std::unordered_set<const void*> objs_;
+			std::atomic<std::size_t> count_{ 0 };
+		public:
+			bool has(const void* obj) {
+				if (0 == count_.load(std::memory_order_relaxed))
+					return false;
+				std::lock_guard<std::mutex> lock(mtx_);
+				return objs_.count(obj) != 0;
+			}
+			void add(const void* obj) {
+				std::lock_guard<std::mutex> lock(mtx_);
+				objs_.insert(obj);
+				count_.store(objs_.size(), std::memory_order_relaxed);
+			}
+			std::size_t size() const {
+				return count_.load(std::memory_order_relaxed);
+			}
+			std::size_t clear() {
+				std::lock_guard<std::mutex> lock(mtx_);
+				std::size_t n = objs_.size();
+				objs_.clear();
+				count_.store(0, std::memory_order_relaxed);
+				return n;
+			}
+		};
+
+		inline zero_copy_refusals& zero_copy_refused() {
+			static zero_copy_refusals refusals;
+			return refusals;
+		}
+
+		/* True if T can be sent straight from caller memory: same layout as the SAFEARRAY */
+		template<class T>
+		bool is_zero_copy_write(const column_write_format& wf) {
+			if (!ORGLAB_DATA_ZC || wf.converting)
+				return false;
+			if constexpr (std::is_arithmetic<T>::value)
+				return sizeof(wire_t<T>) == sizeof(T);
+			else
+				return std::is_same<T, std::complex<double>>::value;
+		}
+
+		/* Points a fixed size FADF_STATIC descriptor with bounds (dimension 1 first) at data. */
+		/* Destroying vt_array would zero-fill data, as SafeArrayDestroy does static data, so */
+		/* hold it with a wrap_guard, which frees the descriptor only. */
+		inline void wrap_array(VARENUM vt, const void* data, const unsigned int& dims, const SAFEARRAYBOUND* bounds, _variant_t& vt_array) {
+			SAFEARRAY* pSA = nullptr;
+			if (FAILED(::SafeArrayAllocDescriptorEx(vt, dims, &pSA)))
+				throw std::runtime_error("SAFEARRAY descriptor fail");
+			pSA->fFeatures |= FADF_STATIC | FADF_FIXEDSIZE;
+			for (unsigned int i = 0; i < dims; ++i)
+				pSA->rgsabound[dims - 1 - i] = bounds[i]; // Stored right-most dimension first.
+			pSA->pvData = const_cast<void*>(data);
+			vt_array.vt = vt | VT_ARRAY;
+			vt_array.parray = pSA;
+		}
+
+		/* Takes a wrap_array descriptor back from vt_array and frees it, leaving the data */
+		inline void unwrap_array(_variant_t& vt_array) {
+			if (0 == (vt_array.vt & VT_ARRAY) || !vt_array.parray)
+				return;
+			SAFEARRAY* pSA = vt_array.parray;
+			vt_array.vt = VT_EMPTY;
+			vt_array.parray = nullptr;
+			pSA->pvData = nullptr;
+			::SafeArrayDestroyDescriptor(pSA);
+		}
+
+		/* Unwraps a wrapped array on scope exit, error or not */
+		struct wrap_guard {
+			_variant_t& vt_array;
+			~wrap_guard() { unwrap_array(vt_array); }
+		};
+
+		/* Sends count elements of type vt at data with one SetData, through a fixed size */
+		/* FADF_STATIC descriptor that points at data for the duration of the call. Returns */
+		/* false if the server refuses the array; other failures throw. */
+		inline bool send_wrapped_column_data(const ColumnPtr& col, VARENUM vt, const void* data, const std::size_t& count, const std::size_t& offset) {
+			SAFEARRAYBOUND bound;
+			bound.cElements = static_cast<ULONG>(to_non_negative_long(count));
+			bound.lLbound = 0;
+			_variant_t vt_array;
+			wrap_guard guard{ vt_array };
+			wrap_array(vt, data, 1, &bound, vt_array);
+			return do_try_set_col_data(col, vt_array, to_non_negative_long(offset));
+		}
+
+		/* Writes rows of data with a format from prepare_column_write. One round-trip. */
+		/* With ORGLAB_DATA_ZERO_COPY, data whose layout matches is sent without a copy; if the */
+		/* server refuses that array but takes a copy, later writes to the column copy. */
+		template<class T>
+		void write_column_data(const ColumnPtr& col, const column_write_format& wf, const T* data, const std::size_t& rows, const std::size_t& offset) {
+			const void* obj = &*col;
+			bool zero_copy = is_zero_copy_write<T>(wf) && !zero_copy_refused().has(obj);
+			if (zero_copy && send_wrapped_column_data(col, wf.vt, data, std::is_same<T, std::complex<double>>::value ? rows * 2 : rows, offset))
+				return;
+			_variant_t vt_array;
+			recycle_guard guard{ vt_array };
+			pack_column_data(wf, data, rows, vt_array);
+			send_column_data(col, vt_array, offset);
+			if (zero_copy)
+				zero_copy_refused().add(obj);
+		}
+
+		template<class T>
+		void write_string_column_data(const ColumnPtr& col, const T* data, const std::size_t& rows, const std::size_t& offset) {
+			_variant_t vt_array;
+			pack_string_column_data(data, rows, vt_array);
+			send_column_data(col, vt_array, offset);
+		}
+
+		template<class T>
+		void set_arithmetic_column_data(const ColumnPtr& col, const T* data, const std::size_t& rows, const std::size_t& offset, bool change_type = true, bool convert = false) {
+			if (!data || 0 == rows)
+				return;
+			write_column_data(col, prepare_column_write<T>(col, change_type, convert), data, rows, offset);
+		}
+
+		inline void set_complex_column_data(const ColumnPtr& col, const std::complex<double>* data, const std::size_t& rows, const std::size_t& offset, bool change_type = true) {
+			if (!data || 0 == rows)
+				return;
+			write_column_data(col, prepare_column_write<std::complex<double>>(col, change_type, false), data, rows, offset);
+		}
+
+		template<class T>
+		void set_string_column_data(const ColumnPtr& col, const T* data, const std::size_t& rows, const std::size_t& offset, bool change_type = true) {
+			if (!data || 0 == rows)
+				return;
+			prepare_column_write<T>(col, change_type, false);
+			write_string_column_data(col, data, rows, offset);
+		}
+
+		/* Number of elements in the 1D array returned by GetData */
+		inline std::size_t get_array_count(const _variant_t& vt_data) {
+			if (!(VT_ARRAY & vt_data.vt))
+				return 0;
+			long lbound = 0, ubound = -1;
+			::SafeArrayGetLBound(vt_data.parray, 1, &lbound);
+			::SafeArrayGetUBound(vt_data.parray, 1, &ubound);
+			long count = ubound - lbound + 1;
+			return count > 0 ? static_cast<std::size_t>(count) : 0;
+		}
+
+		/* Rows to request when reading into a buffer of given capacity */
+		inline long get_rows_to_read(const std::size_t& capacity, const long& rows) {
+			long count = to_non_negative_long(capacity);
+			return (rows >= 0 && rows < count) ? rows : count;
+		}
+
+		template<class T>
+		inline void copy_from_wire(T* dst, const wire_t<T>* src, const std::size_t& count) {
+			if (sizeof(wire_t<T>) == sizeof(T))
+				memcpy(dst, src, count * sizeof(T));
+			else
+				std::copy(src, src + count, dst);
+		}
+
+		/* Vector overloads reuse the capacity of data. Pointer overloads read at most */
+		/* capacity rows and never allocate. Both return number of rows written. */
+
+		/* Returns true if column data must be converted to T, throws if it cannot be */
+		template<class T>
+		bool check_column_read(const COLDATAFORMAT& fmt, bool convert) {
+			if (is_vector_type_compatible<T>(fmt))
+				return false;
+			if (convert && is_convertible_format(fmt))
+				return true;
+			throw std::runtime_error("Incompatible data types");
+		}
+
+		/* Copies count values of the array returned by GetData to data */
+		template<class T>
+		void copy_column_values(T* data, const _variant_t& vt_data, const std::size_t& count, const COLDATAFORMAT& fmt, bool converting) {
+			void* p_val = nullptr;
+			::SafeArrayAccessData(vt_data.parray, &p_val);
+			if (!converting)
+				copy_from_wire(data, static_cast<const wire_t<T>*>(p_val), count);
+			else if (VT_R8 == (vt_data.vt & VT_TYPEMASK)) // Whatever the format, doubles may come back.
+				convert_values(reinterpret_cast<kernel_t<T>*>(data), static_cast<const double*>(p_val), count);
+			else {
+				UINT elem_size = ::SafeArrayGetElemsize(vt_data.parray);
+				visit_native_type(fmt, [&](auto* tag) {
+					using S = typename std::remove_pointer<decltype(tag)>::type;
+					if (sizeof(S) != elem_size) {
+						::SafeArrayUnaccessData(vt_data.parray);
+						throw std::runtime_error("Incompatible data types");
+					}
+					convert_values(reinterpret_cast<kernel_t<T>*>(data), static_cast<const S*>(p_val), count);
+					});
+			}
+			::SafeArrayUnaccessData(vt_data.parray);
+		}
+
+		template<class T>
+		std::size_t get_arithmetic_column_data(const ColumnPtr& col, std::vector<T>& data, const long& offset, const long& rows, bool convert = false) {
+			COLDATAFORMAT fmt = do_get_col_fmt(col);
+			bool converting = check_column_read<T>(fmt, convert);
+			_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_NUMERIC, to_non_negative_long(offset), rows < -1 ? -1 : rows);
+			std::size_t count = get_array_count(vt_data);
+			data.resize(count); // Does not reallocate when capacity suffices.
+			if (count > 0)
+				copy_column_values(data.data(), vt_data, count, fmt, converting);
+			return count;
+		}
+
+		template<class T>
+		std::size_t get_arithmetic_column_data(const ColumnPtr& col, T* data, const std::size_t& capacity, const long& offset, const long& rows, bool convert = false) {
+			COLDATAFORMAT fmt = do_get_col_fmt(col);
+			bool converting = check_column_read<T>(fmt, convert);
+			if (!data || 0 == capacity)
+				return 0;
+			_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_NUMERIC, to_non_negative_long(offset), get_rows_to_read(capacity, rows));
+			std::size_t count = (std::min)(get_array_count(vt_data), capacity);
+			if (count > 0)
+				copy_column_values(data, vt_data, count, fmt, converting);
+			return count;
+		}
+
+		// OrgLab returns pattern below for complex data:
+		// c1.re,c1.im,c2.re,c2.im,c3.re,c3.im, etc.
+		// There will be twice as many values as is needed
+		// for a complex vector since complex has two parts.
+		// Same layout as std::complex<double>.
+		inline void copy_complex_from_wire(std::complex<double>* dst, const double* src, const std::size_t& count) {
+			memcpy(static_cast<void*>(dst), src, count * sizeof(std::complex<double>));
+		}
+
+		inline std::size_t get_complex_column_data(const ColumnPtr& col, std::vector<std::complex<double>>& data, const long& offset, const long& rows) {
+			_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_NUMERIC, to_non_negative_long(offset), rows < -1 ? -1 : rows);
+			std::size_t count = get_array_count(vt_data) / 2;
+			data.resize(count); // Does not reallocate when capacity suffices.
+			if (count > 0) {
+				double* p_val = nullptr;
+				::SafeArrayAccessData(vt_data.parray, (void**)&p_val);
+				copy_complex_from_wire(data.data(), p_val, count);
+				::SafeArrayUnaccessData(vt_data.parray);
+			}
+			return count;
+		}
+
+		inline std::size_t get_complex_column_data(const ColumnPtr& col, std::complex<double>* data, const std::size_t& capacity, const long& offset, const long& rows) {
+			if (!data || 0 == capacity)
+				return 0;
+			_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_NUMERIC, to_non_negative_long(offset), get_rows_to_read(capacity, rows));
+			std::size_t count = (std::min)(get_array_count(vt_data) / 2, capacity);
+			if (count > 0) {
+				double* p_val = nullptr;
+				::SafeArrayAccessData(vt_data.parray, (void**)&p_val);
+				copy_complex_from_wire(data, p_val, count);
+				::SafeArrayUnaccessData(vt_data.parray);
+			}
+			return count;
+		}
+
+		/* Reads text cells with one GetData and no format check */
+		template<class S>
+		void get_bstr_column_data(const ColumnPtr& col, std::vector<S>& data, const long& offset, const long& rows) {
+			CComSafeArray<BSTR> csa;
+			{ // This scope makes sure vt_data is cleaned up quickly for performance.
+				_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_STR, to_non_negative_long(offset), rows < -1 ? -1 : rows);
+				if (VT_ARRAY & vt_data.vt) {
+					csa.Attach(vt_data.parray);
+					vt_data.Detach();
+				}
+				else
+					return;
+			}
+			std::size_t count = csa.GetCount(0);
+			if (0 == count)
+				return;
+			data.resize(count);
+			::SafeArrayLock(csa.m_psa);
+			BSTR* p_csa = (BSTR*)(csa.m_psa->pvData);
+			for (long i = 0; i < count; ++i, p_csa++) {
+				assign_bstr(data[i], *p_csa);
+			}
+			::SafeArrayUnlock(csa.m_psa);
+		}
+
+		inline void get_wstring_column_data(const ColumnPtr& col, std::vector<std::wstring>& data, const long& offset, const long& rows) {
+			if (!is_vector_type_compatible<std::wstring>(do_get_col_fmt(col)))
+				throw std::runtime_error("Incompatible data types");
+			get_bstr_column_data(col, data, offset, rows);
+		}
+
+		inline void get_string_column_data(const ColumnPtr& col, std::vector<std::string>& data, const long& offset, const long& rows) {
+			if (!is_vector_type_compatible<std::wstring>(do_get_col_fmt(col)))
+				throw std::runtime_error("Incompatible data types");
+			get_bstr_column_data(col, data, offset, rows);
+		}
+
+		/* Text cells in one character buffer plus offsets, so cell i is chars()[offsets()[i]] */
+		/* up to chars()[offsets()[i + 1]]. Reading into the same object again reuses both. */
+		template<class C>
+		class basic_string_column {
+		public:
+			using value_type = std::basic_string_view<C>;
+
+			class const_iterator {
+				const basic_string_column* sc_;
+				std::size_t i_;
+			public:
+				const_iterator(const basic_string_column* sc, const std::size_t& i) : sc_(sc), i_(i) {}
+				value_type operator*() const { return (*sc_)[i_]; }
+				const_iterator& operator++() { ++i_; return *this; }
+				bool operator==(const const_iterator& other) const { return i_ == other.i_; }
+				bool operator!=(const const_iterator& other) const { return i_ != other.i_; }
+			};
+
+			basic_string_column() : offsets_(1, 0) {}
+
+			std::size_t size() const { return offsets_.size() - 1; }
+			bool empty() const { return 1 == offsets_.size(); }
+			value_type operator[](const std::size_t& i) const { return value_type(chars_.get() + offsets_[i], offsets_[i + 1] - offsets_[i]); }
+			value_type at(const std::size_t& i) const {
+				if (i >= size())
+					throw std::out_of_range("basic_string_column index out of range");
+				return (*this)[i];
+			}
+			const_iterator begin() const { return const_iterator(this, 0); }
+			const_iterator end() const { return const_iterator(this, size()); }
+
+			const C* chars() const { return chars_.get(); }
+			const std::size_t* offsets() const { return offsets_.data(); }
+			std::size_t length() const { return offsets_.back(); } // Characters in all cells.
+			std::size_t capacity() const { return capacity_; } // Characters the buffer holds.
+
+			/* Empties the column and keeps its memory */
+			void clear() { offsets_.resize(1); }
+
+			/* Empties the column and frees its memory */
+			void release() {
+				chars_.reset();
+				capacity_ = 0;
+				std::vector<std::size_t>(1, 0).swap(offsets_);
+			}
+
+		private:
+			std::unique_ptr<C[]> chars_; // Not value-initialized; every character is written by a read.
+			std::size_t capacity_ = 0;
+			std::vector<std::size_t> offsets_;
+
+			/* Sizes for rows cells and returns the offsets to fill */
+			std::size_t* start(const std::size_t& rows) {
+				offsets_.resize(rows + 1);
+				offsets_[0] = 0;
+				return offsets_.data();
+			}
+
+			/* Makes room for the characters of all cells. Keeps a larger buffer. */
+			C* reserve_chars() {
+				if (offsets_.back() > capacity_) {
+					chars_.reset(new C[offsets_.back()]);
+					capacity_ = offsets_.back();
+				}
+				return chars_.get();
+			}
+
+			template<class D>
+			friend std::size_t get_string_column_data(const ColumnPtr& col, basic_string_column<D>& data, const long& offset, const long& rows);
+		};
+
+		/* Reads text cells into data with one GetData. All cells are sized first, then copied or */
+		/* transcoded straight into the buffer, so a read makes at most two allocations. */
+		template<class C>
+		std::size_t get_string_column_data(const ColumnPtr& col, basic_string_column<C>& data, const long& offset, const long& rows) {
+			static_assert(std::is_same<C, wchar_t>::value || std::is_same<C, char>::value, "Unsupported string_column type");
+			if (!is_vector_type_compatible<std::wstring>(do_get_col_fmt(col)))
+				throw std::runtime_error("Incompatible data types");
+			data.clear();
+			_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_STR, to_non_negative_long(offset), rows < -1 ? -1 : rows);
+			std::size_t count = get_array_count(vt_data);
+			if (0 == count)
+				return 0;
+			BSTR* cells = nullptr;
+			::SafeArrayAccessData(vt_data.parray, (void**)&cells);
+			std::size_t* offsets = data.start(count);
+			for (std::size_t i = 0; i < count; ++i) {
+				std::size_t len = ::SysStringLen(cells[i]);
+				if constexpr (std::is_same<C, char>::value)
+					len = wide_to_utf8_length(cells[i], len);
+				offsets[i + 1] = offsets[i] + len;
+			}
+			C* chars = data.reserve_chars();
+			for (std::size_t i = 0; i < count; ++i) {
+				if constexpr (std::is_same<C, char>::value)
+					wide_to_utf8(chars + offsets[i], cells[i], ::SysStringLen(cells[i]));
+				else if (offsets[i + 1] > offsets[i])
+					memcpy(chars + offsets[i], cells[i], (offsets[i + 1] - offsets[i]) * sizeof(wchar_t));
 			}
+			::SafeArrayUnaccessData(vt_data.parray);
+			return count;
 		}
 
+		/* Text column as a dictionary of distinct values and one code per row indexing it, */
+		/* for columns with few distinct values. S is std::string or std::wstring. */
+		template<class S>
+		class categorical_column {
+			static_assert(std::is_same<S, std::wstring>::value || std::is_same<S, std::string>::value, "Unsupported categorical_column type");
+		public:
+			using string_type = S;
+			using code_type = std::uint32_t;
+
+			std::vector<code_type> codes; // Index into categories() per row.
+
+			/* Distinct values. Added only through push_back and add_category, which keeps */
+			/* them unique and the lookup index in step. */
+			const std::vector<S>& categories() const { return categories_; }
+
+			std::size_t size() const { return codes.size(); }
+			bool empty() const { return codes.empty(); }
+			const S& operator[](const std::size_t& i) const { return categories_[codes[i]]; }
+
+			/* Returns the code of value, adding it to categories() when it is new */
+			code_type add_category(S value) {
+				auto found = index_.try_emplace(value, static_cast<code_type>(categories_.size()));
+				if (found.second)
+					categories_.push_back(std::move(value));
+				return found.first->second;
+			}
+
+			/* Appends a row, adding value to categories() when it is new */
+			void push_back(const S& value) {
+				codes.push_back(add_category(value));
+			}
+
+			/* Empties the column and keeps its memory */
+			void clear() {
+				categories_.clear();
+				codes.clear();
+				index_.clear();
+			}
+
+		private:
+			std::vector<S> categories_;
+			std::unordered_map<S, code_type> index_; // categories_ to their codes.
+		};
+
+		/* Transcodes each category once and copies it into one BSTR per row */
+		template<class S>
+		void pack_categorical_column_data(const categorical_column<S>& data, _variant_t& vt_array) {
+			std::vector<std::wstring> dict;
+			const std::vector<std::wstring>* wide = &dict;
+			if constexpr (std::is_same<S, std::wstring>::value)
+				wide = &data.categories();
+			else {
+				dict.resize(data.categories().size());
+				for (std::size_t i = 0; i < dict.size(); ++i)
+					assign_wide(dict[i], data.categories()[i].data(), data.categories()[i].size());
+			}
+			for (const typename categorical_column<S>::code_type& code : data.codes) {
+				if (code >= wide->size())
+					throw std::runtime_error("Invalid categorical code");
+			}
+			pack_bstr_cells(data.codes.size(), vt_array, [&](const std::size_t& i) {
+				return make_bstr(std::wstring_view((*wide)[data.codes[i]]));
+			});
+		}
+
+		template<class S>
+		void set_categorical_column_data(const ColumnPtr& col, const categorical_column<S>& data, const std::size_t& offset, bool change_type = true) {
+			if (data.empty())
+				return;
+			prepare_column_write<S>(col, change_type, false);
+			_variant_t vt_array;
+			pack_categorical_column_data(data, vt_array);
+			send_column_data(col, vt_array, offset);
+		}
+
+		/* Reads text cells with one GetData, interning them by their BSTR contents so each */
+		/* distinct value is transcoded and stored once */
+		template<class S>
+		std::size_t get_categorical_column_data(const ColumnPtr& col, categorical_column<S>& data, const long& offset, const long& rows) {
+			using code_type = typename categorical_column<S>::code_type;
+			if (!is_vector_type_compatible<std::wstring>(do_get_col_fmt(col)))
+				throw std::runtime_error("Incompatible data types");
+			data.clear();
+			_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_STR, to_non_negative_long(offset), rows < -1 ? -1 : rows);
+			std::size_t count = get_array_count(vt_data);
+			if (0 == count)
+				return 0;
+			BSTR* cells = nullptr;
+			::SafeArrayAccessData(vt_data.parray, (void**)&cells);
+			std::unordered_map<std::wstring_view, code_type> seen; // Views into the cells above.
+			data.codes.resize(count);
+			S value;
+			for (std::size_t i = 0; i < count; ++i) {
+				std::wstring_view cell(cells[i], ::SysStringLen(cells[i]));
+				auto found = seen.try_emplace(cell, 0);
+				if (found.second) {
+					if constexpr (std::is_same<S, std::wstring>::value)
+						value.assign(cell.data(), cell.size());
+					else
+						assign_utf8(value, cell.data(), cell.size());
+					found.first->second = data.add_category(std::move(value));
+				}
+				data.codes[i] = found.first->second;
+			}
+			::SafeArrayUnaccessData(vt_data.parray);
+			return count;
+		}
+
+		inline COLDATAFORMAT do_get_mat_fmt(const MatrixObjectPtr& mat) {
+			return mat->GetDataFormat();
+		}
+
+		inline void do_set_mat_fmt(const MatrixObjectPtr& mat, const COLDATAFORMAT& fmt) {
+			mat->PutDataFormat(fmt);
+		}
+
+		inline void do_set_mat_data(const MatrixObjectPtr& mat, const _variant_t& vt_array, const std::size_t& r1 = 0, const std::size_t& c1 = 0) {
+			try {
+				_variant_t v_r1(to_non_negative_long(r1));
+				_variant_t v_c1(to_non_negative_long(c1));
+				mat->SetData(vt_array, v_r1, v_c1);
+			}
+			catch (...) {
+				throw std::runtime_error("MatrixObjectPtr set data fail");
+			}
+		}
+
+		/* As do_set_mat_data, but returns false if the server refuses the array */
+		inline bool do_try_set_mat_data(const MatrixObjectPtr& mat, const _variant_t& vt_array, const std::size_t& r1 = 0, const std::size_t& c1 = 0) {
+			try {
+				_variant_t v_r1(to_non_negative_long(r1));
+				_variant_t v_c1(to_non_negative_long(c1));
+				mat->SetData(vt_array, v_r1, v_c1);
+				return true;
+			}
+			catch (const _com_error& e) {
+				if (is_zero_copy_refusal(e.Error()))
+					return false;
+				throw std::runtime_error("MatrixObjectPtr set data fail");
+			}
+			catch (...) {
+				throw std::runtime_error("MatrixObjectPtr set data fail");
+			}
+		}
+
+		/* Reads rows r1 to r2 and columns c1 to c2, inclusive. -1 means to the end. */
+		inline _variant_t do_get_mat_data(const MatrixObjectPtr& mat, const ARRAYDATAFORMAT& fmt, const long& r1 = 0, const long& c1 = 0, const long& r2 = -1, const long& c2 = -1) {
+			_variant_t v_r1(r1);
+			_variant_t v_r2(r2);
+			_variant_t v_c1(c1);
+			_variant_t v_c2(c2);
+			_variant_t v_lbound(0);
+			return mat->GetData(v_r1, v_c1, v_r2, v_c2, fmt, v_lbound);
+		}
+
+		/* Largest SetData or GetData payload before a matrix transfer is split into blocks */
+		inline std::atomic<std::size_t>& matrix_block_bytes() {
+			static std::atomic<std::size_t> bytes{ std::size_t(1) << 28 };
+			return bytes;
+		}
+
+		/* Bytes one matrix element takes on the wire */
+		template<class T>
+		constexpr std::size_t matrix_cell_bytes() {
+			if constexpr (std::is_same<T, std::complex<double>>::value)
+				return 2 * sizeof(double);
+			else
+				return sizeof(wire_t<T>);
+		}
+
+		/* Elements per transfer block, also kept within the 32-bit SAFEARRAY bounds */
+		template<class T>
+		std::size_t matrix_block_cells() {
+			std::size_t cells = matrix_block_bytes().load(std::memory_order_relaxed) / matrix_cell_bytes<T>();
+			return (std::max)(std::size_t(1), (std::min)(cells, static_cast<std::size_t>(LONG_MAX)));
+		}
+
+		/* Reads the matrix format and changes it to suit T if change_type. Returns the SAFEARRAY type. */
+		template<class T>
+		VARENUM prepare_matrix_write(const MatrixObjectPtr& mat, bool change_type) {
+			COLDATAFORMAT fmt = do_get_mat_fmt(mat);
+			com_compat_info_t info = get_com_compat_info<T>(fmt, true);
+			if (change_type && (info.first != fmt))
+				do_set_mat_fmt(mat, info.first);
+			return info.second;
+		}
+
+		/* Packs rows r0 to r1 and columns c0 to c1 (exclusive) of a matrix into the array */
+		/* SetData takes, as pack_column_data does */
+		template<class T>
+		void pack_matrix_block(VARENUM vt, const matrix_view<const T>& mv, const std::size_t& r0, const std::size_t& r1, const std::size_t& c0, const std::size_t& c1, _variant_t& vt_array) {
+			std::size_t rows = r1 - r0;
+			std::size_t cols = c1 - c0;
+			matrix_view<const T> src = mv.block(r0, c0, rows, cols);
+			recycle_array(vt_array);
+			try {
+				SAFEARRAYBOUND sa_bounds[2];
+				sa_bounds[0].lLbound = 0;
+				sa_bounds[0].cElements = static_cast<ULONG>(cols); //rows;
+				sa_bounds[1].lLbound = 0;
+				sa_bounds[1].cElements = static_cast<ULONG>(rows); //cols;
+				SAFEARRAY* pSA = create_array(vt, 2, sa_bounds);
+				vt_array.vt = vt | VT_ARRAY;
+				vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
+
+				wire_t<T>* p_vals = nullptr;
+				::SafeArrayAccessData(pSA, (void**)&p_vals);
+				// In recent versions of Origin, MatrixObjectPtr became column major. Hence need to transpose.
+				if (storage_order::col_major == src.order())
+					transpose(p_vals, cols, src.data(), src.stride(), rows, cols);
+				else if (src.stride() == cols)
+					copy_to_wire(p_vals, src.data(), rows * cols); // Already in wire order.
+				else
+					for (std::size_t j = 0; j < rows; ++j)
+						copy_to_wire(p_vals + cols * j, src.data() + src.stride() * j, cols);
+				::SafeArrayUnaccessData(pSA);
+			}
+			catch (...) {
+				recycle_array(vt_array);
+				throw std::runtime_error("MatrixObjectPtr set data fail");
+			}
+		}
+
+		inline void pack_matrix_block(VARENUM vt, const matrix_view<const std::complex<double>>& mv, const std::size_t& r0, const std::size_t& r1, const std::size_t& c0, const std::size_t& c1, _variant_t& vt_array) {
+			std::size_t rows = r1 - r0;
+			std::size_t cols = c1 - c0;
+			matrix_view<const std::complex<double>> src = mv.block(r0, c0, rows, cols);
+			recycle_array(vt_array);
+			try {
+				SAFEARRAYBOUND sa_bounds[3];
+				sa_bounds[0].lLbound = 0;
+				sa_bounds[0].cElements = static_cast<ULONG>(cols); //rows;
+				sa_bounds[1].lLbound = 0;
+				sa_bounds[1].cElements = static_cast<ULONG>(rows); //cols;
+				sa_bounds[2].lLbound = 0;
+				sa_bounds[2].cElements = 2;
+				SAFEARRAY* pSA = create_array(vt, 3, sa_bounds);
+				vt_array.vt = vt | VT_ARRAY;
+				vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
+				double* p_vals = nullptr;
+				::SafeArrayAccessData(pSA, (void**)&p_vals);
+				// In recent versions of Origin, MatrixObjectPtr became column major. Hence need to transpose.
+				// Real plane is first rows*cols values, imaginary plane follows.
+				std::size_t plane = rows * cols;
+				if (storage_order::col_major == src.order())
+					deinterleave_transpose_complex(p_vals, p_vals + plane, src.data(), src.stride(), rows, cols);
+				else
+					for (std::size_t j = 0; j < rows; ++j)
+						deinterleave_complex(p_vals + cols * j, p_vals + plane + cols * j, src.data() + src.stride() * j, cols);
+				::SafeArrayUnaccessData(pSA);
+			}
+			catch (...) {
+				recycle_array(vt_array);
+				throw std::runtime_error("MatrixObjectPtr set data fail");
+			}
+		}
+
+		/* Packs a whole matrix */
+		template<class T>
+		void pack_matrix_data(VARENUM vt, const matrix_view<const T>& mv, _variant_t& vt_array) {
+			pack_matrix_block(vt, mv, 0, mv.rows(), 0, mv.cols(), vt_array);
+		}
+
+		/* True if the matrix goes in a single SetData */
+		template<class T>
+		bool is_single_block(const matrix_view<const T>& mv) {
+			return mv.rows() <= static_cast<std::size_t>(LONG_MAX) && mv.cols() <= static_cast<std::size_t>(LONG_MAX)
+				&& mv.size() <= matrix_block_cells<T>();
+		}
+
+		/* True if the matrix can be sent straight from caller memory: one block, packed row */
+		/* major as SetData takes it and the same layout as the SAFEARRAY. Not complex, which */
+		/* travels as separate planes. */
+		template<class T>
+		bool is_zero_copy_matrix_write(VARENUM vt, const matrix_view<const T>& mv) {
+			if constexpr (std::is_arithmetic<T>::value) {
+				return ORGLAB_DATA_ZC && sizeof(wire_t<T>) == sizeof(T) && vt == get_com_compat_info<T>(COLDATAFORMAT::DF_DOUBLE, true).second
+					&& storage_order::row_major == mv.order() && mv.is_packed() && is_single_block<T>(mv);
+			}
+			else
+				return false;
+		}
+
+		/* Writes a matrix in as few SetData calls as the block size allows. Blocks are runs of */
+		/* whole rows, or pieces of one row when a single row is over the block size. */
+		/* With ORGLAB_DATA_ZERO_COPY, row major data whose layout matches is sent without a */
+		/* copy, falling back as write_column_data does. row and col place the top left element. */
+		template<class T>
+		void write_matrix_data(const MatrixObjectPtr& mat, VARENUM vt, const matrix_view<const T>& mv, const std::size_t& row = 0, const std::size_t& col = 0) {
+			const void* obj = &*mat;
+			bool zero_copy = is_zero_copy_matrix_write<T>(vt, mv) && !zero_copy_refused().has(obj);
+			if (zero_copy) {
+				SAFEARRAYBOUND sa_bounds[2];
+				sa_bounds[0].lLbound = 0;
+				sa_bounds[0].cElements = static_cast<ULONG>(mv.cols());
+				sa_bounds[1].lLbound = 0;
+				sa_bounds[1].cElements = static_cast<ULONG>(mv.rows());
+				_variant_t vt_array;
+				wrap_guard guard{ vt_array };
+				wrap_array(vt, mv.data(), 2, sa_bounds, vt_array);
+				if (do_try_set_mat_data(mat, vt_array, row, col))
+					return;
+			}
+			std::size_t rows = mv.rows(), cols = mv.cols();
+			std::size_t cells = matrix_block_cells<T>();
+			std::size_t block_cols = (std::min)(cols, cells);
+			std::size_t block_rows = (std::min)(rows, (std::min)(cells / block_cols, static_cast<std::size_t>(LONG_MAX)));
+			_variant_t vt_array;
+			recycle_guard guard{ vt_array };
+			for (std::size_t r0 = 0; r0 < rows; r0 += block_rows) {
+				std::size_t r1 = (std::min)(rows, r0 + block_rows);
+				for (std::size_t c0 = 0; c0 < cols; c0 += block_cols) {
+					std::size_t c1 = (std::min)(cols, c0 + block_cols);
+					pack_matrix_block(vt, mv, r0, r1, c0, c1, vt_array);
+					do_set_mat_data(mat, vt_array, row + r0, col + c0);
+				}
+			}
+			if (zero_copy)
+				zero_copy_refused().add(obj);
+		}
+
+		/* Writes mv with its top left element at row, col. It must fit in the matrix. */
+		template<class T>
+		void set_arithmetic_matrix_data(const MatrixObjectPtr& mat, const matrix_view<const T>& mv, bool change_type = true, const std::size_t& row = 0, const std::size_t& col = 0) {
+			if (!mv.data() || 0 == mv.size())
+				return;
+			write_matrix_data(mat, prepare_matrix_write<T>(mat, change_type), mv, row, col);
+		}
+
+		inline void set_complex_matrix_data(const MatrixObjectPtr& mat, const matrix_view<const std::complex<double>>& mv, bool change_type = true, const std::size_t& row = 0, const std::size_t& col = 0) {
+			if (!mv.data() || 0 == mv.size())
+				return;
+			write_matrix_data(mat, prepare_matrix_write<std::complex<double>>(mat, change_type), mv, row, col);
+		}
+
+		/* Writes the dirty regions of ma, or all of it when it is not tracking, and clears */
+		/* its marks. Returns number of elements sent. */
+		template<class T, storage_order O>
+		std::size_t sync_dirty_matrix_data(const MatrixObjectPtr& mat, matrix_adapter<T, O>& ma, bool change_type = true) {
+			matrix_view<const T> mv(static_cast<const matrix_adapter<T, O>&>(ma));
+			if (!mv.data() || 0 == mv.size())
+				return 0;
+			if (0 == ma.dirty_tile()) {
+				write_matrix_data(mat, prepare_matrix_write<T>(mat, change_type), mv);
+				return mv.size();
+			}
+			if (!ma.is_dirty())
+				return 0;
+			VARENUM vt = prepare_matrix_write<T>(mat, change_type);
+			std::size_t sent = 0;
+			ma.dirty_regions([&](const std::size_t& row, const std::size_t& col, const std::size_t& rows, const std::size_t& cols) {
+				write_matrix_data(mat, vt, mv.block(row, col, rows, cols), row, col);
+				sent += rows * cols;
+			});
+			ma.clear_dirty();
+			return sent;
+		}
+
+		/* Rows and columns of the array returned by GetData. Matrix is column major. */
+		inline bool get_matrix_dims(const _variant_t& vt_data, std::size_t& rows, std::size_t& cols) {
+			rows = cols = 0;
+			if (!(VT_ARRAY & vt_data.vt))
+				return false;
+			long lbound1 = 0, ubound1 = -1, lbound2 = 0, ubound2 = -1;
+			::SafeArrayGetLBound(vt_data.parray, 1, &lbound1);
+			::SafeArrayGetUBound(vt_data.parray, 1, &ubound1);
+			::SafeArrayGetLBound(vt_data.parray, 2, &lbound2);
+			::SafeArrayGetUBound(vt_data.parray, 2, &ubound2);
+			long long count1 = static_cast<long long>(ubound1) - lbound1 + 1;
+			long long count2 = static_cast<long long>(ubound2) - lbound2 + 1;
+			if (count1 < 1 || count2 < 1)
+				return false;
+			rows = static_cast<std::size_t>(count1);
+			cols = static_cast<std::size_t>(count2);
+			return true;
+		}
+
+		/* Two parts- 1st is real part, 2nd is imaginary part. */
+		inline bool get_complex_matrix_dims(const _variant_t& vt_data, std::size_t& rows, std::size_t& cols) {
+			if (!get_matrix_dims(vt_data, rows, cols))
+				return false;
+			long lbound3 = 0, ubound3 = -1;
+			::SafeArrayGetLBound(vt_data.parray, 3, &lbound3);
+			::SafeArrayGetUBound(vt_data.parray, 3, &ubound3);
+			return ubound3 - lbound3 + 1 > 0;
+		}
+
+		template<class T>
+		bool get_block_dims(const _variant_t& vt_data, std::size_t& rows, std::size_t& cols) {
+			if constexpr (std::is_same<T, std::complex<double>>::value)
+				return get_complex_matrix_dims(vt_data, rows, cols);
+			else
+				return get_matrix_dims(vt_data, rows, cols);
+		}
+
+		/* Despite ARRAY2D_NUMERIC, 3D array is returned for complex. */
+		/* First rows*cols values are real parts, next rows*cols are imaginary parts. */
+		inline void copy_complex_matrix_from_wire(std::complex<double>* dst, const double* src, const std::size_t& count) {
+			interleave_complex(dst, src, src + count, count);
+		}
+
+		/* Copies a GetData array of dst.rows() x dst.cols() into dst */
+		template<class T>
+		void copy_matrix_block_from_wire(const matrix_view<T>& dst, const _variant_t& vt_data) {
+			std::size_t rows = dst.rows(), cols = dst.cols(), ldd = dst.stride();
+			bool col_major = storage_order::col_major == dst.order();
+			if constexpr (std::is_same<T, std::complex<double>>::value) {
+				double* p_val = nullptr;
+				::SafeArrayAccessData(vt_data.parray, (void**)&p_val);
+				if (!col_major)
+					interleave_transpose_complex(dst.data(), ldd, p_val, p_val + rows * cols, rows, cols);
+				else if (ldd == rows)
+					copy_complex_matrix_from_wire(dst.data(), p_val, rows * cols);
+				else
+					for (std::size_t k = 0; k < cols; ++k)
+						interleave_complex(dst.data() + ldd * k, p_val + rows * k, p_val + rows * cols + rows * k, rows);
+				::SafeArrayUnaccessData(vt_data.parray);
+			}
+			else {
+				wire_t<T>* p_val = nullptr;
+				::SafeArrayAccessData(vt_data.parray, (void**)&p_val);
+				if (!col_major)
+					transpose(dst.data(), ldd, p_val, rows, rows, cols); // Column major wire read as row major.
+				else if (ldd == rows)
+					copy_from_wire(dst.data(), p_val, rows * cols);
+				else
+					for (std::size_t k = 0; k < cols; ++k)
+						copy_from_wire(dst.data() + ldd * k, p_val + rows * k, rows);
+				::SafeArrayUnaccessData(vt_data.parray);
+			}
+		}
+
+		/* Number of rows, or of columns if !rows, found without reading the whole matrix. */
+		/* Reads the first column (row) and, if the server fails that too, searches with */
+		/* single-element reads, which come back empty past the end. */
+		template<class T>
+		std::size_t probe_matrix_extent(const MatrixObjectPtr& mat, bool rows) {
+			std::size_t n_rows = 0, n_cols = 0;
+			try {
+				if (get_block_dims<T>(do_get_mat_data(mat, ARRAYDATAFORMAT::ARRAY2D_NUMERIC, 0, 0, rows ? -1 : 0, rows ? 0 : -1), n_rows, n_cols))
+					return rows ? n_rows : n_cols;
+				return 0;
+			}
+			catch (...) {}
+			auto has = [&](const std::size_t& i) {
+				long at = to_non_negative_long(i);
+				return get_block_dims<T>(do_get_mat_data(mat, ARRAYDATAFORMAT::ARRAY2D_NUMERIC, rows ? at : 0, rows ? 0 : at, rows ? at : 0, rows ? 0 : at), n_rows, n_cols);
+			};
+			if (!has(0))
+				return 0;
+			std::size_t lo = 0, hi = 1; // lo is inside, hi is past the end once found.
+			while (hi < static_cast<std::size_t>(LONG_MAX) && has(hi)) {
+				lo = hi;
+				hi *= 2;
+			}
+			while (hi - lo > 1) {
+				std::size_t mid = lo + (hi - lo) / 2;
+				(has(mid) ? lo : hi) = mid;
+			}
+			return lo + 1;
+		}
+
+		/* Window extent meaning to the last row or column of the matrix */
+		constexpr std::size_t matrix_to_end = static_cast<std::size_t>(-1);
+
+		/* Last row or column GetData takes for a window of n from first */
+		inline long window_last(const std::size_t& first, const std::size_t& n) {
+			return matrix_to_end == n ? -1 : to_non_negative_long(first + n - 1);
+		}
+
+		/* Reads the window of rows x cols at row, col (the whole matrix by default) into the */
+		/* matrix_view dest(rows, cols) returns, skipping the copy if that is null. GetData */
+		/* clips the window to the matrix. One GetData of the window is tried first. If the */
+		/* server fails it, dimensions are probed where not given and the window is read in */
+		/* blocks of whole columns, or pieces of one column when a column is over the block */
+		/* size. Returns the number of elements written. */
+		template<class T, class F>
+		std::size_t read_matrix_data(const MatrixObjectPtr& mat, F&& dest, const std::size_t& row = 0, const std::size_t& col = 0,
+			const std::size_t& n_rows = matrix_to_end, const std::size_t& n_cols = matrix_to_end) {
+			if (0 == n_rows || 0 == n_cols)
+				return 0;
+			std::size_t rows = 0, cols = 0;
+			_variant_t vt_data;
+			bool whole = true;
+			try {
+				vt_data = do_get_mat_data(mat, ARRAYDATAFORMAT::ARRAY2D_NUMERIC, to_non_negative_long(row), to_non_negative_long(col),
+					window_last(row, n_rows), window_last(col, n_cols));
+			}
+			catch (...) {
+				whole = false;
+			}
+			if (whole) {
+				// There can be no empty matrix object in Origin- always have at least 1x1.
+				if (!get_block_dims<T>(vt_data, rows, cols))
+					return 0;
+				matrix_view<T> data = dest(rows, cols);
+				if (!data.data())
+					return 0;
+				copy_matrix_block_from_wire(data, vt_data);
+				return rows * cols;
+			}
+			rows = n_rows;
+			cols = n_cols;
+			if (matrix_to_end == rows) {
+				std::size_t extent = probe_matrix_extent<T>(mat, true);
+				rows = extent > row ? extent - row : 0;
+			}
+			if (matrix_to_end == cols) {
+				std::size_t extent = probe_matrix_extent<T>(mat, false);
+				cols = extent > col ? extent - col : 0;
+			}
+			if (!rows || !cols)
+				return 0;
+			matrix_view<T> data = dest(rows, cols);
+			if (!data.data())
+				return 0;
+			std::size_t cells = matrix_block_cells<T>();
+			std::size_t block_rows = (std::min)(rows, cells);
+			std::size_t block_cols = (std::min)(cols, cells / block_rows);
+			for (std::size_t c0 = 0; c0 < cols; c0 += block_cols) {
+				std::size_t c1 = (std::min)(cols, c0 + block_cols);
+				for (std::size_t r0 = 0; r0 < rows; r0 += block_rows) {
+					std::size_t r1 = (std::min)(rows, r0 + block_rows);
+					vt_data = do_get_mat_data(mat, ARRAYDATAFORMAT::ARRAY2D_NUMERIC, to_non_negative_long(row + r0), to_non_negative_long(col + c0),
+						to_non_negative_long(row + r1 - 1), to_non_negative_long(col + c1 - 1));
+					std::size_t got_rows = 0, got_cols = 0;
+					if (!get_block_dims<T>(vt_data, got_rows, got_cols) || got_rows != r1 - r0 || got_cols != c1 - c0)
+						throw std::runtime_error("MatrixObjectPtr get data fail");
+					copy_matrix_block_from_wire(data.block(r0, c0, got_rows, got_cols), vt_data);
+				}
+			}
+			return rows * cols;
+		}
+
+		/* Reads the window of rows x cols at row, col, the whole matrix by default, resizing ma */
+		/* to what GetData returns. A whole read leaves nothing dirty. */
+		template<class T, storage_order O>
+		void get_arithmetic_matrix_data(const MatrixObjectPtr& mat, matrix_adapter<T, O>& ma, const std::size_t& row = 0, const std::size_t& col = 0,
+			const std::size_t& rows = matrix_to_end, const std::size_t& cols = matrix_to_end) {
+			if (!is_vector_type_compatible<T>(do_get_mat_fmt(mat)))
+				throw std::runtime_error("Incompatible data types");
+			read_matrix_data<T>(mat, [&](const std::size_t& r, const std::size_t& c) {
+				ma.resize_for_overwrite(r, c); // Reuses storage when re-reading same size.
+				return matrix_view<T>(ma);
+			}, row, col, rows, cols);
+			if (0 == row && 0 == col && matrix_to_end == rows && matrix_to_end == cols)
+				ma.clear_dirty();
+		}
+
+		/* Writes column major data if capacity suffices and returns element count, else 0. */
+		/* rows and cols receive matrix dimensions either way. */
+		template<class T>
+		std::size_t get_arithmetic_matrix_data(const MatrixObjectPtr& mat, T* data, const std::size_t& capacity, std::size_t& rows, std::size_t& cols) {
+			if (!is_vector_type_compatible<T>(do_get_mat_fmt(mat)))
+				throw std::runtime_error("Incompatible data types");
+			rows = cols = 0;
+			return read_matrix_data<T>(mat, [&](const std::size_t& r, const std::size_t& c) {
+				rows = r;
+				cols = c;
+				return matrix_view<T>(r * c <= capacity ? data : nullptr, r, c);
+			});
+		}
+
+		/* Reads into view if the window (the whole matrix by default) has its dimensions and */
+		/* returns element count, else 0 */
+		template<class T>
+		std::size_t get_arithmetic_matrix_data(const MatrixObjectPtr& mat, const matrix_view<T>& view, const std::size_t& row = 0, const std::size_t& col = 0,
+			const std::size_t& rows = matrix_to_end, const std::size_t& cols = matrix_to_end) {
+			if (!is_vector_type_compatible<T>(do_get_mat_fmt(mat)))
+				throw std::runtime_error("Incompatible data types");
+			return read_matrix_data<T>(mat, [&](const std::size_t& r, const std::size_t& c) {
+				return r == view.rows() && c == view.cols() ? view : matrix_view<T>();
+			}, row, col, rows, cols);
+		}
+
+		template<storage_order O>
+		void get_complex_matrix_data(const MatrixObjectPtr& mat, matrix_adapter<std::complex<double>, O>& ma, const std::size_t& row = 0, const std::size_t& col = 0,
+			const std::size_t& rows = matrix_to_end, const std::size_t& cols = matrix_to_end) {
+			read_matrix_data<std::complex<double>>(mat, [&](const std::size_t& r, const std::size_t& c) {
+				ma.resize_for_overwrite(r, c); // Reuses storage when re-reading same size.
+				return matrix_view<std::complex<double>>(ma);
+			}, row, col, rows, cols);
+			if (0 == row && 0 == col && matrix_to_end == rows && matrix_to_end == cols)
+				ma.clear_dirty();
+		}
+
+		inline std::size_t get_complex_matrix_data(const MatrixObjectPtr& mat, std::complex<double>* data, const std::size_t& capacity, std::size_t& rows, std::size_t& cols) {
+			rows = cols = 0;
+			return read_matrix_data<std::complex<double>>(mat, [&](const std::size_t& r, const std::size_t& c) {
+				rows = r;
+				cols = c;
+				return matrix_view<std::complex<double>>(r * c <= capacity ? data : nullptr, r, c);
+			});
+		}
+
+		inline std::size_t get_complex_matrix_data(const MatrixObjectPtr& mat, const matrix_view<std::complex<double>>& view, const std::size_t& row = 0, const std::size_t& col = 0,
+			const std::size_t& rows = matrix_to_end, const std::size_t& cols = matrix_to_end) {
+			return read_matrix_data<std::complex<double>>(mat, [&](const std::size_t& r, const std::size_t& c) {
+				return r == view.rows() && c == view.cols() ? view : matrix_view<std::complex<double>>();
+			}, row, col, rows, cols);
+		}
+
+		/* Narrows read dimensions for the unsigned short overloads */
+		inline void check_unsigned_short_dims(const std::size_t& rows, const std::size_t& cols) {
+			if (rows > (std::numeric_limits<unsigned short>::max)() || cols > (std::numeric_limits<unsigned short>::max)())
+				throw std::runtime_error("Matrix dimensions exceed unsigned short");
+		}
+
+		//// COLUMN WRITER ////
+
+		/* When a column_writer flushes by itself. Zero disables a trigger. */
+		/* interval is checked on push, there is no background thread. */
+		struct flush_policy {
+			std::size_t rows = 65536;
+			std::size_t bytes = 1 << 20;
+			std::chrono::milliseconds interval{ 0 };
+		};
+
+		/* Bytes a pending value adds to a flush */
+		template<class T>
+		std::size_t pending_bytes(const T&) { return sizeof(T); }
+		template<class C>
+		std::size_t pending_bytes(const std::basic_string<C>& str) { return sizeof(BSTR) + str.size() * sizeof(OLECHAR); }
+
+		/* Rows column_writer destructors dropped because their final flush failed */
+		inline std::atomic<std::uint64_t>& column_writer_dropped_rows() {
+			static std::atomic<std::uint64_t> rows{ 0 };
+			return rows;
+		}
+
+		/* Appends rows to a column in batches. Tracks the next row to write, reuses */
+		/* its buffer between flushes and reads the column format only on the first flush. */
+		/* Pending rows are flushed on destruction; call flush() first to see errors. Rows */
+		/* a failed final flush drops are counted in column_writer_dropped_rows(). */
+		template<class T>
+		class column_writer {
+			static_assert(std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value ||
+				std::is_same<T, std::wstring>::value || std::is_same<T, std::string>::value, "Unsupported column_writer type");
+		public:
+			column_writer(const ColumnPtr& col, const std::size_t& offset = 0, const flush_policy& policy = flush_policy())
+				: col_(col), policy_(policy), offset_(offset) {
+				if (!col_)
+					throw std::runtime_error("ColumnPtr is invalid");
+			}
+			column_writer(const column_writer&) = delete;
+			column_writer& operator=(const column_writer&) = delete;
+			column_writer(column_writer&& other) noexcept
+				: col_(std::move(other.col_)), policy_(other.policy_), format_(other.format_), prepared_(other.prepared_),
+				buf_(std::move(other.buf_)), bytes_(other.bytes_), offset_(other.offset_), first_push_(other.first_push_) {
+				other.buf_.clear();
+				other.bytes_ = 0;
+			}
+			~column_writer() {
+				try {
+					flush();
+				}
+				catch (...) {
+					column_writer_dropped_rows().fetch_add(buf_.size(), std::memory_order_relaxed);
+				}
+			}
+
+			column_writer& push(const T& value) {
+				if (buf_.empty())
+					start_batch();
+				buf_.push_back(value);
+				bytes_ += pending_bytes(value);
+				return flush_if_due();
+			}
+
+			column_writer& push(const T* data, const std::size_t& rows) {
+				if (!data || 0 == rows)
+					return *this;
+				if (buf_.empty() && policy_.rows && rows >= policy_.rows) { // Large bursts skip the buffer.
+					write(data, rows);
+					return *this;
+				}
+				if (buf_.empty())
+					start_batch();
+				buf_.insert(buf_.end(), data, data + rows);
+				for (std::size_t i = 0; i < rows; ++i)
+					bytes_ += pending_bytes(data[i]);
+				return flush_if_due();
+			}
+
+			template<class A>
+			column_writer& push(const std::vector<T, A>& data) {
+				return push(data.data(), data.size());
+			}
+
+			/* Writes pending rows with one SetData */
+			column_writer& flush() {
+				if (!buf_.empty()) {
+					write(buf_.data(), buf_.size());
+					buf_.clear(); // Keeps capacity for the next batch.
+					bytes_ = 0;
+				}
+				return *this;
+			}
+
+			/* Drops pending rows without writing them */
+			column_writer& discard() {
+				buf_.clear();
+				bytes_ = 0;
+				return *this;
+			}
+
+			/* Row the next pushed value lands at */
+			std::size_t offset() const { return offset_ + buf_.size(); }
+
+			/* Rows pushed but not yet written */
+			std::size_t pending() const { return buf_.size(); }
+
+			const ColumnPtr& column() const { return col_; }
+
+		private:
+			void start_batch() {
+				if (policy_.interval.count() > 0)
+					first_push_ = std::chrono::steady_clock::now();
+				if (0 == buf_.capacity() && policy_.rows)
+					buf_.reserve((std::min)(policy_.rows, policy_.bytes ? policy_.bytes / sizeof(T) + 1 : policy_.rows));
+			}
+
+			column_writer& flush_if_due() {
+				if ((policy_.rows && buf_.size() >= policy_.rows) || (policy_.bytes && bytes_ >= policy_.bytes) ||
+					(policy_.interval.count() > 0 && std::chrono::steady_clock::now() - first_push_ >= policy_.interval))
+					flush();
+				return *this;
+			}
+
+			void write(const T* data, const std::size_t& rows) {
+				if (!prepared_) {
+					format_ = prepare_column_write<T>(col_, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT);
+					prepared_ = true;
+				}
+				write_column_data(col_, format_, data, rows, offset_);
+				offset_ += rows;
+			}
+
+			ColumnPtr col_;
+			flush_policy policy_;
+			column_write_format format_{};
+			bool prepared_ = false;
+			std::vector<T> buf_;
+			std::size_t bytes_ = 0;
+			std::size_t offset_;
+			std::chrono::steady_clock::time_point first_push_;
+		};
+
+		//// COLUMN SYNC ////
+
+		/* 64-bit hash of n bytes, continuing from h. Four independent lanes of 8 bytes */
+		/* keep the multiplier busy. Not cryptographic. */
+		inline std::uint64_t hash_bytes(const void* data, const std::size_t& n, std::uint64_t h = 0x9E3779B97F4A7C15ull) {
+			const unsigned char* p = static_cast<const unsigned char*>(data);
+			const std::uint64_t m = 0xFF51AFD7ED558CCDull;
+			auto mix = [&](std::uint64_t a, const unsigned char* q) {
+				std::uint64_t w;
+				std::memcpy(&w, q, 8);
+				a = (a ^ w) * m;
+				return a ^ (a >> 29);
+			};
+			std::size_t i = 0;
+			if (n >= 32) {
+				std::uint64_t a = h, b = h + m, c = h ^ 0xC4CEB9FE1A85EC53ull, d = ~h;
+				for (; i + 32 <= n; i += 32) {
+					a = mix(a, p + i);
+					b = mix(b, p + i + 8);
+					c = mix(c, p + i + 16);
+					d = mix(d, p + i + 24);
+				}
+				h = a ^ (b << 1 | b >> 63) ^ (c << 2 | c >> 62) ^ (d << 3 | d >> 61);
+			}
+			for (; i + 8 <= n; i += 8)
+				h = mix(h, p + i);
+			std::uint64_t w = 0;
+			std::memcpy(&w, p + i, n - i);
+			h = (h ^ w ^ n) * 0xC4CEB9FE1A85EC53ull;
+			return h ^ (h >> 29);
+		}
+
+		/* Fingerprint of rows values */
+		template<class T>
+		std::uint64_t hash_rows(const T* data, const std::size_t& rows) {
+			return hash_bytes(data, rows * sizeof(T));
+		}
+		template<class C>
+		std::uint64_t hash_rows(const std::basic_string<C>* data, const std::size_t& rows) {
+			std::uint64_t h = 0x9E3779B97F4A7C15ull;
+			for (std::size_t i = 0; i < rows; ++i)
+				h = hash_bytes(data[i].data(), data[i].size() * sizeof(C), h); // Mixes in the length too.
+			return h;
+		}
+
+		/* Distinct address per type, to tell mirrors of different types apart */
+		template<class T>
+		const void* sync_type_tag() {
+			static const char tag = 0;
+			return &tag;
+		}
+
+		/* Rows of T that column_sync clears per SetData, so a large shrink stays bounded */
+		template<class T>
+		constexpr std::size_t sync_clear_rows() {
+			return (std::size_t(8) << 20) / sizeof(T);
+		}
+
+		/* What column_sync clears a removed row to: missing for floating point and complex, */
+		/* empty for text and 0 for integer types, which have no missing value */
+		template<class T>
+		T sync_cleared_value() {
+			if constexpr (std::is_floating_point<T>::value)
+				return std::numeric_limits<T>::quiet_NaN();
+			else if constexpr (std::is_same<T, std::complex<double>>::value)
+				return T(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN());
+			else
+				return T();
+		}
+
+		/* Counters of a column_sync. Bytes are what the rows take in caller memory. */
+		struct column_sync_stats {
+			std::uint64_t syncs = 0;
+			std::uint64_t writes = 0; // SetData calls.
+			std::uint64_t rows_written = 0;
+			std::uint64_t rows_skipped = 0;
+			std::uint64_t rows_cleared = 0; // Rows past the end of data that a shorter sync cleared.
+			std::uint64_t bytes_written = 0;
+			std::uint64_t bytes_skipped = 0;
+		};
+
+		/* Remembers what was last written to each column as one hash per block of rows, */
+		/* so syncing a local mirror sends only the runs of blocks that changed, each with */
+		/* one SetData at its offset. Keeps the columns it has seen alive; forget() one */
+		/* changed by other means. Runs up to gap_blocks unchanged blocks apart go as one */
+		/* SetData, trading resent rows for round-trips. Not thread safe. */
+		/* Mirrors are keyed by the column object, not the column: fetching a column again */
+		/* can give another object, with its own mirror, and syncing one column through two */
+		/* can skip rows the other changed. Reuse one ColumnPtr per column, or forget() the */
+		/* old one first. */
+		class column_sync {
+		public:
+			explicit column_sync(const std::size_t& block_rows = 1024, const std::size_t& gap_blocks = 0)
+				: block_rows_((std::max)(block_rows, std::size_t(1))), gap_blocks_(gap_blocks) {}
+
+			/* Writes rows of data at offset where they differ from the last sync of col, */
+			/* all of them the first time. If the last sync had more rows, the rows past the */
+			/* end of data are overwritten, in SetData calls of up to 8 MiB: with missing */
+			/* values, empty text, or 0 for integer T, which cannot be told from real zeros. */
+			/* The column keeps its length either way. Returns number of rows of data written. */
+			template<class T>
+			std::size_t sync(const ColumnPtr& col, const T* data, const std::size_t& rows, const std::size_t& offset = 0) {
+				static_assert(std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value ||
+					std::is_same<T, std::wstring>::value || std::is_same<T, std::string>::value, "Unsupported column_sync type");
+				if (!col)
+					throw std::runtime_error("ColumnPtr is invalid");
+				++stats_.syncs;
+				if (!data && 0 != rows)
+					return 0;
+				std::size_t blocks = (rows + block_rows_ - 1) / block_rows_;
+				next_.resize(blocks);
+				for (std::size_t b = 0; b < blocks; ++b) {
+					std::size_t r0 = b * block_rows_;
+					next_[b] = hash_rows(data + r0, (std::min)(rows, r0 + block_rows_) - r0);
+				}
+				mirror& m = mirrors_[&*col];
+				bool known = m.col && m.type == sync_type_tag<T>() && m.offset == offset;
+				if (!known)
+					m.hashes.clear();
+				std::size_t same = (std::min)(m.hashes.size(), blocks); // Hashes mix in lengths, so a resized last block differs.
+				auto bytes = [&](const std::size_t& r0, const std::size_t& r1) {
+					if constexpr (std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value)
+						return (r1 - r0) * sizeof(T);
+					else {
+						std::size_t n = 0;
+						for (std::size_t i = r0; i < r1; ++i)
+							n += pending_bytes(data[i]);
+						return n;
+					}
+				};
+				std::size_t written = 0, written_bytes = 0;
+				bool prepared = false;
+				column_write_format wf{};
+				try {
+					auto changed = [&](const std::size_t& b) { return b >= same || m.hashes[b] != next_[b]; };
+					for (std::size_t b = 0; b < blocks;) {
+						if (!changed(b)) {
+							++b;
+							continue;
+						}
+						std::size_t e = b + 1;
+						for (;;) {
+							while (e < blocks && changed(e))
+								++e;
+							std::size_t g = e;
+							while (g < blocks && g - e < gap_blocks_ && !changed(g))
+								++g;
+							if (g == e || g == blocks || !changed(g))
+								break;
+							e = g;
+						}
+						if (!prepared) {
+							wf = prepare_column_write<T>(col, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT);
+							prepared = true;
+						}
+						std::size_t r0 = b * block_rows_, r1 = (std::min)(rows, e * block_rows_);
+						write_column_data(col, wf, data + r0, r1 - r0, offset + r0);
+						++stats_.writes;
+						written += r1 - r0;
+						written_bytes += bytes(r0, r1);
+						b = e;
+					}
+					if (known && m.rows > rows) {
+						if (!prepared)
+							wf = prepare_column_write<T>(col, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT);
+						std::size_t tail = m.rows - rows;
+						std::vector<T> cleared((std::min)(tail, sync_clear_rows<T>()), sync_cleared_value<T>());
+						for (std::size_t r0 = rows; r0 < m.rows; r0 += cleared.size()) {
+							write_column_data(col, wf, cleared.data(), (std::min)(cleared.size(), m.rows - r0), offset + r0);
+							++stats_.writes;
+						}
+						stats_.rows_cleared += tail;
+					}
+				}
+				catch (...) {
+					mirrors_.erase(&*col); // What the column holds is unknown.
+					throw;
+				}
+				m.col = col;
+				m.type = sync_type_tag<T>();
+				m.offset = offset;
+				m.rows = rows;
+				m.hashes.swap(next_);
+				stats_.rows_written += written;
+				stats_.rows_skipped += rows - written;
+				stats_.bytes_written += written_bytes;
+				stats_.bytes_skipped += bytes(0, rows) - written_bytes;
+				return written;
+			}
+
+			template<class T, class A>
+			std::size_t sync(const ColumnPtr& col, const std::vector<T, A>& data, const std::size_t& offset = 0) {
+				return sync(col, data.data(), data.size(), offset);
+			}
+
+			/* Drops what is known of col, so its next sync writes everything */
+			column_sync& forget(const ColumnPtr& col) {
+				if (col)
+					mirrors_.erase(&*col);
+				return *this;
+			}
+
+			/* Drops every column */
+			column_sync& clear() {
+				mirrors_.clear();
+				return *this;
+			}
+
+			/* Number of columns mirrored */
+			std::size_t size() const { return mirrors_.size(); }
+
+			std::size_t block_rows() const { return block_rows_; }
+
+			std::size_t gap_blocks() const { return gap_blocks_; }
+
+			column_sync_stats stats() const { return stats_; }
+
+			void reset_stats() { stats_ = column_sync_stats(); }
+
+		private:
+			struct mirror {
+				ColumnPtr col; // Keeps the key address from being reused.
+				const void* type = nullptr;
+				std::size_t offset = 0;
+				std::size_t rows = 0; // Rows last synced, cleared if a later sync has fewer.
+				std::vector<std::uint64_t> hashes;
+			};
+
+			std::size_t block_rows_;
+			std::size_t gap_blocks_;
+			std::unordered_map<const void*, mirror> mirrors_;
+			std::vector<std::uint64_t> next_; // Reused between syncs.
+			column_sync_stats stats_;
+		};
+
+		//// WORKSHEET BLOCKS ////
+
+		/* 2D worksheet data uses the layouts of MatrixObject data, which the matrix code has */
+		/* always relied on: SetData takes rows x cols values stored row by row, with */
+		/* dimension 1 (fastest) the columns; GetData returns them column by column, with */
+		/* dimension 1 the rows. Both sides below follow it, and the benchmark checks it */
+		/* against the server it runs on before timing anything. */
+
+		/* One column of a block write. Type-erased so a table of mixed types is one list. */
+		struct block_column {
+			const void* data;
+			std::size_t rows;
+			bool blockable; // Complex columns have no 2D form and are written on their own.
+			VARENUM vt; // SAFEARRAY type when the column format is not read.
+			column_write_format(*prepare)(const ColumnPtr& col, bool change_type, bool convert);
+			void (*fill)(void* dst, const void* src, const std::size_t& col, const std::size_t& cols, const std::size_t& r0, const std::size_t& r1);
+			void (*write)(const ColumnPtr& col, const column_write_format& wf, const void* data, const std::size_t& rows, const std::size_t& offset);
+		};
+
+		template<class T>
+		block_column make_block_column(const T* data, const std::size_t& rows) {
+			static_assert(std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value || is_string_cell<T>::value, "Unsupported column type");
+			block_column bc;
+			bc.data = data;
+			bc.rows = data ? rows : 0;
+			bc.blockable = !std::is_same<T, std::complex<double>>::value;
+			bc.vt = get_com_compat_info<T>(COLDATAFORMAT::DF_DOUBLE).second;
+			bc.prepare = &prepare_column_write<T>;
+			// Stores rows r0 to r1 of column col in a row major block of cols columns.
+			bc.fill = [](void* dst, const void* src, const std::size_t& col, const std::size_t& cols, const std::size_t& r0, const std::size_t& r1) {
+				const T* in = static_cast<const T*>(src);
+				if constexpr (std::is_arithmetic<T>::value) {
+					wire_t<T>* out = static_cast<wire_t<T>*>(dst) + col;
+					for (std::size_t r = r0; r < r1; ++r)
+						out[cols * r] = static_cast<wire_t<T>>(in[r]);
+				}
+				else if constexpr (!std::is_same<T, std::complex<double>>::value) {
+					BSTR* out = static_cast<BSTR*>(dst) + col;
+					for (std::size_t r = r0; r < r1; ++r)
+						out[cols * r] = make_bstr(in[r]); // SAFEARRAY frees them.
+				}
+			};
+			bc.write = [](const ColumnPtr& col, const column_write_format& wf, const void* data, const std::size_t& rows, const std::size_t& offset) {
+				write_column_data(col, wf, static_cast<const T*>(data), rows, offset);
+			};
+			return bc;
+		}
+
+		template<class T, class A>
+		block_column make_block_column(const std::vector<T, A>& data) {
+			return make_block_column(data.data(), data.size());
+		}
+
+#ifdef ORGLAB_DATA_HAS_SPAN
+		template<class T, std::size_t E>
+		block_column make_block_column(const std::span<T, E>& data) {
+			return make_block_column(static_cast<const typename std::remove_const<T>::type*>(data.data()), data.size());
+		}
+#endif
+
+		/* Writes count columns of the same SAFEARRAY type and row count with one SetData, */
+		/* row by row as SetData takes them */
+		inline void set_worksheet_block(const WorksheetPtr& wks, const VARENUM& vt, const block_column* cols, const std::size_t& count, const std::size_t& first_col, const std::size_t& offset) {
+			const std::size_t block_rows = 256; // Keeps the strided stores of every column in cache.
+			std::size_t rows = cols[0].rows;
+			SAFEARRAYBOUND sa_bounds[2];
+			sa_bounds[0].lLbound = 0;
+			sa_bounds[0].cElements = static_cast<unsigned long>(to_non_negative_long(count));
+			sa_bounds[1].lLbound = 0;
+			sa_bounds[1].cElements = static_cast<unsigned long>(to_non_negative_long(rows));
+			SAFEARRAY* pSA = ::SafeArrayCreate(vt, 2, sa_bounds);
+			if (!pSA)
+				throw std::runtime_error("WorksheetPtr set data fail");
+			_variant_t vt_array;
+			vt_array.vt = vt | VT_ARRAY;
+			vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
+			void* p_vals = nullptr;
+			::SafeArrayAccessData(pSA, &p_vals);
+			for (std::size_t r0 = 0; r0 < rows; r0 += block_rows) {
+				std::size_t r1 = (std::min)(rows, r0 + block_rows);
+				for (std::size_t k = 0; k < count; ++k)
+					cols[k].fill(p_vals, cols[k].data, k, count, r0, r1);
+			}
+			::SafeArrayUnaccessData(pSA);
+			do_set_wks_data(wks, vt_array, to_non_negative_long(offset), to_non_negative_long(first_col));
+		}
+
+		/* Column pointers and write formats set_worksheet_data resolved for one worksheet, */
+		/* by column index, so later writes of the same types skip the lookups */
+		struct worksheet_formats {
+			long cols = 0; // Columns the worksheet is known to have.
+			std::vector<ColumnPtr> ptrs;
+			std::vector<column_write_format(*)(const ColumnPtr&, bool, bool)> prepared; // Identifies T.
+			std::vector<column_write_format> formats;
+		};
+
+		/* Writes count columns from first_col at row offset. Column formats are resolved in */
+		/* one pass before any data moves, then each run of adjacent columns with the same */
+		/* SAFEARRAY type and row count goes as one 2D SetData. Complex columns and columns */
+		/* converted to their native type are written one by one. With change_type or */
+		/* convert each column costs a Columns::Item and a GetDataFormat (2N + 3 calls for N */
+		/* double columns) unless cache already holds it; without, no column is looked up. */
+		inline void set_worksheet_data(const WorksheetPtr& wks, const block_column* cols, const std::size_t& count, const std::size_t& first_col, const std::size_t& offset, bool change_type = true, bool convert = false, worksheet_formats* cache = nullptr) {
+			if (0 == count)
+				return;
+			long last = to_non_negative_long(first_col + count);
+			if (!cache || cache->cols < last) {
+				long have = do_get_wks_cols(wks);
+				if (have < last)
+					do_set_wks_cols(wks, last);
+				if (cache)
+					cache->cols = (std::max)(have, last);
+			}
+			worksheet_formats local;
+			worksheet_formats& known = cache ? *cache : local;
+			if (known.ptrs.size() < first_col + count) {
+				known.ptrs.resize(first_col + count);
+				known.prepared.resize(first_col + count);
+				known.formats.resize(first_col + count);
+			}
+			ColumnsPtr columns;
+			auto column_at = [&](const std::size_t& i) -> const ColumnPtr& {
+				ColumnPtr& ptr = known.ptrs[first_col + i];
+				if (!ptr) {
+					if (!columns)
+						columns = do_get_wks_columns(wks);
+					ptr = do_get_wks_col(columns, to_non_negative_long(first_col + i));
+				}
+				return ptr;
+			};
+			std::vector<column_write_format> formats(count);
+			for (std::size_t i = 0; i < count; ++i) {
+				if (0 == cols[i].rows)
+					continue;
+				if (change_type || convert) {
+					std::size_t k = first_col + i;
+					if (known.prepared[k] != cols[i].prepare) {
+						known.prepared[k] = nullptr; // Unknown until prepare returns.
+						known.formats[k] = cols[i].prepare(column_at(i), change_type, convert);
+						known.prepared[k] = cols[i].prepare;
+					}
+					formats[i] = known.formats[k];
+				}
+				else
+					formats[i] = column_write_format{ COLDATAFORMAT::DF_DOUBLE, cols[i].vt, false };
+			}
+			for (std::size_t i = 0; i < count;) {
+				if (0 == cols[i].rows) {
+					++i;
+					continue;
+				}
+				if (!cols[i].blockable || formats[i].converting) {
+					cols[i].write(column_at(i), formats[i], cols[i].data, cols[i].rows, offset);
+					++i;
+					continue;
+				}
+				std::size_t j = i + 1;
+				while (j < count && cols[j].blockable && !formats[j].converting && cols[j].rows == cols[i].rows && formats[j].vt == formats[i].vt)
+					++j;
+				set_worksheet_block(wks, formats[i].vt, cols + i, j - i, first_col + i, offset);
+				i = j;
+			}
+		}
+
+		/* Writes tables to one worksheet as set_worksheet_data does, remembering its column */
+		/* pointers and formats, so a later write of the same types to the same columns is */
+		/* the SetData calls alone. After columns are removed or their formats changed by */
+		/* other means, call forget(). Not thread safe. */
+		class worksheet_writer {
+		public:
+			explicit worksheet_writer(const WorksheetPtr& wks) : wks_(wks) {
+				if (!wks_)
+					throw std::runtime_error("WorksheetPtr is invalid");
+			}
+
+			template<class... C>
+			void set_data(const std::tuple<C...>& cols, const std::size_t& first_col = 0, const std::size_t& offset = 0) {
+				block_column bc[sizeof...(C) > 0 ? sizeof...(C) : 1];
+				std::size_t i = 0;
+				std::apply([&](const auto&... col) { ((bc[i++] = make_block_column(col)), ...); }, cols);
+				set_worksheet_data(wks_, bc, sizeof...(C), first_col, offset, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT, &known_);
+			}
+
+			template<class T>
+			void set_data(const std::vector<std::vector<T>>& cols, const std::size_t& first_col = 0, const std::size_t& offset = 0) {
+				std::vector<block_column> bc;
+				bc.reserve(cols.size());
+				for (const std::vector<T>& col : cols)
+					bc.push_back(make_block_column(col));
+				set_worksheet_data(wks_, bc.data(), bc.size(), first_col, offset, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT, &known_);
+			}
+
+#ifdef ORGLAB_DATA_HAS_SPAN
+			template<class T>
+			void set_data(const std::vector<std::span<const T>>& cols, const std::size_t& first_col = 0, const std::size_t& offset = 0) {
+				std::vector<block_column> bc;
+				bc.reserve(cols.size());
+				for (const std::span<const T>& col : cols)
+					bc.push_back(make_block_column(col));
+				set_worksheet_data(wks_, bc.data(), bc.size(), first_col, offset, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT, &known_);
+			}
+#endif
+
+			/* Drops what is known of the worksheet, so the next write looks everything up */
+			worksheet_writer& forget() {
+				known_ = worksheet_formats();
+				return *this;
+			}
+
+			const WorksheetPtr& worksheet() const { return wks_; }
+
+		private:
+			WorksheetPtr wks_;
+			worksheet_formats known_;
+		};
+
+		/* Columns first to last of a worksheet range read with one GetData, column by */
+		/* column as GetData returns them */
+		struct worksheet_block {
+			_variant_t data;
+			std::size_t first = 0;
+			std::size_t rows = 0;
+			std::size_t cols = 0;
+		};
+
+		inline worksheet_block get_worksheet_block(const WorksheetPtr& wks, const ARRAYDATAFORMAT& fmt, const std::size_t& first, const std::size_t& last, const long& offset, const long& rows) {
+			worksheet_block b;
+			b.first = first;
+			if (0 == rows)
+				return b;
+			long r1 = to_non_negative_long(offset);
+			long r2 = rows < 0 ? -1 : to_non_negative_long(static_cast<std::size_t>(r1) + rows - 1);
+			b.data = do_get_wks_data(wks, fmt, r1, to_non_negative_long(first), r2, to_non_negative_long(last));
+			if ((VT_ARRAY & b.data.vt) && 2 == ::SafeArrayGetDim(b.data.parray)) {
+				long lbound = 0, ubound = -1;
+				::SafeArrayGetLBound(b.data.parray, 1, &lbound);
+				::SafeArrayGetUBound(b.data.parray, 1, &ubound);
+				b.rows = ubound >= lbound ? static_cast<std::size_t>(ubound - lbound + 1) : 0;
+				::SafeArrayGetLBound(b.data.parray, 2, &lbound);
+				::SafeArrayGetUBound(b.data.parray, 2, &ubound);
+				b.cols = ubound >= lbound ? static_cast<std::size_t>(ubound - lbound + 1) : 0;
+			}
+			return b;
+		}
+
+		/* True if the block came back as the array its kind reads: doubles for numeric, */
+		/* BSTRs for text */
+		inline bool is_block_type(const worksheet_block& b, const VARENUM& vt) {
+			return 0 == b.rows || (VT_ARRAY & b.data.vt && vt == (b.data.vt & VT_TYPEMASK));
+		}
+
+		/* Throws if a column of format fmt cannot be read as T, as the column reads check */
+		template<class T>
+		void check_block_column(const COLDATAFORMAT& fmt) {
+			if constexpr (std::is_arithmetic<T>::value)
+				check_column_read<T>(fmt, ORGLAB_DATA_CVT);
+			else if (!is_vector_type_compatible<T>(fmt))
+				throw std::runtime_error("Incompatible data types");
+		}
+
+		/* Copies worksheet column col of a block into data. Numeric blocks hold doubles, */
+		/* converted to T. With trim, trailing missing values and empty cells, which the */
+		/* block pads short columns with, are left out. */
+		template<class T>
+		void copy_block_column(std::vector<T>& data, const worksheet_block& b, const std::size_t& col, bool trim) {
+			data.clear();
+			if (col < b.first || col >= b.first + b.cols || 0 == b.rows)
+				return;
+			void* p_val = nullptr;
+			::SafeArrayAccessData(b.data.parray, &p_val);
+			std::size_t start = (col - b.first) * b.rows;
+			std::size_t n = b.rows;
+			if constexpr (std::is_arithmetic<T>::value) {
+				const double* in = static_cast<const double*>(p_val) + start;
+				while (trim && n > 0 && std::isnan(in[n - 1]))
+					--n;
+				data.resize(n); // Does not reallocate when capacity suffices.
+				if constexpr (std::is_same<T, double>::value)
+					memcpy(data.data(), in, n * sizeof(double));
+				else
+					convert_values(reinterpret_cast<kernel_t<T>*>(data.data()), in, n);
+			}
+			else {
+				const BSTR* cells = static_cast<const BSTR*>(p_val) + start;
+				while (trim && n > 0 && 0 == ::SysStringLen(cells[n - 1]))
+					--n;
+				data.resize(n);
+				for (std::size_t i = 0; i < n; ++i)
+					assign_bstr(data[i], cells[i]);
+			}
+			::SafeArrayUnaccessData(b.data.parray);
+		}
+
+		/* Reads a column of each type in cols from first_col. Numeric columns come from one */
+		/* ARRAY2D_NUMERIC GetData and text columns from one ARRAY2D_STR GetData, each over */
+		/* the columns between the first and last of that kind. Complex columns, and every */
+		/* column of a kind whose block is not the expected array type, are read one by one. */
+		/* A block holds only doubles or BSTRs, so column formats are not known: numbers are */
+		/* converted to T whatever the column type. With ORGLAB_DATA_CHECK_BLOCK_FORMATS each */
+		/* column's format is read and checked as get_column_data does, at two more */
+		/* round-trips per column and one for the Columns collection. A fixed window of rows */
+		/* comes back whole. Reading to the end (rows < 0), each column is cut at its last */
+		/* value, since the padding of a short column looks like missing values or empty cells. */
+		template<class... T>
+		void get_worksheet_data(const WorksheetPtr& wks, std::tuple<std::vector<T>...>& cols, const std::size_t& first_col, const long& offset, const long& rows) {
+			const bool numeric[] = { std::is_arithmetic<T>::value... };
+			const bool text[] = { (std::is_same<T, std::wstring>::value || std::is_same<T, std::string>::value)... };
+			auto span = [](const bool* kind, std::size_t& lo, std::size_t& hi) {
+				lo = sizeof...(T);
+				hi = 0;
+				for (std::size_t k = 0; k < sizeof...(T); ++k) {
+					if (kind[k]) {
+						lo = (std::min)(lo, k);
+						hi = k;
+					}
+				}
+				return lo < sizeof...(T);
+			};
+			worksheet_block num, str;
+			std::size_t lo = 0, hi = 0;
+			if (span(numeric, lo, hi))
+				num = get_worksheet_block(wks, ARRAYDATAFORMAT::ARRAY2D_NUMERIC, first_col + lo, first_col + hi, offset, rows);
+			if (span(text, lo, hi))
+				str = get_worksheet_block(wks, ARRAYDATAFORMAT::ARRAY2D_STR, first_col + lo, first_col + hi, offset, rows);
+			bool num_ok = is_block_type(num, VT_R8), str_ok = is_block_type(str, VT_BSTR);
+			ColumnsPtr columns;
+			auto column_at = [&](const std::size_t& col) {
+				if (!columns)
+					columns = do_get_wks_columns(wks);
+				return do_get_wks_col(columns, to_non_negative_long(col));
+			};
+			std::size_t k = 0;
+			auto read = [&](auto& data) {
+				using V = typename std::decay<decltype(data)>::type::value_type;
+				std::size_t col = first_col + k++;
+				if constexpr (std::is_same<V, std::complex<double>>::value)
+					get_complex_column_data(column_at(col), data, offset, rows);
+				else {
+					const worksheet_block& b = std::is_arithmetic<V>::value ? num : str;
+					if (col >= b.first + b.cols) // Past the last column, or no rows.
+						data.clear();
+					else if (!(std::is_arithmetic<V>::value ? num_ok : str_ok)) {
+						if constexpr (std::is_arithmetic<V>::value)
+							get_arithmetic_column_data<V>(column_at(col), data, offset, rows, ORGLAB_DATA_CVT);
+						else if constexpr (std::is_same<V, std::wstring>::value)
+							get_wstring_column_data(column_at(col), data, offset, rows);
+						else
+							get_string_column_data(column_at(col), data, offset, rows);
+					}
+					else {
+						if (ORGLAB_DATA_CBF)
+							check_block_column<V>(do_get_col_fmt(column_at(col)));
+						copy_block_column(data, b, col, rows < 0);
+					}
+				}
+			};
+			std::apply([&](auto&... data) { (read(data), ...); }, cols);
+		}
+
+		/* Reads cols columns from first_col into one column major frame with one GetData. */
+		/* Formats are checked only with ORGLAB_DATA_CHECK_BLOCK_FORMATS, as in */
+		/* get_worksheet_data. Short columns and columns past the last one are padded with */
+		/* missing values (0 for integer T). */
+		template<class T>
+		std::size_t get_worksheet_frame(const WorksheetPtr& wks, std::vector<T>& frame, std::size_t& frame_rows, const std::size_t& first_col, const std::size_t& cols, const long& offset, const long& rows) {
+			frame_rows = 0;
+			frame.clear();
+			if (0 == cols)
+				return 0;
+			worksheet_block b = get_worksheet_block(wks, ARRAYDATAFORMAT::ARRAY2D_NUMERIC, first_col, first_col + cols - 1, offset, rows);
+			if (0 == b.rows)
+				return 0;
+			if (!is_block_type(b, VT_R8))
+				throw std::runtime_error("Incompatible data types");
+			std::size_t present = (std::min)(b.cols, cols);
+			if (ORGLAB_DATA_CBF) {
+				ColumnsPtr columns = do_get_wks_columns(wks);
+				for (std::size_t k = 0; k < present; ++k)
+					check_block_column<T>(do_get_col_fmt(do_get_wks_col(columns, to_non_negative_long(first_col + k))));
+			}
+			frame_rows = b.rows;
+			frame.resize(b.rows * cols); // Columns past the last one are left missing.
+			std::fill(frame.begin() + b.rows * present, frame.end(), convert_value<kernel_t<T>>(std::numeric_limits<double>::quiet_NaN()));
+			void* p_val = nullptr;
+			::SafeArrayAccessData(b.data.parray, &p_val);
+			std::size_t count = b.rows * present;
+			if constexpr (std::is_same<T, double>::value)
+				memcpy(frame.data(), p_val, count * sizeof(double));
+			else
+				convert_values(reinterpret_cast<kernel_t<T>*>(frame.data()), static_cast<const double*>(p_val), count);
+			::SafeArrayUnaccessData(b.data.parray);
+			return frame.size();
+		}
+
+		//// COLUMN READER ////
+
+		/* Rows of a column starting at offset */
+		template<class T>
+		struct column_chunk {
+			std::size_t offset = 0;
+			std::vector<T> data;
+		};
+
+		/* Format of a column checked once for every chunk read from it */
+		struct chunk_format {
+			COLDATAFORMAT fmt{};
+			bool converting = false;
+		};
+
+		/* One GetDataFormat, none for complex columns which are read as pairs of doubles */
+		template<class T>
+		chunk_format check_chunk_format(const ColumnPtr& col) {
+			chunk_format format;
+			if constexpr (std::is_arithmetic<T>::value) {
+				format.fmt = do_get_col_fmt(col);
+				format.converting = check_column_read<T>(format.fmt, ORGLAB_DATA_CVT);
+			}
+			else if constexpr (!std::is_same<T, std::complex<double>>::value) {
+				format.fmt = do_get_col_fmt(col);
+				if (!is_vector_type_compatible<std::wstring>(format.fmt))
+					throw std::runtime_error("Incompatible data types");
+			}
+			return format;
+		}
+
+		/* Reads up to rows rows into data reusing its capacity with one GetData and the format */
+		/* from check_chunk_format. Returns number of rows read. */
+		template<class T>
+		std::size_t read_column_chunk(const ColumnPtr& col, std::vector<T>& data, const long& offset, const long& rows, const chunk_format& format) {
+			_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_NUMERIC, to_non_negative_long(offset), rows < -1 ? -1 : rows);
+			std::size_t count = get_array_count(vt_data);
+			data.resize(count); // Does not reallocate when capacity suffices.
+			if (count > 0)
+				copy_column_values(data.data(), vt_data, count, format.fmt, format.converting);
+			return count;
+		}
+
+		inline std::size_t read_column_chunk(const ColumnPtr& col, std::vector<std::complex<double>>& data, const long& offset, const long& rows, const chunk_format&) {
+			return get_complex_column_data(col, data, offset, rows);
+		}
+
+		inline std::size_t read_column_chunk(const ColumnPtr& col, std::vector<std::wstring>& data, const long& offset, const long& rows, const chunk_format&) {
+			data.clear();
+			get_bstr_column_data(col, data, offset, rows);
+			return data.size();
+		}
+
+		inline std::size_t read_column_chunk(const ColumnPtr& col, std::vector<std::string>& data, const long& offset, const long& rows, const chunk_format&) {
+			data.clear();
+			get_bstr_column_data(col, data, offset, rows);
+			return data.size();
+		}
+
+		/* Reads up to rows rows into data reusing its capacity. Returns number of rows read. */
+		template<class T>
+		std::size_t read_column_chunk(const ColumnPtr& col, std::vector<T>& data, const long& offset, const long& rows) {
+			return read_column_chunk(col, data, offset, rows, check_chunk_format<T>(col));
+		}
+
+		/* Walks rows of a column in chunks of chunk_rows. The format is checked once when the */
+		/* reader is built and each chunk then costs one GetData. With prefetch, a worker thread */
+		/* in its own multithreaded apartment reads chunk N+1 while chunk N is processed, so at */
+		/* most two chunks are resident. A chunk stays valid until the next one is requested. */
+		template<class T>
+		class column_reader {
+			static_assert(std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value ||
+				std::is_same<T, std::wstring>::value || std::is_same<T, std::string>::value, "Unsupported column_reader type");
+		public:
+			class iterator {
+				column_reader* reader_;
+				const column_chunk<T>* chunk_;
+			public:
+				using iterator_category = std::input_iterator_tag;
+				using value_type = column_chunk<T>;
+				using difference_type = std::ptrdiff_t;
+				using pointer = const column_chunk<T>*;
+				using reference = const column_chunk<T>&;
+				iterator(column_reader* reader, const column_chunk<T>* chunk) : reader_(reader), chunk_(chunk) {}
+				reference operator*() const { return *chunk_; }
+				pointer operator->() const { return chunk_; }
+				iterator& operator++() { chunk_ = reader_->next(); return *this; }
+				bool operator==(const iterator& other) const { return chunk_ == other.chunk_; }
+				bool operator!=(const iterator& other) const { return chunk_ != other.chunk_; }
+			};
+
+			/* rows -1 reads to the end of the column */
+			column_reader(const ColumnPtr& col, const std::size_t& chunk_rows = 65536, const long& offset = 0, const long& rows = -1, bool prefetch = true)
+				: col_(col), chunk_rows_(chunk_rows ? to_non_negative_long(chunk_rows) : 1), next_offset_(to_non_negative_long(offset)), remaining_(rows < 0 ? -1 : rows) {
+				if (!col_)
+					throw std::runtime_error("ColumnPtr is invalid");
+				if (0 == remaining_) {
+					done_ = true;
+					return;
+				}
+				format_ = check_chunk_format<T>(col_);
+				if (prefetch) {
+					marshaled_column marshaled(col_);
+					request_ = true; // First chunk.
+					worker_ = std::thread([this, &marshaled]() { run(marshaled); });
+					std::unique_lock<std::mutex> lock(mtx_);
+					cv_.wait(lock, [this]() { return started_; }); // Until marshaled is consumed.
+				}
+			}
+			column_reader(const column_reader&) = delete;
+			column_reader& operator=(const column_reader&) = delete;
+			~column_reader() {
+				if (worker_.joinable()) {
+					{
+						std::lock_guard<std::mutex> lock(mtx_);
+						stop_ = true;
+					}
+					cv_.notify_all();
+					worker_.join();
+				}
+			}
+
+			/* Returns the next chunk, or nullptr past the last one. Rethrows read errors. */
+			const column_chunk<T>* next() {
+				if (done_)
+					return nullptr;
+				long want = chunk_request();
+				std::size_t count = 0;
+				if (worker_.joinable()) {
+					std::unique_lock<std::mutex> lock(mtx_);
+					cv_.wait(lock, [this]() { return ready_; });
+					ready_ = false;
+					if (error_) {
+						done_ = true;
+						std::rethrow_exception(error_);
+					}
+					std::swap(front_.data, back_);
+					count = front_.data.size();
+				}
+				else
+					count = read_column_chunk(col_, front_.data, static_cast<long>(next_offset_), want, format_);
+				front_.offset = next_offset_;
+				next_offset_ += count;
+				if (remaining_ > 0)
+					remaining_ -= static_cast<long>(count);
+				if (count < static_cast<std::size_t>(want) || 0 == remaining_)
+					done_ = true; // Short read is the end of the column.
+				else if (worker_.joinable()) {
+					{
+						std::lock_guard<std::mutex> lock(mtx_);
+						request_ = true;
+					}
+					cv_.notify_all();
+				}
+				return count ? &front_ : nullptr;
+			}
+
+			iterator begin() { return iterator(this, next()); }
+			iterator end() { return iterator(this, nullptr); }
+
+		private:
+			long chunk_request() const {
+				return (remaining_ >= 0 && remaining_ < chunk_rows_) ? remaining_ : chunk_rows_;
+			}
+
+			void run(marshaled_column& marshaled) {
+				std::size_t offset = next_offset_;
+				long want = chunk_request();
+				long remaining = remaining_;
+				::CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+				{
+					ColumnPtr col;
+					try {
+						col = marshaled.get();
+					}
+					catch (...) {
+						error_ = std::current_exception();
+					}
+					{
+						std::lock_guard<std::mutex> lock(mtx_);
+						started_ = true;
+					}
+					cv_.notify_all();
+					for (;;) {
+						{
+							std::unique_lock<std::mutex> lock(mtx_);
+							cv_.wait(lock, [this]() { return request_ || stop_; });
+							if (stop_)
+								break;
+							request_ = false;
+						}
+						if (!error_) {
+							try {
+								std::size_t count = read_column_chunk(col, back_, static_cast<long>(offset), want, format_);
+								offset += count;
+								if (remaining > 0)
+									remaining -= static_cast<long>(count);
+								want = (remaining >= 0 && remaining < want) ? remaining : want;
+							}
+							catch (...) {
+								error_ = std::current_exception();
+							}
+						}
+						{
+							std::lock_guard<std::mutex> lock(mtx_);
+							ready_ = true;
+						}
+						cv_.notify_all();
+					}
+				}
+				::CoUninitialize();
+			}
+
+			ColumnPtr col_;
+			long chunk_rows_;
+			std::size_t next_offset_;
+			long remaining_;
+			chunk_format format_;
+			bool done_ = false;
+			column_chunk<T> front_;
+			std::vector<T> back_;
+			std::thread worker_;
+			std::mutex mtx_;
+			std::condition_variable cv_;
+			bool started_ = false;
+			bool request_ = false;
+			bool ready_ = false;
+			bool stop_ = false;
+			std::exception_ptr error_;
+		};
+
+		//// ASYNC TRANSFERS ////
+		// A transfer_worker owns two threads. The packing thread builds the SAFEARRAY of the next
+		// write while the transfer thread, in its own multithreaded apartment, is in the round-trip
+		// of the previous one. Transfers run one at a time in submission order, so transfers to the
+		// same column or matrix never overtake one another.
+
+		/* One queued transfer. pack runs on the packing thread and makes no COM calls; run */
+		/* runs on the transfer thread and completes the transfer. */
+		class transfer_job {
+		public:
+			virtual ~transfer_job() = default;
+			virtual void pack() {}
+			virtual void run() = 0;
+			virtual void fail(std::exception_ptr error) = 0;
+
+			void cancel() { cancelled_ = true; }
+			bool cancelled() const { return cancelled_; }
+
+			/* Calls f on the transfer thread when the transfer completes. Returns false, */
+			/* without calling f, if it already has. */
+			bool then(std::function<void()> f) {
+				std::lock_guard<std::mutex> lock(mtx_);
+				if (done_)
+					return false;
+				then_ = std::move(f);
+				return true;
+			}
+
+			bool done() {
+				std::lock_guard<std::mutex> lock(mtx_);
+				return done_;
+			}
+
+			std::exception_ptr pack_error;
+
+		protected:
+			void finished() {
+				std::function<void()> f;
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+					done_ = true;
+					f.swap(then_);
+				}
+				if (f)
+					f();
+			}
+
+		private:
+			std::atomic<bool> cancelled_{ false };
+			std::mutex mtx_;
+			bool done_ = false;
+			std::function<void()> then_;
+		};
+
+		template<class R>
+		class result_job : public transfer_job {
+		public:
+			using result_type = R;
+			std::future<R> get_future() { return promise_.get_future(); }
+			void fail(std::exception_ptr error) override {
+				promise_.set_exception(error);
+				finished();
+			}
+
+		protected:
+			template<class... A>
+			void complete(A&&... result) {
+				promise_.set_value(std::forward<A>(result)...);
+				finished();
+			}
+
+		private:
+			std::promise<R> promise_;
+		};
+
+		/* SAFEARRAY type a write of T is packed as before the format is known. Runs that find */
+		/* another format, for example a date column or conversion, repack on the transfer thread. */
+		template<class T>
+		VARENUM guess_write_vt(bool is_matrix) {
+			return get_com_compat_info<T>(COLDATAFORMAT::DF_DOUBLE, is_matrix).second;
+		}
+
+		template<class T>
+		class set_column_job : public result_job<void> {
+		public:
+			set_column_job(const ColumnPtr& col, std::vector<T>&& data, const std::size_t& offset)
+				: col_(col), data_(std::move(data)), offset_(offset) {}
+			~set_column_job() {
+				recycle_array(packed_);
+			}
+			void pack() override {
+				column_write_format guess{ COLDATAFORMAT::DF_DOUBLE, guess_write_vt<T>(false), false };
+				if (!data_.empty() && !is_zero_copy_write<T>(guess)) // Zero-copy writes need no packing.
+					pack_column_data(guess, data_.data(), data_.size(), packed_);
+			}
+			void run() override {
+				ColumnPtr col = col_.get();
+				if (!data_.empty()) {
+					column_write_format wf = prepare_column_write<T>(col, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT);
+					if (VT_EMPTY != packed_.vt && !wf.converting && wf.vt == guess_write_vt<T>(false))
+						send_column_data(col, packed_, offset_);
+					else
+						write_column_data(col, wf, data_.data(), data_.size(), offset_);
+				}
+				recycle_array(packed_);
+				std::vector<T>().swap(data_);
+				complete();
+			}
+
+		private:
+			marshaled_column col_;
+			std::vector<T> data_;
+			std::size_t offset_;
+			_variant_t packed_;
+		};
+
+		template<class T>
+		class get_column_job : public result_job<std::vector<T>> {
+		public:
+			get_column_job(const ColumnPtr& col, const long& offset, const long& rows)
+				: col_(col), offset_(offset), rows_(rows) {}
+			void run() override {
+				std::vector<T> data;
+				read_column_chunk(col_.get(), data, offset_, rows_);
+				this->complete(std::move(data));
+			}
+
+		private:
+			marshaled_column col_;
+			long offset_;
+			long rows_;
+		};
+
+		template<class T, storage_order O>
+		class set_matrix_job : public result_job<void> {
+		public:
+			set_matrix_job(const MatrixObjectPtr& mat, matrix_adapter<T, O>&& ma)
+				: mat_(mat), ma_(std::move(ma)) {}
+			~set_matrix_job() {
+				recycle_array(packed_);
+			}
+			void pack() override {
+				if (ma_.data() && ma_.size() && is_single_block<T>(ma_) && !is_zero_copy_matrix_write<T>(guess_write_vt<T>(true), ma_))
+					pack_matrix_data<T>(guess_write_vt<T>(true), ma_, packed_);
+			}
+			void run() override {
+				MatrixObjectPtr mat = mat_.get();
+				if (ma_.data() && ma_.size()) {
+					VARENUM vt = prepare_matrix_write<T>(mat, ORGLAB_DATA_CDT);
+					if (!(VT_ARRAY & packed_.vt))
+						write_matrix_data<T>(mat, vt, ma_); // Over one block or zero-copy.
+					else {
+						if (vt != guess_write_vt<T>(true))
+							pack_matrix_data<T>(vt, ma_, packed_);
+						do_set_mat_data(mat, packed_);
+					}
+				}
+				recycle_array(packed_);
+				ma_ = matrix_adapter<T, O>();
+				complete();
+			}
+
+		private:
+			marshaled_ptr<MatrixObjectPtr> mat_;
+			matrix_adapter<T, O> ma_;
+			_variant_t packed_;
+		};
+
+		template<class T, storage_order O>
+		class get_matrix_job : public result_job<matrix_adapter<T, O>> {
+		public:
+			explicit get_matrix_job(const MatrixObjectPtr& mat) : mat_(mat) {}
+			void run() override {
+				matrix_adapter<T, O> ma;
+				if constexpr (std::is_arithmetic<T>::value)
+					get_arithmetic_matrix_data<T>(mat_.get(), ma);
+				else
+					get_complex_matrix_data(mat_.get(), ma);
+				this->complete(std::move(ma));
+			}
+
+		private:
+			marshaled_ptr<MatrixObjectPtr> mat_;
+		};
+
+		/* Result of an asynchronous transfer. A std::future that can also be cancelled and, */
+		/* with C++20 coroutines, awaited. */
+		template<class R>
+		class transfer : public std::future<R> {
+		public:
+			transfer() = default;
+			transfer(std::future<R>&& result, std::shared_ptr<transfer_job> job)
+				: std::future<R>(std::move(result)), job_(std::move(job)) {}
+
+			/* Drops the transfer if it has not started; get() then throws. No effect otherwise. */
+			void cancel() {
+				if (job_)
+					job_->cancel();
+			}
+
+#ifdef ORGLAB_DATA_HAS_COROUTINE
+			/* The awaiting coroutine resumes on the transfer thread. Keep what follows short, */
+			/* or hand it off, since later transfers wait behind it. */
+			bool await_ready() const {
+				return this->wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+			}
+			bool await_suspend(std::coroutine_handle<> h) {
+				return job_->then([h]() { h.resume(); });
+			}
+			R await_resume() {
+				return this->get();
+			}
+#endif
+
+		private:
+			std::shared_ptr<transfer_job> job_;
+		};
+
+		/* Runs transfers on an owned thread in a multithreaded apartment; the caller does not */
+		/* need to call CoInitializeEx for it. Pointers are marshaled from the calling thread, */
+		/* which must itself be in an apartment. Data is taken by value and owned by the transfer. */
+		/* The destructor finishes queued transfers; call cancel() first to drop them. */
+		class transfer_worker {
+		public:
+			transfer_worker() {
+				packer_ = std::thread([this]() { pack_loop(); });
+				try {
+					transport_ = std::thread([this]() { transport_loop(); });
+				}
+				catch (...) {
+					shut_down();
+					throw;
+				}
+			}
+			transfer_worker(const transfer_worker&) = delete;
+			transfer_worker& operator=(const transfer_worker&) = delete;
+			~transfer_worker() {
+				shut_down();
+			}
+
+			/* Cancels every transfer that has not started */
+			void cancel() {
+				std::lock_guard<std::mutex> lock(mtx_);
+				for (const std::shared_ptr<transfer_job>& job : to_pack_)
+					job->cancel();
+				for (const std::shared_ptr<transfer_job>& job : to_run_)
+					job->cancel();
+			}
+
+			template<class T>
+			transfer<void> set_column_data(const ColumnPtr& col, std::vector<T> data, const std::size_t& offset = 0) {
+				static_assert(std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value ||
+					std::is_same<T, std::wstring>::value || std::is_same<T, std::string>::value, "Unsupported column type");
+				if (!col)
+					throw std::runtime_error("ColumnPtr is invalid");
+				return submit(std::make_shared<set_column_job<T>>(col, std::move(data), offset));
+			}
+
+			template<class T>
+			transfer<std::vector<T>> get_column_data(const ColumnPtr& col, const long& offset = 0, const long& rows = -1) {
+				static_assert(std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value ||
+					std::is_same<T, std::wstring>::value || std::is_same<T, std::string>::value, "Unsupported column type");
+				if (!col)
+					throw std::runtime_error("ColumnPtr is invalid");
+				return submit(std::make_shared<get_column_job<T>>(col, offset, rows));
+			}
+
+			template<class T, storage_order O>
+			transfer<void> set_matrix_data(const MatrixObjectPtr& mat, matrix_adapter<T, O> ma) {
+				static_assert(std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value, "Unsupported matrix type");
+				if (!mat)
+					throw std::runtime_error("MatrixObjectPtr is invalid");
+				return submit(std::make_shared<set_matrix_job<T, O>>(mat, std::move(ma)));
+			}
+
+			template<class T, storage_order O = storage_order::col_major>
+			transfer<matrix_adapter<T, O>> get_matrix_data(const MatrixObjectPtr& mat) {
+				static_assert(std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value, "Unsupported matrix type");
+				if (!mat)
+					throw std::runtime_error("MatrixObjectPtr is invalid");
+				return submit(std::make_shared<get_matrix_job<T, O>>(mat));
+			}
+
+		private:
+			/* Packed writes waiting for the transfer thread. Bounds memory held by packed arrays. */
+			static const std::size_t max_packed = 2;
+
+			template<class J>
+			transfer<typename J::result_type> submit(std::shared_ptr<J> job) {
+				transfer<typename J::result_type> result(job->get_future(), job);
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+					to_pack_.push_back(std::move(job));
+				}
+				cv_.notify_all();
+				return result;
+			}
+
+			void shut_down() {
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+					stop_ = true;
+				}
+				cv_.notify_all();
+				if (packer_.joinable())
+					packer_.join();
+				if (transport_.joinable())
+					transport_.join();
+			}
+
+			void pack_loop() {
+				for (;;) {
+					std::shared_ptr<transfer_job> job;
+					{
+						std::unique_lock<std::mutex> lock(mtx_);
+						cv_.wait(lock, [this]() { return (!to_pack_.empty() && to_run_.size() < max_packed) || (stop_ && to_pack_.empty()); });
+						if (to_pack_.empty())
+							break;
+						job = std::move(to_pack_.front());
+						to_pack_.pop_front();
+						packing_ = true;
+					}
+					if (!job->cancelled()) {
+						try {
+							job->pack();
+						}
+						catch (...) {
+							job->pack_error = std::current_exception();
+						}
+					}
+					{
+						std::lock_guard<std::mutex> lock(mtx_);
+						to_run_.push_back(std::move(job));
+						packing_ = false;
+					}
+					cv_.notify_all();
+				}
+			}
+
+			void transport_loop() {
+				::CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+				for (;;) {
+					std::shared_ptr<transfer_job> job;
+					{
+						std::unique_lock<std::mutex> lock(mtx_);
+						cv_.wait(lock, [this]() { return !to_run_.empty() || (stop_ && to_pack_.empty() && !packing_); });
+						if (to_run_.empty())
+							break;
+						job = std::move(to_run_.front());
+						to_run_.pop_front();
+					}
+					cv_.notify_all(); // Room to pack the next write.
+					try {
+						if (job->cancelled())
+							throw std::runtime_error("Transfer cancelled");
+						if (job->pack_error)
+							std::rethrow_exception(job->pack_error);
+						job->run();
+					}
+					catch (...) {
+						if (!job->done()) // Not an exception from an awaiting coroutine.
+							job->fail(std::current_exception());
+					}
+				}
+				::CoUninitialize();
+			}
+
+			std::mutex mtx_;
+			std::condition_variable cv_;
+			std::deque<std::shared_ptr<transfer_job>> to_pack_;
+			std::deque<std::shared_ptr<transfer_job>> to_run_;
+			bool packing_ = false;
+			bool stop_ = false;
+			std::thread packer_;
+			std::thread transport_;
+		};
+
+		//// INGEST QUEUE ////
+		// Producers on any number of threads push samples into one bounded lock-free ring
+		// (Vyukov's sequence-numbered MPSC variant). A single writer thread in its own
+		// multithreaded apartment drains it into a column_writer per column, so only that
+		// thread makes COM calls and producers never wait on a round-trip.
+
+		/* What push does when the ring is full */
+		enum class overflow_policy {
+			block, // Wait for the writer to make room.
+			drop // Drop the sample and return false.
+		};
+
+		/* Snapshot of an ingest_queue. latency is from push to the SetData that carried the */
+		/* oldest sample of each batch. */
+		struct ingest_stats {
+			std::uint64_t pushed = 0;
+			std::uint64_t dropped = 0;
+			std::uint64_t written = 0;
+			std::uint64_t batches = 0;
+			std::size_t depth = 0;
+			std::size_t max_depth = 0;
+			std::chrono::nanoseconds mean_latency{ 0 };
+			std::chrono::nanoseconds max_latency{ 0 };
+		};
+
 		template<class T>
-		void get_arithmetic_column_data(const ColumnPtr& col, std::vector<T>& data, const long& offset, const long& rows) {
-			if (!is_vector_type_compatible<T>(col->DataFormat))
-				throw std::exception("Incompatible data types");
-			_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_NUMERIC, to_non_negative_long(offset), rows < -1 ? -1 : rows);
-			if (VT_ARRAY & vt_data.vt) {
-				long lbound, ubound;
-				::SafeArrayGetLBound(vt_data.parray, 1, &lbound);
-				::SafeArrayGetUBound(vt_data.parray, 1, &ubound);
-				long count = ubound - lbound + 1;
-				if (count > 0) {
-					data.reserve(count);
-					T* p_val = nullptr;
-					::SafeArrayAccessData(vt_data.parray, (void**)&p_val);
-					data.assign(p_val, p_val + count);
-					::SafeArrayUnaccessData(vt_data.parray);
-				}
+		class ingest_queue {
+			static_assert(std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value ||
+				std::is_same<T, std::wstring>::value || std::is_same<T, std::string>::value, "Unsupported ingest_queue type");
+		public:
+			/* capacity is rounded up to a power of two. policy sets the batches each column */
+			/* is written in; partial batches are written whenever the ring runs empty. */
+			explicit ingest_queue(const std::size_t& capacity = 65536, overflow_policy overflow = overflow_policy::block, const flush_policy& policy = flush_policy())
+				: overflow_(overflow), policy_(policy) {
+				std::size_t size = 2;
+				while (size < capacity)
+					size <<= 1;
+				mask_ = size - 1;
+				slots_.reset(new slot[size]);
+				for (std::size_t i = 0; i < size; ++i)
+					slots_[i].seq.store(i, std::memory_order_relaxed);
+				writer_ = std::thread([this]() { run(); });
 			}
-		}
-
-		void get_complex_column_data(const ColumnPtr& col, std::vector<std::complex<double>>& data, const long& offset, const long& rows) {
-			_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_NUMERIC, to_non_negative_long(offset), rows < -1 ? -1 : rows);
-			if (VT_ARRAY & vt_data.vt) {
-				long lbound, ubound;
-				::SafeArrayGetLBound(vt_data.parray, 1, &lbound);
-				::SafeArrayGetUBound(vt_data.parray, 1, &ubound);
-				long count = ubound - lbound + 1;
-				if (count > 0) {
-					// OrgLab returns pattern below for complex data:
-					// c1.re,c1.im,c2.re,c2.im,c3.re,c3.im, etc.
-					// There will be twice as many values as is needed
-					// for a complex vector since complex has two parts.
-					// Use resize to already add default complex values
-					// to vector.
-					data.resize(count / 2);
-					double* p_val = nullptr;
-					::SafeArrayAccessData(vt_data.parray, (void**)&p_val);
-					for (std::size_t i = 0; i < data.size(); ++i, ++p_val) {
-						data[i].real(*p_val);
-						data[i].imag(*(++p_val));
-					}
-					::SafeArrayUnaccessData(vt_data.parray);
-				}
-			}
-		}
-
-		void get_wstring_column_data(const ColumnPtr& col, std::vector<std::wstring>& data, const long& offset, const long& rows) {
-			if (!is_vector_type_compatible<std::wstring>(col->DataFormat))
-				throw std::exception("Incompatible data types");
-			CComSafeArray<BSTR> csa;
-			{ // This scope makes sure vt_data is cleaned up quickly for performance.
-				_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_STR, to_non_negative_long(offset), rows < -1 ? -1 : rows);
-				if (VT_ARRAY & vt_data.vt) {
-					csa.Attach(vt_data.parray);
-					vt_data.Detach();
+			ingest_queue(const ingest_queue&) = delete;
+			ingest_queue& operator=(const ingest_queue&) = delete;
+			~ingest_queue() {
+				try {
+					close();
+				}
+				catch (...) {
 				}
-				else
-					return;
 			}
-			std::size_t count = csa.GetCount(0);
-			if (0 == count)
-				return;
-			data.resize(count);
-			::SafeArrayLock(csa.m_psa);
-			BSTR* p_csa = (BSTR*)(csa.m_psa->pvData);
-			for (long i = 0; i < count; ++i, p_csa++) {
-				data[i] = from_bstr(*p_csa);
+
+			/* Registers a column written from row offset on. Returns the index to push to. */
+			/* May be called while producers are pushing. */
+			std::size_t add_column(const ColumnPtr& col, const std::size_t& offset = 0) {
+				if (!col)
+					throw std::runtime_error("ColumnPtr is invalid");
+				std::lock_guard<std::mutex> lock(mtx_);
+				added_.push_back(std::unique_ptr<added_column>(new added_column{ marshaled_column(col), offset }));
+				return column_count_++;
 			}
-			::SafeArrayUnlock(csa.m_psa);
-		}
 
-		void get_string_column_data(const ColumnPtr& col, std::vector<std::string>& data, const long& offset, const long& rows) {
-			if (!is_vector_type_compatible<std::wstring>(col->DataFormat))
-				throw std::exception("Incompatible data types");
-			CComSafeArray<BSTR> csa;
-			{ // This scope makes sure vt_data is cleaned up quickly for performance.
-				_variant_t vt_data = do_get_col_data(col, ARRAYDATAFORMAT::ARRAY1D_STR, to_non_negative_long(offset), rows < -1 ? -1 : rows);
-				if (VT_ARRAY & vt_data.vt) {
-					csa.Attach(vt_data.parray);
-					vt_data.Detach();
-				}
-				else
-					return;
+			/* Thread safe and lock-free unless the ring is full under overflow_policy::block. */
+			/* Returns false if the sample was dropped. */
+			bool push(const std::size_t& column, const T& value) {
+				return emplace(column, value);
 			}
-			std::size_t count = csa.GetCount(0);
-			if (0 == count)
-				return;
-			data.resize(count);
-			::SafeArrayLock(csa.m_psa);
-			BSTR* p_csa = (BSTR*)(csa.m_psa->pvData);
-			for (long i = 0; i < count; ++i, p_csa++) {
-				data[i] = from_wide(from_bstr(*p_csa));
+
+			bool push(const std::size_t& column, T&& value) {
+				return emplace(column, std::move(value));
 			}
-			::SafeArrayUnlock(csa.m_psa);
-		}
 
-		void do_set_mat_data(const MatrixObjectPtr& mat, const _variant_t& vt_array) {
-			try {
-				_variant_t v_zero(0);
-				mat->SetData(vt_array, v_zero, v_zero);
+			/* Writes everything pushed so far and stops the writer. Call once producers have */
+			/* stopped. Rethrows the first error the writer met; its column's samples were dropped. */
+			void close() {
+				if (writer_.joinable()) {
+					closed_.store(true, std::memory_order_relaxed);
+					{
+						std::lock_guard<std::mutex> lock(mtx_);
+						closing_ = true;
+					}
+					cv_.notify_all();
+					writer_.join();
+				}
+				if (error_) {
+					std::exception_ptr error = error_;
+					error_ = nullptr;
+					std::rethrow_exception(error);
+				}
 			}
-			catch (...) {
-				throw std::exception("MatrixObjectPtr set data fail");
+
+			ingest_stats stats() const {
+				ingest_stats st;
+				std::size_t tail = tail_.load(std::memory_order_relaxed);
+				std::size_t head = head_.load(std::memory_order_relaxed);
+				st.dropped = dropped_.load(std::memory_order_relaxed);
+				st.pushed = tail; // Every claimed slot is a pushed sample.
+				st.written = written_.load(std::memory_order_relaxed);
+				st.batches = batches_.load(std::memory_order_relaxed);
+				st.depth = tail > head ? tail - head : 0;
+				st.max_depth = max_depth_.load(std::memory_order_relaxed);
+				st.max_latency = std::chrono::nanoseconds(max_latency_.load(std::memory_order_relaxed));
+				if (st.batches)
+					st.mean_latency = std::chrono::nanoseconds(total_latency_.load(std::memory_order_relaxed) / st.batches);
+				return st;
 			}
-		}
 
-		_variant_t do_get_mat_data(const MatrixObjectPtr& mat, const ARRAYDATAFORMAT& fmt) {
-			_variant_t v_r1(0);
-			_variant_t v_r2(-1);
-			_variant_t v_c1(0);
-			_variant_t v_c2(-1);
-			_variant_t v_lbound(0);
-			return mat->GetData(v_r1, v_c1, v_r2, v_c2, fmt, v_lbound);
-		}
+		private:
+			using clock = std::chrono::steady_clock;
 
-		template<class T>
-		void set_arithmetic_matrix_data(const MatrixObjectPtr& mat, const matrix_adapter<T> ma, bool change_type = true) {
-			unsigned short rows = ma.rows();
-			unsigned short cols = ma.cols();
-			const T* data = ma.data();
-			if (!data || 0 == rows * cols)
-				return;
-			com_compat_info_t info = get_com_compat_info<T>(mat->DataFormat, true);
-			if (change_type && (info.first != mat->DataFormat))
-				mat->DataFormat = info.first;
-			try {
-				SAFEARRAYBOUND sa_bounds[2];
-				sa_bounds[0].lLbound = 0;
-				sa_bounds[0].cElements = cols; //rows;
-				sa_bounds[1].lLbound = 0;
-				sa_bounds[1].cElements = rows; //cols;
-				SAFEARRAY* pSA = ::SafeArrayCreate(info.second, 2, sa_bounds);
-				_variant_t vt_array;
-				vt_array.vt = info.second | VT_ARRAY;
-				vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
+			struct slot {
+				std::atomic<std::size_t> seq;
+				std::size_t column;
+				clock::rep stamp;
+				T value;
+			};
 
-				T* p_vals = nullptr;
-				::SafeArrayAccessData(pSA, (void**)&p_vals);
-				// In recent versions of Origin, MatrixObjectPtr became column major. Hence need to transpose.
-				//memcpy(p_vals, data, static_cast<std::size_t>(rows)* static_cast<std::size_t>(cols) * sizeof(T));
-				for (unsigned short k = 0; k < cols; ++k) {
-					for (unsigned short j = 0; j < rows; ++j) {
-						p_vals[cols * j + k] = data[rows * k + j];
+			struct added_column {
+				marshaled_column col;
+				std::size_t offset;
+			};
+
+			struct column_state {
+				std::unique_ptr<column_writer<T>> writer;
+				clock::rep oldest = 0;
+			};
+
+			template<class V>
+			bool emplace(const std::size_t& column, V&& value) {
+				unsigned spins = 0;
+				while (!closed_.load(std::memory_order_relaxed)) {
+					std::size_t pos = tail_.load(std::memory_order_relaxed);
+					for (;;) {
+						slot& s = slots_[pos & mask_];
+						std::size_t seq = s.seq.load(std::memory_order_acquire);
+						std::ptrdiff_t dif = static_cast<std::ptrdiff_t>(seq - pos);
+						if (0 == dif) {
+							if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+								s.column = column;
+								s.stamp = clock::now().time_since_epoch().count();
+								s.value = std::forward<V>(value);
+								s.seq.store(pos + 1, std::memory_order_release);
+								if (sleeping_.load(std::memory_order_relaxed))
+									cv_.notify_one();
+								return true;
+							}
+						}
+						else if (dif < 0)
+							break; // Full.
+						else
+							pos = tail_.load(std::memory_order_relaxed);
 					}
+					if (overflow_policy::drop == overflow_)
+						break;
+					if (++spins < 64)
+						std::this_thread::yield();
+					else
+						std::this_thread::sleep_for(std::chrono::microseconds(50));
 				}
-				::SafeArrayUnaccessData(pSA);
-				do_set_mat_data(mat, vt_array);
+				dropped_.fetch_add(1, std::memory_order_relaxed);
+				return false;
 			}
-			catch (...) {
-				throw std::exception("MatrixObjectPtr set data fail");
+
+			bool pop(std::size_t& column, clock::rep& stamp, T& value) {
+				std::size_t head = head_.load(std::memory_order_relaxed);
+				slot& s = slots_[head & mask_];
+				if (s.seq.load(std::memory_order_acquire) != head + 1)
+					return false;
+				column = s.column;
+				stamp = s.stamp;
+				value = std::move(s.value);
+				s.seq.store(head + mask_ + 1, std::memory_order_release);
+				head_.store(head + 1, std::memory_order_relaxed);
+				return true;
 			}
-		}
 
-		void set_complex_matrix_data(const MatrixObjectPtr& mat, const matrix_adapter<std::complex<double>> ma, bool change_type = true) {
-			unsigned short rows = ma.rows();
-			unsigned short cols = ma.cols();
-			const std::complex<double>* data = ma.data();
-			if (!data || 0 == rows * cols)
-				return;
-			com_compat_info_t info = get_com_compat_info<std::complex<double>>(mat->DataFormat, true);
-			if (change_type && (info.first != mat->DataFormat))
-				mat->DataFormat = info.first;
-			try {
-				SAFEARRAYBOUND sa_bounds[3];
-				sa_bounds[0].lLbound = 0;
-				sa_bounds[0].cElements = cols; //rows;
-				sa_bounds[1].lLbound = 0;
-				sa_bounds[1].cElements = rows; //cols;
-				sa_bounds[2].lLbound = 0;
-				sa_bounds[2].cElements = 2;
-				SAFEARRAY* pSA = ::SafeArrayCreate(info.second, 3, sa_bounds);
-				_variant_t vt_array;
-				vt_array.vt = info.second | VT_ARRAY;
-				vt_array.parray = pSA; // Let _variant_t take ownership of SafeArray.
-				double* p_vals = nullptr;
-				::SafeArrayAccessData(pSA, (void**)&p_vals);
-				// In recent versions of Origin, MatrixObjectPtr became column major. Hence need to transpose.
-				/*
-				for (unsigned short k = 0; k < cols; ++k) {
-					for (unsigned short j = 0; j < rows; ++j, ++p_vals) {
-						*p_vals = data[j,k].real();
-					}
-				}
-				for (unsigned short k = 0; k < cols; ++k) {
-					for (unsigned short j = 0; j < rows; ++j, ++p_vals) {
-						*p_vals = data[j,k].imag();
-					}
+			void add_columns() {
+				std::vector<std::unique_ptr<added_column>> added;
+				{
+					std::lock_guard<std::mutex> lock(mtx_);
+					added.swap(added_);
 				}
-				*/
-				for (unsigned short k = 0; k < cols; ++k) {
-					for (unsigned short j = 0; j < rows; ++j) {
-						p_vals[cols * j + k] = data[rows * k + j].real();
+				for (std::unique_ptr<added_column>& a : added) {
+					column_state cs;
+					try {
+						cs.writer.reset(new column_writer<T>(a->col.get(), a->offset, policy_));
 					}
-				}
-				unsigned short i = cols * rows;
-				for (unsigned short k = 0; k < cols; ++k) {
-					for (unsigned short j = 0; j < rows; ++j) {
-						p_vals[cols * j + k + i] = data[rows * k + j].imag();
+					catch (...) {
+						fail(std::current_exception());
 					}
+					columns_.push_back(std::move(cs));
 				}
+			}
 
-				::SafeArrayUnaccessData(pSA);
-				do_set_mat_data(mat, vt_array);
+			void fail(std::exception_ptr error) {
+				if (!error_)
+					error_ = error;
 			}
-			catch (...) {
-				throw std::exception("MatrixObjectPtr set data fail");
+
+			/* Records a batch that went out at now */
+			void record_batch(const column_state& cs, const std::size_t& rows, const clock::rep& now) {
+				std::uint64_t latency = now > cs.oldest ? static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::duration(now - cs.oldest)).count()) : 0;
+				written_.fetch_add(rows, std::memory_order_relaxed);
+				batches_.fetch_add(1, std::memory_order_relaxed);
+				total_latency_.fetch_add(latency, std::memory_order_relaxed);
+				if (latency > max_latency_.load(std::memory_order_relaxed))
+					max_latency_.store(latency, std::memory_order_relaxed);
 			}
-		}
 
-		template<class T>
-		void get_arithmetic_matrix_data(const MatrixObjectPtr& mat, matrix_adapter<T>& ma) {
-			if (!is_vector_type_compatible<T>(mat->DataFormat))
-				throw std::exception("Incompatible data types");
-			_variant_t vt_data = do_get_mat_data(mat, ARRAYDATAFORMAT::ARRAY2D_NUMERIC);
-			if (VT_ARRAY & vt_data.vt) {
-				long lbound1, ubound1, lbound2, ubound2;
-				::SafeArrayGetLBound(vt_data.parray, 1, &lbound1);
-				::SafeArrayGetUBound(vt_data.parray, 1, &ubound1);
-				::SafeArrayGetLBound(vt_data.parray, 2, &lbound2);
-				::SafeArrayGetUBound(vt_data.parray, 2, &ubound2);
-				long count1 = ubound1 - lbound1 + 1;
-				long count2 = ubound2 - lbound2 + 1;
-				if (count1 > 0 && count2 > 0) {
-					T* p_val = nullptr;
-					::SafeArrayAccessData(vt_data.parray, (void**)&p_val);
-					ma.assign(p_val, to_unsigned_short(count1), to_unsigned_short(count2));
-					::SafeArrayUnaccessData(vt_data.parray);
+			void drop_column(column_state& cs, std::exception_ptr error) {
+				fail(error);
+				dropped_.fetch_add(cs.writer->pending(), std::memory_order_relaxed);
+				cs.writer->discard();
+				cs.writer.reset();
+			}
+
+			void deliver(const std::size_t& column, const clock::rep& stamp, T& value) {
+				if (column >= columns_.size())
+					add_columns();
+				column_state* cs = column < columns_.size() ? &columns_[column] : nullptr;
+				if (!cs || !cs->writer) {
+					dropped_.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				std::size_t pending = cs->writer->pending();
+				if (0 == pending)
+					cs->oldest = stamp;
+				try {
+					cs->writer->push(std::move(value));
+				}
+				catch (...) {
+					drop_column(*cs, std::current_exception());
+					return;
 				}
+				if (0 == cs->writer->pending())
+					record_batch(*cs, pending + 1, clock::now().time_since_epoch().count());
 			}
-		}
 
-		void get_complex_matrix_data(const MatrixObjectPtr& mat, matrix_adapter<std::complex<double>>& ma) {
-			CComSafeArray<double> csa;
-			{ // Scope releases vt_data as soon as we hand its SAFEARRAY off to the CComSafeArray.
-				_variant_t vt_data = do_get_mat_data(mat, ARRAYDATAFORMAT::ARRAY2D_NUMERIC);
-				if (VT_ARRAY & vt_data.vt) {
-					csa.Attach(vt_data.parray);
-					vt_data.Detach();
+			void flush_all() {
+				clock::rep now = clock::now().time_since_epoch().count();
+				for (column_state& cs : columns_) {
+					if (!cs.writer || 0 == cs.writer->pending())
+						continue;
+					std::size_t pending = cs.writer->pending();
+					try {
+						cs.writer->flush();
+						record_batch(cs, pending, now);
+					}
+					catch (...) {
+						drop_column(cs, std::current_exception());
+					}
 				}
 			}
-			// Despite ARRAY2D_NUMERIC, 3D array is returned for complex.
-			// CComSafeArray handles such arrays easier, that's why we use one. Little to no overhead.
-			unsigned short rows = to_unsigned_short(csa.GetCount(0));
-			unsigned short cols = to_unsigned_short(csa.GetCount(1));
-			unsigned short parts = to_unsigned_short(csa.GetCount(2)); // Two parts- 1st is real part, 2nd is imaginary part.
-			// There can be no empty matrix object in Origin- always have at least 1x1.
-			if (rows > 0 && cols > 0 && parts > 0) {
-				ma.resize(rows, cols);
-				::SafeArrayLock(csa.m_psa);
-				double* p_csa_real = (double*)(csa.m_psa->pvData); // Real part is first rows*cols values.
-				long offset = (long)(rows * cols); // Avoids possible arith overflow per VS code analysis.
-				double* p_csa_imag = p_csa_real + offset;// (rows * cols); // Imaginary part real part offset by rows*cols.
-				for (unsigned short c = 0; c < cols; ++c) {
-					for (unsigned short r = 0; r < rows; ++r, p_csa_real++, p_csa_imag++) {
-						ma(r, c) = std::complex<double>{ *p_csa_real , *p_csa_imag };
+
+			void run() {
+				::CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+				{
+					std::size_t column = 0;
+					clock::rep stamp = 0;
+					T value{};
+					for (;;) {
+						std::size_t depth = tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_relaxed);
+						if (depth > max_depth_.load(std::memory_order_relaxed))
+							max_depth_.store(depth, std::memory_order_relaxed);
+						std::size_t drained = 0;
+						while (drained < 4096 && pop(column, stamp, value)) {
+							deliver(column, stamp, value);
+							++drained;
+						}
+						if (drained)
+							continue;
+						flush_all(); // Ring ran empty: write partial batches.
+						std::unique_lock<std::mutex> lock(mtx_);
+						if (closing_) {
+							lock.unlock();
+							if (pop(column, stamp, value)) { // Pushed while closing.
+								deliver(column, stamp, value);
+								continue;
+							}
+							break;
+						}
+						sleeping_.store(true, std::memory_order_relaxed);
+						cv_.wait_for(lock, std::chrono::milliseconds(1)); // Bounds a missed wakeup.
+						sleeping_.store(false, std::memory_order_relaxed);
 					}
+					flush_all();
+					columns_.clear(); // Release the columns in this apartment.
+					std::lock_guard<std::mutex> lock(mtx_);
+					added_.clear();
 				}
-				::SafeArrayUnlock(csa.m_psa);
+				::CoUninitialize();
 			}
-		}
+
+			overflow_policy overflow_;
+			flush_policy policy_;
+			std::unique_ptr<slot[]> slots_;
+			std::size_t mask_ = 0;
+			alignas(64) std::atomic<std::size_t> tail_{ 0 };
+			alignas(64) std::atomic<std::size_t> head_{ 0 };
+			alignas(64) std::atomic<std::uint64_t> dropped_{ 0 };
+			std::atomic<std::uint64_t> written_{ 0 };
+			std::atomic<std::uint64_t> batches_{ 0 };
+			std::atomic<std::uint64_t> total_latency_{ 0 };
+			std::atomic<std::uint64_t> max_latency_{ 0 };
+			std::atomic<std::size_t> max_depth_{ 0 };
+			std::atomic<bool> sleeping_{ false };
+			std::atomic<bool> closed_{ false };
+			std::mutex mtx_;
+			std::condition_variable cv_;
+			std::vector<std::unique_ptr<added_column>> added_;
+			std::size_t column_count_ = 0;
+			bool closing_ = false;
+			std::vector<column_state> columns_; // Writer thread only.
+			std::exception_ptr error_;
+			std::thread writer_;
+		};
 
 	} // End namespace for internal implementation.
 
 	//// BEGIN PUBLIC API ////
 
 	using impl::matrix_adapter;
+	using impl::matrix_view;
+	using impl::storage_order;
+	using impl::column_writer;
+	using impl::column_sync;
+	using impl::worksheet_writer;
+	using impl::column_sync_stats;
+	using impl::flush_policy;
+	using impl::column_reader;
+	using impl::column_chunk;
+	using impl::simd_level;
+	using impl::transfer_worker;
+	using impl::transfer;
+	using impl::ingest_queue;
+	using impl::ingest_stats;
+	using impl::overflow_policy;
+	using impl::array_pool_stats;
+	using impl::basic_string_column;
+	using string_column = impl::basic_string_column<char>;
+	using wstring_column = impl::basic_string_column<wchar_t>;
+	using impl::categorical_column;
+
+	/* Caps SIMD kernels used for conversions and complex data at level, e.g. to compare */
+	/* implementations. Capped to what the CPU supports. Returns the level in effect. */
+	inline simd_level set_simd_level(const simd_level& level) {
+		simd_level supported = impl::detect_simd_level();
+		simd_level effective = level > supported ? supported : level;
+		impl::simd_level_state().store(effective, std::memory_order_relaxed);
+		return effective;
+	}
+
+	inline simd_level get_simd_level() {
+		return impl::get_simd_level();
+	}
+
+	/* Lets numeric and complex column and matrix writes reuse their SAFEARRAYs, keeping up to */
+	/* cap bytes of idle arrays. 0, the default, turns pooling off and frees idle arrays. */
+	inline void set_array_pool_cap(const std::size_t& cap) {
+		impl::array_pool::instance().set_cap(cap);
+	}
+
+	inline array_pool_stats get_array_pool_stats() {
+		return impl::array_pool::instance().stats();
+	}
+
+	/* Largest single SetData or GetData payload for matrices, 256 MiB by default. Bigger */
+	/* matrices are moved in row or column blocks of at most this many bytes. */
+	inline void set_matrix_block_bytes(const std::size_t& bytes) {
+		impl::matrix_block_bytes().store(bytes, std::memory_order_relaxed);
+	}
+
+	inline std::size_t get_matrix_block_bytes() {
+		return impl::matrix_block_bytes().load(std::memory_order_relaxed);
+	}
+
+	/* Returns rows dropped by column_writer destructors whose final flush failed, since */
+	/* the start or the last reset */
+	inline std::uint64_t get_column_writer_dropped_rows() {
+		return impl::column_writer_dropped_rows().load(std::memory_order_relaxed);
+	}
+
+	/* Zeroes the dropped row count and returns what it was */
+	inline std::uint64_t reset_column_writer_dropped_rows() {
+		return impl::column_writer_dropped_rows().exchange(0, std::memory_order_relaxed);
+	}
+
+	/* Returns how many columns and matrices write with a copy because their server */
+	/* refused a zero-copy array */
+	inline std::size_t get_zero_copy_refusals() {
+		return impl::zero_copy_refused().size();
+	}
+
+	/* Lets every column and matrix try zero-copy writes again, as after switching servers. */
+	/* Returns how many refusals it forgot. */
+	inline std::size_t reset_zero_copy_refusals() {
+		return impl::zero_copy_refused().clear();
+	}
 
-	_bstr_t to_str_prop(const std::wstring& str) {
+	inline _bstr_t to_str_prop(const std::wstring& str) {
 		return str.c_str();
 	}
-	_bstr_t to_str_prop(const std::string& str) { return to_str_prop(impl::to_wide(str)); }
+	inline _bstr_t to_str_prop(const std::string& str) {
+		if (str.empty())
+			return to_str_prop(std::wstring());
+		return _bstr_t(impl::make_bstr(str), false); // Takes ownership.
+	}
 
 	template<class T> T from_str_prop(const _bstr_t& prop);
-	template<> std::wstring from_str_prop(const _bstr_t& prop) {
+	template<> inline std::wstring from_str_prop(const _bstr_t& prop) {
 		return std::wstring{ prop, ::SysStringLen(prop) };
 	}
-	template<> std::string from_str_prop(const _bstr_t& prop) {
-		return impl::from_wide(from_str_prop<std::wstring>(prop));
+	template<> inline std::string from_str_prop(const _bstr_t& prop) {
+		std::string str;
+		impl::assign_utf8(str, prop, prop.length());
+		return str;
 	}
 
 	template<class T>
 	typename std::enable_if<std::is_arithmetic<T>::value, void>::type
 		set_column_data(const ColumnPtr& ptr, const std::vector<T>& data, const std::size_t& offset = 0) {
 		if (!ptr)
-			throw std::exception("ColumnPtr is invalid");
-		impl::set_arithmetic_column_data(ptr, data.data(), data.size(), offset, ORGLAB_DATA_CDT);
+			throw std::runtime_error("ColumnPtr is invalid");
+		impl::set_arithmetic_column_data(ptr, data.data(), data.size(), offset, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT);
 	}
 
 	template<class T>
 	typename std::enable_if<std::is_arithmetic<T>::value, void>::type
 		set_column_data(const ColumnPtr& ptr, const T* data, const std::size_t& rows, const std::size_t& offset = 0) {
 		if (!ptr)
-			throw std::exception("ColumnPtr is invalid");
-		impl::set_arithmetic_column_data(ptr, data, rows, offset, ORGLAB_DATA_CDT);
+			throw std::runtime_error("ColumnPtr is invalid");
+		impl::set_arithmetic_column_data(ptr, data, rows, offset, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT);
 	}
 
 	template<class T>
 	typename std::enable_if<std::is_same<T, std::complex<double>>::value, void>::type
 		set_column_data(const ColumnPtr& ptr, const std::vector<T>& data, const std::size_t& offset = 0) {
 		if (!ptr)
-			throw std::exception("ColumnPtr is invalid");
+			throw std::runtime_error("ColumnPtr is invalid");
 		impl::set_complex_column_data(ptr, data.data(), data.size(), offset, ORGLAB_DATA_CDT);
 	}
 
@@ -798,25 +5234,40 @@ namespace orglab_data {
 	typename std::enable_if<std::is_same<T, std::complex<double>>::value, void>::type
 		set_column_data(const ColumnPtr& ptr, const T* data, const std::size_t& rows, const std::size_t& offset = 0) {
 		if (!ptr)
-			throw std::exception("ColumnPtr is invalid");
+			throw std::runtime_error("ColumnPtr is invalid");
 		impl::set_complex_column_data(ptr, data, rows, offset, ORGLAB_DATA_CDT);
 	}
 
 	template<class T>
-	typename std::enable_if<std::is_same<T, std::wstring>::value || std::is_same<T, std::string>::value, void>::type
+	typename std::enable_if<impl::is_string_cell<T>::value, void>::type
 		set_column_data(const ColumnPtr& ptr, const std::vector<T>& data, const std::size_t& offset = 0) {
 		if (!ptr)
-			throw std::exception("ColumnPtr is invalid");
-		impl::set_string_column_data<T>(ptr, data, offset, ORGLAB_DATA_CDT);
+			throw std::runtime_error("ColumnPtr is invalid");
+		impl::set_string_column_data(ptr, data.data(), data.size(), offset, ORGLAB_DATA_CDT);
+	}
+
+	template<class T>
+	typename std::enable_if<impl::is_string_cell<T>::value, void>::type
+		set_column_data(const ColumnPtr& ptr, const T* data, const std::size_t& rows, const std::size_t& offset = 0) {
+		if (!ptr)
+			throw std::runtime_error("ColumnPtr is invalid");
+		impl::set_string_column_data(ptr, data, rows, offset, ORGLAB_DATA_CDT);
+	}
+
+	template<class S>
+	void set_column_data(const ColumnPtr& ptr, const categorical_column<S>& data, const std::size_t& offset = 0) {
+		if (!ptr)
+			throw std::runtime_error("ColumnPtr is invalid");
+		impl::set_categorical_column_data(ptr, data, offset, ORGLAB_DATA_CDT);
 	}
 
 	template<class T>
 	typename std::enable_if<std::is_arithmetic<T>::value, std::vector<T>>::type
 		get_column_data(const ColumnPtr& ptr, const long& offset = 0, const long& rows = -1) {
 		if (!ptr)
-			throw std::exception("ColumnPtr is invalid");
+			throw std::runtime_error("ColumnPtr is invalid");
 		std::vector<T> data;
-		impl::get_arithmetic_column_data<T>(ptr, data, offset, rows);
+		impl::get_arithmetic_column_data<T>(ptr, data, offset, rows, ORGLAB_DATA_CVT);
 		return data;
 	}
 
@@ -824,7 +5275,7 @@ namespace orglab_data {
 	typename std::enable_if<std::is_same<T, std::complex<double>>::value, std::vector<T>>::type
 		get_column_data(const ColumnPtr& ptr, const long& offset = 0, const long& rows = -1) {
 		if (!ptr)
-			throw std::exception("ColumnPtr is invalid");
+			throw std::runtime_error("ColumnPtr is invalid");
 		std::vector<T> data;
 		impl::get_complex_column_data(ptr, data, offset, rows);
 		return data;
@@ -834,7 +5285,7 @@ namespace orglab_data {
 	typename std::enable_if<std::is_same<T, std::wstring>::value, std::vector<T>>::type
 		get_column_data(const ColumnPtr& ptr, const long& offset = 0, const long& rows = -1) {
 		if (!ptr)
-			throw std::exception("ColumnPtr is invalid");
+			throw std::runtime_error("ColumnPtr is invalid");
 		std::vector<T> data;
 		impl::get_wstring_column_data(ptr, data, offset, rows);
 		return data;
@@ -844,48 +5295,354 @@ namespace orglab_data {
 	typename std::enable_if<std::is_same<T, std::string>::value, std::vector<T>>::type
 		get_column_data(const ColumnPtr& ptr, const long& offset = 0, const long& rows = -1) {
 		if (!ptr)
-			throw std::exception("ColumnPtr is invalid");
+			throw std::runtime_error("ColumnPtr is invalid");
 		std::vector<T> data;
 		impl::get_string_column_data(ptr, data, offset, rows);
 		return data;
 	}
 
+	/* Reading into caller-owned storage. Returns number of rows written. */
+	/* Vector overloads reuse the vector's capacity; pointer and span overloads read at */
+	/* most capacity rows. None allocate on the library side. */
+
 	template<class T>
-	typename std::enable_if<std::is_arithmetic<T>::value, void>::type
-		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_adapter<T>& ma) {
+	typename std::enable_if<std::is_arithmetic<T>::value, std::size_t>::type
+		get_column_data(const ColumnPtr& ptr, std::vector<T>& data, const long& offset = 0, const long& rows = -1) {
+		if (!ptr)
+			throw std::runtime_error("ColumnPtr is invalid");
+		return impl::get_arithmetic_column_data<T>(ptr, data, offset, rows, ORGLAB_DATA_CVT);
+	}
+
+	template<class T>
+	typename std::enable_if<std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		get_column_data(const ColumnPtr& ptr, std::vector<T>& data, const long& offset = 0, const long& rows = -1) {
+		if (!ptr)
+			throw std::runtime_error("ColumnPtr is invalid");
+		return impl::get_complex_column_data(ptr, data, offset, rows);
+	}
+
+	/* Text cells as categories and codes. Each distinct value is transcoded and stored once. */
+	template<class S>
+	std::size_t get_column_data(const ColumnPtr& ptr, categorical_column<S>& data, const long& offset = 0, const long& rows = -1) {
+		if (!ptr)
+			throw std::runtime_error("ColumnPtr is invalid");
+		return impl::get_categorical_column_data(ptr, data, offset, rows);
+	}
+
+	/* Text cells into one reusable buffer. Cells are std::string_view or std::wstring_view. */
+	template<class C>
+	std::size_t get_column_data(const ColumnPtr& ptr, basic_string_column<C>& data, const long& offset = 0, const long& rows = -1) {
+		if (!ptr)
+			throw std::runtime_error("ColumnPtr is invalid");
+		return impl::get_string_column_data(ptr, data, offset, rows);
+	}
+
+	// Pointer type is deduced so get_column_data<T>(ptr, 0, n) still picks the overloads above.
+	template<class P, class T = typename std::remove_pointer<P>::type>
+	typename std::enable_if<std::is_pointer<P>::value && !std::is_const<T>::value && std::is_arithmetic<T>::value, std::size_t>::type
+		get_column_data(const ColumnPtr& ptr, P data, const std::size_t& capacity, const long& offset = 0, const long& rows = -1) {
+		if (!ptr)
+			throw std::runtime_error("ColumnPtr is invalid");
+		return impl::get_arithmetic_column_data<T>(ptr, data, capacity, offset, rows, ORGLAB_DATA_CVT);
+	}
+
+	template<class P, class T = typename std::remove_pointer<P>::type>
+	typename std::enable_if<std::is_pointer<P>::value && std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		get_column_data(const ColumnPtr& ptr, P data, const std::size_t& capacity, const long& offset = 0, const long& rows = -1) {
+		if (!ptr)
+			throw std::runtime_error("ColumnPtr is invalid");
+		return impl::get_complex_column_data(ptr, data, capacity, offset, rows);
+	}
+
+#ifdef ORGLAB_DATA_HAS_SPAN
+	template<class T>
+	typename std::enable_if<std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		get_column_data(const ColumnPtr& ptr, std::span<T> data, const long& offset = 0, const long& rows = -1) {
+		return get_column_data(ptr, data.data(), data.size(), offset, rows);
+	}
+#endif
+
+	/* Writes a table of columns into a worksheet starting at column first_col and row offset. */
+	/* Columns may be of different types and lengths; see impl::set_worksheet_data. */
+	template<class... C>
+	void set_worksheet_data(const WorksheetPtr& ptr, const std::tuple<C...>& cols, const std::size_t& first_col = 0, const std::size_t& offset = 0) {
+		if (!ptr)
+			throw std::runtime_error("WorksheetPtr is invalid");
+		impl::block_column bc[sizeof...(C) > 0 ? sizeof...(C) : 1];
+		std::size_t i = 0;
+		std::apply([&](const auto&... col) { ((bc[i++] = impl::make_block_column(col)), ...); }, cols);
+		impl::set_worksheet_data(ptr, bc, sizeof...(C), first_col, offset, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT);
+	}
+
+	template<class T>
+	void set_worksheet_data(const WorksheetPtr& ptr, const std::vector<std::vector<T>>& cols, const std::size_t& first_col = 0, const std::size_t& offset = 0) {
+		if (!ptr)
+			throw std::runtime_error("WorksheetPtr is invalid");
+		std::vector<impl::block_column> bc;
+		bc.reserve(cols.size());
+		for (const std::vector<T>& col : cols)
+			bc.push_back(impl::make_block_column(col));
+		impl::set_worksheet_data(ptr, bc.data(), bc.size(), first_col, offset, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT);
+	}
+
+#ifdef ORGLAB_DATA_HAS_SPAN
+	template<class T>
+	void set_worksheet_data(const WorksheetPtr& ptr, const std::vector<std::span<const T>>& cols, const std::size_t& first_col = 0, const std::size_t& offset = 0) {
+		if (!ptr)
+			throw std::runtime_error("WorksheetPtr is invalid");
+		std::vector<impl::block_column> bc;
+		bc.reserve(cols.size());
+		for (const std::span<const T>& col : cols)
+			bc.push_back(impl::make_block_column(col));
+		impl::set_worksheet_data(ptr, bc.data(), bc.size(), first_col, offset, ORGLAB_DATA_CDT, ORGLAB_DATA_CVT);
+	}
+#endif
+
+	/* Reads one column of each type T from column first_col on: two GetData calls whatever */
+	/* the number of columns. Complex columns cost two calls each and, with */
+	/* ORGLAB_DATA_CHECK_BLOCK_FORMATS, every other column two, plus one for the Columns */
+	/* collection; see impl::get_worksheet_data. */
+	template<class... T>
+	typename std::enable_if<(sizeof...(T) > 0), std::tuple<std::vector<T>...>>::type
+		get_worksheet_data(const WorksheetPtr& ptr, const std::size_t& first_col = 0, const long& offset = 0, const long& rows = -1) {
+		if (!ptr)
+			throw std::runtime_error("WorksheetPtr is invalid");
+		std::tuple<std::vector<T>...> cols;
+		impl::get_worksheet_data(ptr, cols, first_col, offset, rows);
+		return cols;
+	}
+
+	/* Same, reusing the capacity of the vectors in cols */
+	template<class... T>
+	void get_worksheet_data(const WorksheetPtr& ptr, std::tuple<std::vector<T>...>& cols, const std::size_t& first_col = 0, const long& offset = 0, const long& rows = -1) {
 		if (!ptr)
-			throw std::exception("MatrixObjectPtr is invalid");
-		impl::set_arithmetic_matrix_data(ptr, ma, ORGLAB_DATA_CDT);
+			throw std::runtime_error("WorksheetPtr is invalid");
+		impl::get_worksheet_data(ptr, cols, first_col, offset, rows);
 	}
 
+	/* Reads cols columns from first_col into a column major frame with one GetData: */
+	/* frame[frame_rows * k + i] is row i of column first_col + k. Column formats are */
+	/* checked only with ORGLAB_DATA_CHECK_BLOCK_FORMATS. Returns number of elements. */
 	template<class T>
+	typename std::enable_if<std::is_arithmetic<T>::value, std::size_t>::type
+		get_worksheet_data(const WorksheetPtr& ptr, std::vector<T>& frame, std::size_t& frame_rows, const std::size_t& first_col, const std::size_t& cols, const long& offset = 0, const long& rows = -1) {
+		if (!ptr)
+			throw std::runtime_error("WorksheetPtr is invalid");
+		return impl::get_worksheet_frame(ptr, frame, frame_rows, first_col, cols, offset, rows);
+	}
+
+	template<class T, storage_order O>
+	typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_adapter<T, O>& ma) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::set_arithmetic_matrix_data<T>(ptr, ma, ORGLAB_DATA_CDT);
+	}
+
+	template<class T, storage_order O>
 	typename std::enable_if<std::is_same<T, std::complex<double>>::value, void>::type
-		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_adapter<T>& ma) {
+		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_adapter<T, O>& ma) {
 		if (!ptr)
-			throw std::exception("MatrixObjectPtr is invalid");
+			throw std::runtime_error("MatrixObjectPtr is invalid");
 		impl::set_complex_matrix_data(ptr, ma, ORGLAB_DATA_CDT);
 	}
 
+	/* Sets a rows x cols region of the matrix from ma, with its top left element at row, col. */
+	/* The region must be inside the matrix. Only the region is sent. */
+	template<class T, storage_order O>
+	typename std::enable_if<std::is_arithmetic<T>::value, void>::type
+		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_adapter<T, O>& ma, const std::size_t& row, const std::size_t& col) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::set_arithmetic_matrix_data<T>(ptr, ma, ORGLAB_DATA_CDT, row, col);
+	}
+
+	template<class T, storage_order O>
+	typename std::enable_if<std::is_same<T, std::complex<double>>::value, void>::type
+		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_adapter<T, O>& ma, const std::size_t& row, const std::size_t& col) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::set_complex_matrix_data(ptr, ma, ORGLAB_DATA_CDT, row, col);
+	}
+
+	/* Sets matrix data straight from caller memory, without a matrix_adapter copy */
+	template<class T>
+	typename std::enable_if<std::is_arithmetic<typename std::remove_const<T>::type>::value, void>::type
+		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_view<T>& mv) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::set_arithmetic_matrix_data<typename std::remove_const<T>::type>(ptr, mv, ORGLAB_DATA_CDT);
+	}
+
+	template<class T>
+	typename std::enable_if<std::is_same<typename std::remove_const<T>::type, std::complex<double>>::value, void>::type
+		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_view<T>& mv) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::set_complex_matrix_data(ptr, mv, ORGLAB_DATA_CDT);
+	}
+
+	/* As above for a region with its top left element at row, col, like the matrix_adapter */
+	/* overloads. Use matrix_view::block to send part of a caller matrix. */
+	template<class T>
+	typename std::enable_if<std::is_arithmetic<typename std::remove_const<T>::type>::value, void>::type
+		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_view<T>& mv, const std::size_t& row, const std::size_t& col) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::set_arithmetic_matrix_data<typename std::remove_const<T>::type>(ptr, mv, ORGLAB_DATA_CDT, row, col);
+	}
+
 	template<class T>
-	typename std::enable_if<std::is_arithmetic<T>::value, matrix_adapter<T>>::type
+	typename std::enable_if<std::is_same<typename std::remove_const<T>::type, std::complex<double>>::value, void>::type
+		set_matrix_data(const MatrixObjectPtr& ptr, const matrix_view<T>& mv, const std::size_t& row, const std::size_t& col) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::set_complex_matrix_data(ptr, mv, ORGLAB_DATA_CDT, row, col);
+	}
+
+	/* O picks the storage order of the returned matrix_adapter, e.g. */
+	/* get_matrix_data<double, storage_order::row_major>(ptr) */
+	template<class T, storage_order O = storage_order::col_major>
+	typename std::enable_if<std::is_arithmetic<T>::value, matrix_adapter<T, O>>::type
 		get_matrix_data(const MatrixObjectPtr& ptr) {
 		if (!ptr)
-			throw std::exception("MatrixObjectPtr is invalid");
-		matrix_adapter<T> ma;
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		matrix_adapter<T, O> ma;
 		impl::get_arithmetic_matrix_data<T>(ptr, ma);
 		return ma;
 	}
 
-	template<class T>
-	typename std::enable_if<std::is_same<T, std::complex<double>>::value, matrix_adapter<T>>::type
+	template<class T, storage_order O = storage_order::col_major>
+	typename std::enable_if<std::is_same<T, std::complex<double>>::value, matrix_adapter<T, O>>::type
 		get_matrix_data(const MatrixObjectPtr& ptr) {
 		if (!ptr)
-			throw std::exception("MatrixObjectPtr is invalid");
-		matrix_adapter<T> ma;
-		impl::get_complex_matrix_data(ptr, ma);
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		matrix_adapter<T, O> ma;
+		impl::get_complex_matrix_data<O>(ptr, ma);
 		return ma;
 	}
 
+	/* Reads into an existing matrix_adapter, reusing its storage when the size is unchanged. */
+	/* Returns number of elements written. */
+	template<class T, storage_order O>
+	typename std::enable_if<std::is_arithmetic<T>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, matrix_adapter<T, O>& ma) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::get_arithmetic_matrix_data<T>(ptr, ma);
+		return ma.size();
+	}
+
+	template<class T, storage_order O>
+	typename std::enable_if<std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, matrix_adapter<T, O>& ma) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::get_complex_matrix_data(ptr, ma);
+		return ma.size();
+	}
+
+	/* Reads the region of rows x cols with its top left element at row, col into ma, which */
+	/* is resized to the part of the region inside the matrix. Only the region is read. */
+	/* Returns number of elements written. */
+	template<class T, storage_order O>
+	typename std::enable_if<std::is_arithmetic<T>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, matrix_adapter<T, O>& ma, const std::size_t& row, const std::size_t& col, const std::size_t& rows, const std::size_t& cols) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::get_arithmetic_matrix_data<T>(ptr, ma, row, col, rows, cols);
+		return ma.size();
+	}
+
+	template<class T, storage_order O>
+	typename std::enable_if<std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, matrix_adapter<T, O>& ma, const std::size_t& row, const std::size_t& col, const std::size_t& rows, const std::size_t& cols) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		impl::get_complex_matrix_data(ptr, ma, row, col, rows, cols);
+		return ma.size();
+	}
+
+	/* Reads column major data into a caller-owned array. Returns number of elements written, */
+	/* or 0 if capacity is less than rows*cols. rows and cols receive matrix dimensions either way. */
+	template<class T>
+	typename std::enable_if<std::is_arithmetic<T>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, T* data, const std::size_t& capacity, std::size_t& rows, std::size_t& cols) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		return impl::get_arithmetic_matrix_data<T>(ptr, data, capacity, rows, cols);
+	}
+
+	template<class T>
+	typename std::enable_if<std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, T* data, const std::size_t& capacity, std::size_t& rows, std::size_t& cols) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		return impl::get_complex_matrix_data(ptr, data, capacity, rows, cols);
+	}
+
+	/* Reads straight into caller memory. Returns number of elements written, or 0 if the */
+	/* matrix is not view.rows() x view.cols(). */
+	template<class T>
+	typename std::enable_if<std::is_arithmetic<T>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, const matrix_view<T>& view) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		return impl::get_arithmetic_matrix_data<T>(ptr, view);
+	}
+
+	template<class T>
+	typename std::enable_if<std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, const matrix_view<T>& view) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		return impl::get_complex_matrix_data(ptr, view);
+	}
+
+	/* Reads the region of view.rows() x view.cols() with its top left element at row, col */
+	/* into view. Returns number of elements written, or 0 if the region is not inside the */
+	/* matrix. */
+	template<class T>
+	typename std::enable_if<std::is_arithmetic<T>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, const matrix_view<T>& view, const std::size_t& row, const std::size_t& col) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		return impl::get_arithmetic_matrix_data<T>(ptr, view, row, col, view.rows(), view.cols());
+	}
+
+	template<class T>
+	typename std::enable_if<std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, const matrix_view<T>& view, const std::size_t& row, const std::size_t& col) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		return impl::get_complex_matrix_data(ptr, view, row, col, view.rows(), view.cols());
+	}
+
+	/* As the pointer overloads above with unsigned short dimensions, for existing callers. */
+	/* Throws if either dimension is over 65535 instead of truncating it. */
+	template<class T>
+	typename std::enable_if<std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		get_matrix_data(const MatrixObjectPtr& ptr, T* data, const std::size_t& capacity, unsigned short& rows, unsigned short& cols) {
+		std::size_t r = 0, c = 0;
+		std::size_t count = get_matrix_data(ptr, data, capacity, r, c);
+		impl::check_unsigned_short_dims(r, c);
+		rows = static_cast<unsigned short>(r);
+		cols = static_cast<unsigned short>(c);
+		return count;
+	}
+
+	/* Sends the regions of ma marked dirty since the last sync, see */
+	/* matrix_adapter::track_dirty, as rectangular region writes and clears the marks. */
+	/* Sends all of ma if it is not tracking. The matrix must have the dimensions of ma. */
+	/* Returns number of elements sent. */
+	template<class T, storage_order O>
+	typename std::enable_if<std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value, std::size_t>::type
+		sync_matrix_data(const MatrixObjectPtr& ptr, matrix_adapter<T, O>& ma) {
+		if (!ptr)
+			throw std::runtime_error("MatrixObjectPtr is invalid");
+		return impl::sync_dirty_matrix_data(ptr, ma, ORGLAB_DATA_CDT);
+	}
+
 	//// END PUBLIC API ////
 
 } /* End namespace orglab_data */
@@ -0,0 +1,1141 @@
+/*
+Benchmark suite for orglab_data.hpp.
+
+Sweeps every C++ type supported by orglab_data (see get_com_compat_info) across row
+counts, offsets and matrix sizes, plus burst appends through column_writer, chunked
+scans through column_reader, worksheet table writes, pipelined transfer_worker writes,
+multi-threaded appends through ingest_queue, writes with the SAFEARRAY pool on and off,
+copying against zero-copy (ORGLAB_DATA_ZERO_COPY) column writes, UTF-8 transcoding, text reads into a string_column arena,
+categorical text columns, matrix uploads and reads through a matrix_adapter copy against a matrix_view
+of caller memory, column major against row major matrix_adapter transfers, region updates against whole-matrix transfers,
+dirty-tile syncs of a changing matrix_adapter against full uploads, column_sync against whole column writes,
+matrix_adapter transposes and << dumps and the transpose engine against a naive loop,
+and writes throughput, p50/p99 latency, peak transient heap use and allocations per
+iteration as JSON.
+
+Backends:
+  fake  In-process orglab_data_fake.hpp (default). Builds anywhere:
+        g++ -std=c++17 -O2 -pthread main.cpp -o orglab_data_benchmark
+  live  Origin Automation Server. Windows only, build with ORGLAB_DATA_BENCH_LIVE defined
+        (and ORGLAB_DATA_USE_ORGLAB too for Orglab).
+
+Options:
+  --max-rows N        Largest column row count, decades from 1 (default 1e6, up to 1e8).
+  --max-matrix N      Largest square matrix dimension (default 1024, up to 65535).
+  --latency-us N      Fake backend latency per round-trip in microseconds (default 0).
+  --min-iters N       Minimum timed iterations per case (default 5).
+  --max-seconds S     Time budget per case in seconds (default 2).
+  --filter TEXT       Only run cases whose name contains TEXT.
+  --out FILE          Write JSON to FILE instead of stdout.
+*/
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef ORGLAB_DATA_BENCH_LIVE
+#include <mutex>
+#include <atlsafe.h>
+#ifdef ORGLAB_DATA_USE_ORGLAB
+#import "../orglab_data_example/orglab.tlb" no_dual_interfaces rename_namespace("origin")
+#else
+#import "../orglab_data_example/Origin8.tlb" no_dual_interfaces rename_namespace("origin")
+#endif
+#define ORGLAB_DATA_ORGLAB_NS origin
+#else
+#include "../orglab_data_fake.hpp"
+#endif
+
+#include "../orglab_data.hpp"
+
+namespace origin_ns = ORGLAB_DATA_ORGLAB_NS;
+
+//// HEAP TRACKING ////
+// Every global allocation is counted so each case can report its peak transient heap use
+// and allocations per iteration.
+// The fake backend allocates its SAFEARRAYs and BSTRs through operator new as well.
+
+namespace heap {
+	std::atomic<std::size_t> current{ 0 };
+	std::atomic<std::size_t> peak{ 0 };
+	std::atomic<std::size_t> count{ 0 };
+
+	inline void add(std::size_t n) {
+		std::size_t now = current.fetch_add(n, std::memory_order_relaxed) + n;
+		std::size_t p = peak.load(std::memory_order_relaxed);
+		while (now > p && !peak.compare_exchange_weak(p, now, std::memory_order_relaxed)) {}
+	}
+
+	/* Prefix of every block, keeping the size for release. Aligned like malloc. */
+	struct alignas(std::max_align_t) header {
+		std::size_t size;
+	};
+
+	inline void* alloc(std::size_t n) {
+		header* h = static_cast<header*>(std::malloc(sizeof(header) + n));
+		if (!h)
+			return nullptr;
+		h->size = n;
+		add(n);
+		count.fetch_add(1, std::memory_order_relaxed);
+		return h + 1;
+	}
+
+	inline void release(void* p) {
+		if (!p)
+			return;
+		// Through an integer, so the compiler does not see free() on a pointer from new.
+		void* base = reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(p) - sizeof(header));
+		header* h = static_cast<header*>(base);
+		current.fetch_sub(h->size, std::memory_order_relaxed);
+		std::free(base);
+	}
+
+	/* Starts a new peak measurement and returns the baseline */
+	inline std::size_t reset_peak() {
+		std::size_t now = current.load(std::memory_order_relaxed);
+		peak.store(now, std::memory_order_relaxed);
+		return now;
+	}
+}
+
+void* operator new(std::size_t n) {
+	void* p = heap::alloc(n);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+void* operator new[](std::size_t n) { return operator new(n); }
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept { return heap::alloc(n); }
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept { return heap::alloc(n); }
+void operator delete(void* p) noexcept { heap::release(p); }
+void operator delete[](void* p) noexcept { heap::release(p); }
+void operator delete(void* p, std::size_t) noexcept { heap::release(p); }
+void operator delete[](void* p, std::size_t) noexcept { heap::release(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { heap::release(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { heap::release(p); }
+
+namespace bench {
+
+	struct options {
+		std::size_t max_rows = 1000000;
+		std::size_t max_matrix = 1024;
+		long latency_us = 0;
+		std::size_t min_iters = 5;
+		double max_seconds = 2.0;
+		std::string filter;
+		std::string out;
+	};
+
+	struct result {
+		std::string name;
+		std::string type;
+		std::size_t rows = 0;
+		std::size_t cols = 0;
+		std::size_t offset = 0;
+		std::size_t iterations = 0;
+		double p50_ns = 0;
+		double p99_ns = 0;
+		double rows_per_s = 0;
+		double mb_per_s = 0;
+		std::size_t peak_bytes = 0;
+		double allocs = 0;
+	};
+
+	/* Times fn until the case has enough samples or runs out of budget */
+	inline result measure(const options& opt, std::size_t bytes_per_iter, const std::function<void()>& fn) {
+		using clock = std::chrono::steady_clock;
+		fn(); // Warm up.
+		std::vector<double> samples;
+		std::size_t peak = 0;
+		std::size_t allocs = 0;
+		auto budget = std::chrono::duration<double>(opt.max_seconds);
+		auto begin = clock::now();
+		// At least min_iters samples, then keep sampling for a quarter of the budget;
+		// slow cases stop once the whole budget is spent.
+		while (samples.size() < opt.min_iters || (clock::now() - begin < budget / 4 && samples.size() < 100000)) {
+			std::size_t base = heap::reset_peak();
+			std::size_t count = heap::count.load();
+			auto t0 = clock::now();
+			fn();
+			auto t1 = clock::now();
+			peak = (std::max)(peak, heap::peak.load() - base);
+			allocs += heap::count.load() - count;
+			samples.push_back(std::chrono::duration<double, std::nano>(t1 - t0).count());
+			if (clock::now() - begin > budget)
+				break;
+		}
+		std::sort(samples.begin(), samples.end());
+		auto pct = [&](double p) { return samples[(std::min)(samples.size() - 1, static_cast<std::size_t>(p * (samples.size() - 1) + 0.5))]; };
+		result r;
+		r.iterations = samples.size();
+		r.p50_ns = pct(0.50);
+		r.p99_ns = pct(0.99);
+		r.mb_per_s = r.p50_ns > 0 ? bytes_per_iter / r.p50_ns * 1e9 / (1024.0 * 1024.0) : 0;
+		r.peak_bytes = peak;
+		r.allocs = static_cast<double>(allocs) / samples.size();
+		return r;
+	}
+
+	//// TEST DATA ////
+
+	template<class T> struct type_traits;
+
+	template<class T> struct arithmetic_traits {
+		static T make(std::mt19937_64& rng) { return static_cast<T>(rng() % 100); }
+		static std::size_t bytes(const T&) { return sizeof(T); }
+	};
+	template<> struct type_traits<double> : arithmetic_traits<double> {
+		static const char* name() { return "double"; }
+		static double make(std::mt19937_64& rng) { return std::uniform_real_distribution<double>(-1e6, 1e6)(rng); }
+	};
+	template<> struct type_traits<float> : arithmetic_traits<float> {
+		static const char* name() { return "float"; }
+		static float make(std::mt19937_64& rng) { return std::uniform_real_distribution<float>(-1e3f, 1e3f)(rng); }
+	};
+	template<> struct type_traits<int> : arithmetic_traits<int> { static const char* name() { return "int"; } };
+	template<> struct type_traits<long> : arithmetic_traits<long> { static const char* name() { return "long"; } };
+	template<> struct type_traits<unsigned long> : arithmetic_traits<unsigned long> { static const char* name() { return "unsigned long"; } };
+	template<> struct type_traits<short> : arithmetic_traits<short> { static const char* name() { return "short"; } };
+	template<> struct type_traits<unsigned short> : arithmetic_traits<unsigned short> { static const char* name() { return "unsigned short"; } };
+	template<> struct type_traits<byte> : arithmetic_traits<byte> { static const char* name() { return "byte"; } };
+	template<> struct type_traits<char> : arithmetic_traits<char> { static const char* name() { return "char"; } };
+	template<> struct type_traits<std::complex<double>> {
+		static const char* name() { return "std::complex<double>"; }
+		static std::complex<double> make(std::mt19937_64& rng) {
+			std::uniform_real_distribution<double> d(-1e6, 1e6);
+			double re = d(rng);
+			return { re, d(rng) };
+		}
+		static std::size_t bytes(const std::complex<double>&) { return sizeof(std::complex<double>); }
+	};
+	template<> struct type_traits<std::wstring> {
+		static const char* name() { return "std::wstring"; }
+		static std::wstring make(std::mt19937_64& rng) {
+			std::wstring s = L"sample_" + std::to_wstring(rng() % 100000);
+			if (0 == rng() % 8)
+				s += L"_é你"; // Some non-ASCII cells.
+			return s;
+		}
+		static std::size_t bytes(const std::wstring& s) { return s.size() * sizeof(wchar_t); }
+	};
+	template<> struct type_traits<std::string> {
+		static const char* name() { return "std::string"; }
+		static std::string make(std::mt19937_64& rng) {
+			std::string s = "sample_" + std::to_string(rng() % 100000);
+			if (0 == rng() % 8)
+				s += "_\xc3\xa9\xe4\xbd\xa0"; // Some non-ASCII cells (UTF-8).
+			return s;
+		}
+		static std::size_t bytes(const std::string& s) { return s.size(); }
+	};
+
+	template<class T>
+	std::vector<T> make_data(std::size_t rows, std::uint64_t seed = 42) {
+		std::mt19937_64 rng(seed);
+		std::vector<T> v;
+		v.reserve(rows);
+		for (std::size_t i = 0; i < rows; ++i)
+			v.push_back(type_traits<T>::make(rng));
+		return v;
+	}
+
+	template<class T>
+	std::size_t data_bytes(const std::vector<T>& v) {
+		std::size_t n = 0;
+		for (const T& t : v)
+			n += type_traits<T>::bytes(t);
+		return n;
+	}
+
+	template<class T>
+	orglab_data::matrix_adapter<T> make_matrix_data(std::size_t rows, std::size_t cols) {
+		std::vector<T> v = make_data<T>(rows * cols);
+		return orglab_data::matrix_adapter<T>(v.data(), rows, cols);
+	}
+
+	//// BACKENDS ////
+
+#ifdef ORGLAB_DATA_BENCH_LIVE
+	/* Origin Automation Server (or Orglab). Same launch sequence as the example. */
+	class env {
+		CComPtr<origin::IOApplication> app_;
+		origin::WorksheetPtr wks_;
+	public:
+		env() {
+			::CoInitializeEx(nullptr, COINIT_DISABLE_OLE1DDE | COINIT_MULTITHREADED);
+			CLSID clsid;
+#ifdef ORGLAB_DATA_USE_ORGLAB
+			const std::vector<std::wstring> prog_ids = { L"OrgLab995.Application", L"OrgLab990.Application", L"OrgLab99.Application",
+			L"OrgLab985.Application", L"OrgLab980.Application", L"OrgLab98.Application",
+			L"OrgLab975.Application", L"OrgLab970.Application", L"OrgLab97.Application", L"OrgLab9.Application" };
+			for (const std::wstring& str : prog_ids) {
+				if (SUCCEEDED(::CLSIDFromProgID(str.c_str(), &clsid)))
+					break;
+			}
+			app_.CoCreateInstance(clsid);
+#else
+			::CLSIDFromProgID(L"Origin.Application", &clsid);
+			::CoCreateInstance(clsid, NULL, CLSCTX_LOCAL_SERVER, IID_IDispatch, (void**)&app_);
+#endif
+			origin::WorksheetPagePtr wksp = app_->WorksheetPages->Add();
+			wks_ = wksp->Layers->Item[0];
+		}
+		~env() {
+			wks_ = nullptr;
+			app_->Exit();
+			app_.Release();
+			::Sleep(500);
+			::CoUninitialize();
+		}
+		static const char* name() { return "live"; }
+		origin::ColumnPtr new_column() {
+			wks_->Cols = wks_->Cols + 1;
+			return wks_->Columns->Item[wks_->Cols - 1];
+		}
+		origin::WorksheetPtr new_worksheet() {
+			origin::WorksheetPagePtr wksp = app_->WorksheetPages->Add();
+			return wksp->Layers->Item[0];
+		}
+		origin::MatrixObjectPtr new_matrix(std::size_t rows, std::size_t cols) {
+			origin::MatrixPagePtr mp = app_->MatrixPages->Add();
+			origin::MatrixSheetPtr ms = mp->Layers->Item[0];
+			ms->Rows = static_cast<long>(rows);
+			ms->Cols = static_cast<long>(cols);
+			return ms->MatrixObjects->Item[0];
+		}
+	};
+#else
+	/* In-process fake server */
+	class env {
+	public:
+		explicit env(long latency_us = 0) {
+			orglab_data_fake::set_latency(std::chrono::microseconds(latency_us));
+		}
+		static const char* name() { return "fake"; }
+		origin_ns::ColumnPtr new_column() { return orglab_data_fake::make_column(); }
+		origin_ns::WorksheetPtr new_worksheet() { return orglab_data_fake::make_worksheet(); }
+		origin_ns::MatrixObjectPtr new_matrix(std::size_t rows, std::size_t cols) { return orglab_data_fake::make_matrix(rows, cols); }
+	};
+#endif
+
+	//// SUITE ////
+
+	class suite {
+		const options& opt_;
+		env& env_;
+		std::vector<result> results_;
+
+		bool enabled(const std::string& name) const {
+			return opt_.filter.empty() || name.find(opt_.filter) != std::string::npos;
+		}
+
+		void add(result r, const std::string& name, const std::string& type, std::size_t rows, std::size_t cols = 1, std::size_t offset = 0) {
+			r.name = name;
+			r.type = type;
+			r.rows = rows;
+			r.cols = cols;
+			r.offset = offset;
+			r.rows_per_s = r.p50_ns > 0 ? rows * 1e9 / r.p50_ns : 0;
+			std::cerr << name << " " << type << " " << rows << "x" << cols << " @" << offset
+				<< ": p50 " << r.p50_ns / 1e3 << " us, " << r.mb_per_s << " MB/s\n";
+			results_.push_back(r);
+		}
+
+	public:
+		suite(const options& opt, env& e) : opt_(opt), env_(e) {}
+
+		const std::vector<result>& results() const { return results_; }
+
+		std::vector<std::size_t> row_counts() const {
+			std::vector<std::size_t> v;
+			for (std::size_t n = 1; n <= opt_.max_rows; n *= 10)
+				v.push_back(n);
+			return v;
+		}
+
+		std::vector<std::size_t> matrix_sizes() const {
+			std::vector<std::size_t> v;
+			for (std::size_t n = 8; n <= opt_.max_matrix; n *= 4)
+				v.push_back(n);
+			if (v.empty() || v.back() != opt_.max_matrix)
+				v.push_back(opt_.max_matrix);
+			return v;
+		}
+
+		template<class T>
+		void columns() {
+			const char* type = type_traits<T>::name();
+			for (std::size_t rows : row_counts()) {
+				std::vector<T> data = make_data<T>(rows);
+				std::size_t bytes = data_bytes(data);
+				for (std::size_t offset : { std::size_t(0), rows }) {
+					if (enabled("set_column_data")) {
+						origin_ns::ColumnPtr col = env_.new_column();
+						add(measure(opt_, bytes, [&]() { orglab_data::set_column_data(col, data, offset); }),
+							"set_column_data", type, rows, 1, offset);
+					}
+					if (enabled("get_column_data")) {
+						origin_ns::ColumnPtr col = env_.new_column();
+						orglab_data::set_column_data(col, data, offset);
+						add(measure(opt_, bytes, [&]() {
+							std::vector<T> out = orglab_data::get_column_data<T>(col, static_cast<long>(offset), static_cast<long>(rows));
+							}), "get_column_data", type, rows, 1, offset);
+					}
+					if constexpr (std::is_arithmetic<T>::value || std::is_same<T, std::complex<double>>::value) {
+						if (enabled("get_column_data/reuse")) {
+							origin_ns::ColumnPtr col = env_.new_column();
+							orglab_data::set_column_data(col, data, offset);
+							std::vector<T> out(rows);
+							add(measure(opt_, bytes, [&]() {
+								orglab_data::get_column_data(col, out, static_cast<long>(offset), static_cast<long>(rows));
+								}), "get_column_data/reuse", type, rows, 1, offset);
+						}
+					}
+				}
+			}
+		}
+
+		/* Acquisition-style appends of small bursts: one set_column_data per burst against */
+		/* a column_writer with the default flush policy */
+		template<class T>
+		void appends() {
+			const char* type = type_traits<T>::name();
+			const std::size_t burst = 16;
+			for (std::size_t rows : row_counts()) {
+				if (rows < burst || rows > 100000)
+					continue;
+				std::vector<T> data = make_data<T>(rows);
+				std::size_t bytes = data_bytes(data);
+				if (enabled("append/set_column_data")) {
+					origin_ns::ColumnPtr col = env_.new_column();
+					add(measure(opt_, bytes, [&]() {
+						for (std::size_t i = 0; i < rows; i += burst)
+							orglab_data::set_column_data(col, data.data() + i, (std::min)(burst, rows - i), i);
+						}), "append/set_column_data", type, rows);
+				}
+				if (enabled("append/column_writer")) {
+					origin_ns::ColumnPtr col = env_.new_column();
+					add(measure(opt_, bytes, [&]() {
+						orglab_data::column_writer<T> w(col);
+						for (std::size_t i = 0; i < rows; i += burst)
+							w.push(data.data() + i, (std::min)(burst, rows - i));
+						w.flush();
+						}), "append/column_writer", type, rows);
+				}
+			}
+		}
+
+		/* A table of 50 columns: one set_column_data or get_column_data per column against */
+		/* set_worksheet_data and a get_worksheet_data frame */
+		template<class T>
+		void tables() {
+			const char* type = type_traits<T>::name();
+			const std::size_t cols = 50;
+			for (std::size_t rows : row_counts()) {
+				if (rows > 100000)
+					continue;
+				std::vector<std::vector<T>> table(cols, make_data<T>(rows));
+				std::size_t bytes = cols * data_bytes(table[0]);
+				origin_ns::WorksheetPtr wks = env_.new_worksheet();
+				if (enabled("table/set_column_data")) {
+					orglab_data::set_worksheet_data(wks, table); // Creates the columns.
+					origin_ns::ColumnsPtr columns = wks->GetColumns();
+					add(measure(opt_, bytes, [&]() {
+						for (std::size_t k = 0; k < cols; ++k)
+							orglab_data::set_column_data(columns->GetItem(_variant_t(static_cast<long>(k))), table[k]);
+						}), "table/set_column_data", type, rows, cols);
+				}
+				if (enabled("table/set_worksheet_data")) {
+					add(measure(opt_, bytes, [&]() { orglab_data::set_worksheet_data(wks, table); }),
+						"table/set_worksheet_data", type, rows, cols);
+					orglab_data::worksheet_writer writer(wks); // Looks the columns up on its first write only.
+					add(measure(opt_, bytes, [&]() { writer.set_data(table); }),
+						"table/set_worksheet_data", std::string(type) + "/worksheet_writer", rows, cols);
+				}
+				if (enabled("table/get_column_data") || enabled("table/get_worksheet_data")) {
+					orglab_data::set_worksheet_data(wks, table);
+					origin_ns::ColumnsPtr columns = wks->GetColumns();
+					std::vector<std::vector<T>> out(cols);
+					if (enabled("table/get_column_data"))
+						add(measure(opt_, bytes, [&]() {
+							for (std::size_t k = 0; k < cols; ++k)
+								orglab_data::get_column_data(columns->GetItem(_variant_t(static_cast<long>(k))), out[k]);
+							}), "table/get_column_data", type, rows, cols);
+					std::vector<T> frame;
+					std::size_t frame_rows = 0;
+					if (enabled("table/get_worksheet_data"))
+						add(measure(opt_, bytes, [&]() { orglab_data::get_worksheet_data(wks, frame, frame_rows, 0, cols); }),
+							"table/get_worksheet_data", type, rows, cols);
+				}
+			}
+		}
+
+		/* Sequential reduction over a whole column: one get_column_data against column_reader */
+		/* chunks read in the caller's thread and prefetched by a worker */
+		void scans() {
+			const std::size_t chunk = 65536;
+			for (std::size_t rows : row_counts()) {
+				if (rows < chunk)
+					continue;
+				origin_ns::ColumnPtr col = env_.new_column();
+				orglab_data::set_column_data(col, make_data<double>(rows));
+				std::size_t bytes = rows * sizeof(double);
+				volatile double sink = 0;
+				if (enabled("scan/get_column_data"))
+					add(measure(opt_, bytes, [&]() {
+						std::vector<double> all = orglab_data::get_column_data<double>(col);
+						sink = std::accumulate(all.begin(), all.end(), 0.0);
+						}), "scan/get_column_data", "double", rows);
+				for (bool prefetch : { false, true }) {
+					const char* name = prefetch ? "scan/column_reader/prefetch" : "scan/column_reader";
+					if (!enabled(name))
+						continue;
+					add(measure(opt_, bytes, [&]() {
+						double sum = 0;
+						for (const auto& c : orglab_data::column_reader<double>(col, chunk, 0, -1, prefetch))
+							sum = std::accumulate(c.data.begin(), c.data.end(), sum);
+						sink = sum;
+						}), name, "double", rows);
+				}
+			}
+		}
+
+		/* Writes of 8 columns back to back: blocking set_column_data against a transfer_worker */
+		/* that packs the next column while the previous one is in its round-trip */
+		void asyncs() {
+			const std::size_t cols = 8;
+			for (std::size_t rows : row_counts()) {
+				if (rows < 1000)
+					continue;
+				std::vector<double> data = make_data<double>(rows);
+				std::vector<origin_ns::ColumnPtr> columns;
+				for (std::size_t k = 0; k < cols; ++k)
+					columns.push_back(env_.new_column());
+				std::size_t bytes = cols * rows * sizeof(double);
+				if (enabled("async/set_column_data"))
+					add(measure(opt_, bytes, [&]() {
+						for (const origin_ns::ColumnPtr& col : columns)
+							orglab_data::set_column_data(col, data);
+						}), "async/set_column_data", "double", rows, cols);
+				if (enabled("async/transfer_worker")) {
+					orglab_data::transfer_worker worker;
+					std::vector<orglab_data::transfer<void>> pending;
+					add(measure(opt_, bytes, [&]() {
+						for (const origin_ns::ColumnPtr& col : columns)
+							pending.push_back(worker.set_column_data(col, data));
+						for (orglab_data::transfer<void>& t : pending)
+							t.get();
+						pending.clear();
+						}), "async/transfer_worker", "double", rows, cols);
+				}
+			}
+		}
+
+		/* 8 producer threads each appending 16-row bursts to their own column: set_column_data */
+		/* behind a mutex against samples pushed into an ingest_queue */
+		void ingests() {
+			const std::size_t producers = 8;
+			const std::size_t burst = 16;
+			for (std::size_t rows : row_counts()) {
+				if (rows < 1000 || rows > 100000)
+					continue;
+				std::vector<double> data = make_data<double>(rows);
+				std::vector<origin_ns::ColumnPtr> columns;
+				for (std::size_t k = 0; k < producers; ++k)
+					columns.push_back(env_.new_column());
+				std::size_t bytes = producers * rows * sizeof(double);
+				if (enabled("ingest/set_column_data")) {
+					std::mutex mtx;
+					add(measure(opt_, bytes, [&]() {
+						std::vector<std::thread> threads;
+						for (std::size_t k = 0; k < producers; ++k)
+							threads.emplace_back([&, k]() {
+								for (std::size_t i = 0; i < rows; i += burst) {
+									std::lock_guard<std::mutex> lock(mtx);
+									orglab_data::set_column_data(columns[k], data.data() + i, (std::min)(burst, rows - i), i);
+								}
+								});
+						for (std::thread& t : threads)
+							t.join();
+						}), "ingest/set_column_data", "double", rows, producers);
+				}
+				if (enabled("ingest/ingest_queue"))
+					add(measure(opt_, bytes, [&]() {
+						orglab_data::ingest_queue<double> queue;
+						std::vector<std::thread> threads;
+						for (std::size_t k = 0; k < producers; ++k) {
+							std::size_t column = queue.add_column(columns[k]);
+							threads.emplace_back([&, column]() {
+								for (std::size_t i = 0; i < rows; ++i)
+									queue.push(column, data[i]);
+								});
+						}
+						for (std::thread& t : threads)
+							t.join();
+						queue.close();
+						}), "ingest/ingest_queue", "double", rows, producers);
+			}
+		}
+
+		/* Repeated writes of the same column and matrix with the SAFEARRAY pool off and on */
+		void pools() {
+			std::size_t n = opt_.max_matrix;
+			std::vector<std::size_t> rows_list = row_counts();
+			for (bool pooled : { false, true }) {
+				orglab_data::set_array_pool_cap(pooled ? std::size_t(2) << 30 : 0);
+				const char* type = pooled ? "double/pooled" : "double";
+				for (std::size_t rows : rows_list) {
+					if (!enabled("pool/set_column_data"))
+						break;
+					std::vector<double> data = make_data<double>(rows);
+					origin_ns::ColumnPtr col = env_.new_column();
+					add(measure(opt_, rows * sizeof(double), [&]() { orglab_data::set_column_data(col, data); }),
+						"pool/set_column_data", type, rows);
+				}
+				if (enabled("pool/set_matrix_data")) {
+					orglab_data::matrix_adapter<double> ma = make_matrix_data<double>(n, n);
+					origin_ns::MatrixObjectPtr mat = env_.new_matrix(n, n);
+					add(measure(opt_, n * n * sizeof(double), [&]() { orglab_data::set_matrix_data(mat, ma); }),
+						"pool/set_matrix_data", type, n, n);
+				}
+			}
+			orglab_data::set_array_pool_cap(0);
+		}
+
+		/* A mirrored column where each iteration changes a few rows, sent whole against */
+		/* through a column_sync */
+		void column_syncs() {
+			for (std::size_t rows : row_counts()) {
+				if (!enabled("sync/column"))
+					break;
+				std::vector<double> data = make_data<double>(rows);
+				origin_ns::ColumnPtr col = env_.new_column();
+				std::size_t i = 0;
+				auto edit = [&]() {
+					for (std::size_t k = 0; k < 8; ++k, ++i)
+						data[(i * 7919) % rows] += 1.0;
+				};
+				add(measure(opt_, rows * sizeof(double), [&]() { edit(); orglab_data::set_column_data(col, data); }),
+					"sync/column", "double/set_column_data", rows);
+				orglab_data::column_sync cs;
+				cs.sync(col, data);
+				add(measure(opt_, rows * sizeof(double), [&]() { edit(); cs.sync(col, data); }),
+					"sync/column", "double/column_sync", rows);
+			}
+		}
+
+		/* Column writes through a copied SAFEARRAY and through a static descriptor wrapping */
+		/* the caller's buffer (ORGLAB_DATA_ZERO_COPY). Calls impl directly to run both. */
+		template<class T>
+		void zero_copies() {
+			using wire = typename orglab_data::impl::wire_t<T>;
+			std::size_t count = std::is_same<T, std::complex<double>>::value ? 2 : 1;
+			for (std::size_t rows : row_counts()) {
+				std::vector<T> data = make_data<T>(rows);
+				std::size_t bytes = rows * sizeof(T);
+				origin_ns::ColumnPtr col = env_.new_column();
+				orglab_data::set_column_data(col, data);
+				orglab_data::impl::column_write_format wf = orglab_data::impl::prepare_column_write<T>(col, true, false);
+				if (enabled("zerocopy/set_column_data"))
+					add(measure(opt_, bytes, [&]() { orglab_data::impl::write_column_data(col, wf, data.data(), rows, 0); }),
+						"zerocopy/set_column_data", std::string(type_traits<T>::name()) + "/copy", rows);
+				if (enabled("zerocopy/set_column_data") && sizeof(wire) == sizeof(T))
+					add(measure(opt_, bytes, [&]() {
+						if (!orglab_data::impl::send_wrapped_column_data(col, wf.vt, data.data(), rows * count, 0))
+							throw std::runtime_error("Server refused a zero-copy array");
+					}),
+						"zerocopy/set_column_data", std::string(type_traits<T>::name()) + "/wrapped", rows);
+				if (data != make_data<T>(rows)) // SafeArrayDestroy zero-fills static data it is given.
+					throw std::runtime_error("Zero-copy write changed the caller's buffer");
+			}
+		}
+
+		/* Text column reads into a vector of strings and into a reused string_column arena */
+		template<class C>
+		void arenas() {
+			using S = std::basic_string<C>;
+			for (std::size_t rows : row_counts()) {
+				if (!enabled("arena/get_column_data"))
+					break;
+				std::vector<S> data = make_data<S>(rows);
+				std::size_t bytes = 0;
+				for (const S& s : data)
+					bytes += type_traits<S>::bytes(s);
+				origin_ns::ColumnPtr col = env_.new_column();
+				orglab_data::set_column_data(col, data);
+				add(measure(opt_, bytes, [&]() { orglab_data::get_column_data<S>(col); }),
+					"arena/get_column_data", std::string(type_traits<S>::name()) + "/vector", rows);
+				orglab_data::basic_string_column<C> sc;
+				orglab_data::get_column_data(col, sc);
+				add(measure(opt_, bytes, [&]() { orglab_data::get_column_data(col, sc); }),
+					"arena/get_column_data", std::string(type_traits<S>::name()) + "/string_column", rows);
+			}
+		}
+
+		/* Text columns of 256 distinct values written and read as strings and as categories */
+		void categoricals() {
+			for (std::size_t rows : row_counts()) {
+				std::vector<std::string> data(rows);
+				orglab_data::categorical_column<std::string> cc;
+				std::size_t bytes = 0;
+				for (std::size_t i = 0; i < rows; ++i) {
+					data[i] = "sensor_\xc3\xa9_" + std::to_string(i % 256);
+					cc.push_back(data[i]);
+					bytes += data[i].size();
+				}
+				origin_ns::ColumnPtr col = env_.new_column();
+				if (enabled("category/set_column_data")) {
+					add(measure(opt_, bytes, [&]() { orglab_data::set_column_data(col, data); }),
+						"category/set_column_data", "std::string", rows);
+					add(measure(opt_, bytes, [&]() { orglab_data::set_column_data(col, cc); }),
+						"category/set_column_data", "categorical_column<std::string>", rows);
+				}
+				if (enabled("category/get_column_data")) {
+					orglab_data::set_column_data(col, cc);
+					add(measure(opt_, bytes, [&]() { orglab_data::get_column_data<std::string>(col); }),
+						"category/get_column_data", "std::string", rows);
+					orglab_data::categorical_column<std::string> out;
+					add(measure(opt_, bytes, [&]() { orglab_data::get_column_data(col, out); }),
+						"category/get_column_data", "categorical_column<std::string>", rows);
+				}
+			}
+		}
+
+		/* UTF-8 <-> wchar_t transcoding of the std::string cells of a column joined into one */
+		/* text, with the Win32 functions (the fake's portable stand-ins off Windows) and impl. */
+		void transcodes() {
+			for (std::size_t rows : row_counts()) {
+				std::vector<std::string> cells = make_data<std::string>(rows);
+				std::string text;
+				for (const std::string& c : cells)
+					text += c;
+				std::wstring wide = orglab_data::impl::to_wide(text);
+				std::wstring wout(wide.size(), L'\0');
+				std::string out(text.size(), '\0');
+				int n = static_cast<int>(text.size()), wn = static_cast<int>(wide.size());
+				if (enabled("utf8/to_wide")) {
+					add(measure(opt_, text.size(), [&]() { ::MultiByteToWideChar(CP_UTF8, 0, text.data(), n, &wout[0], wn); }),
+						"utf8/to_wide", "MultiByteToWideChar", rows);
+					add(measure(opt_, text.size(), [&]() { orglab_data::impl::utf8_to_wide(&wout[0], text.data(), text.size()); }),
+						"utf8/to_wide", "orglab_data", rows);
+				}
+				if (enabled("utf8/from_wide")) {
+					add(measure(opt_, text.size(), [&]() { ::WideCharToMultiByte(CP_UTF8, 0, wide.data(), wn, &out[0], n, NULL, NULL); }),
+						"utf8/from_wide", "WideCharToMultiByte", rows);
+					add(measure(opt_, text.size(), [&]() { orglab_data::impl::wide_to_utf8(&out[0], wide.data(), wide.size()); }),
+						"utf8/from_wide", "orglab_data", rows);
+				}
+			}
+		}
+
+		/* Type-converting transfers (ORGLAB_DATA_CONVERT_DATA_TYPE) of doubles to and from a */
+		/* column stored as S. Calls impl directly so the other cases keep default behavior. */
+		template<class S>
+		void conversions(origin_ns::COLDATAFORMAT fmt) {
+			std::string type = std::string("double<->") + type_traits<S>::name();
+			for (std::size_t rows : row_counts()) {
+				std::vector<double> data = make_data<double>(rows);
+				std::size_t bytes = rows * sizeof(double);
+				origin_ns::ColumnPtr col = env_.new_column();
+				col->PutDataFormat(fmt);
+				if (enabled("convert/set_column_data"))
+					add(measure(opt_, bytes, [&]() { orglab_data::impl::set_arithmetic_column_data(col, data.data(), rows, 0, true, true); }),
+						"convert/set_column_data", type, rows);
+				if (enabled("convert/get_column_data")) {
+					orglab_data::impl::set_arithmetic_column_data(col, data.data(), rows, 0, true, true);
+					std::vector<double> out(rows);
+					add(measure(opt_, bytes, [&]() { orglab_data::impl::get_arithmetic_column_data(col, out, 0, static_cast<long>(rows), true); }),
+						"convert/get_column_data", type, rows);
+				}
+			}
+		}
+
+		/* Complex transfers and a double to short conversion at each SIMD level */
+		void simd_levels() {
+			using C = std::complex<double>;
+			const orglab_data::simd_level initial = orglab_data::get_simd_level();
+			const char* names[] = { "scalar", "sse2", "avx2" };
+			std::size_t rows = opt_.max_rows;
+			std::size_t n = opt_.max_matrix;
+			std::vector<C> column = make_data<C>(rows);
+			std::vector<double> real = make_data<double>(rows);
+			orglab_data::matrix_adapter<C> ma = make_matrix_data<C>(n, n);
+			for (orglab_data::simd_level level : { orglab_data::simd_level::scalar, orglab_data::simd_level::sse2, orglab_data::simd_level::avx2 }) {
+				if (orglab_data::set_simd_level(level) != level)
+					continue; // Not supported here.
+				std::string type = std::string("std::complex<double>/") + names[static_cast<int>(level)];
+				if (enabled("simd/set_column_data")) {
+					origin_ns::ColumnPtr col = env_.new_column();
+					add(measure(opt_, rows * sizeof(C), [&]() { orglab_data::set_column_data(col, column); }), "simd/set_column_data", type, rows);
+				}
+				if (enabled("simd/get_column_data")) {
+					origin_ns::ColumnPtr col = env_.new_column();
+					orglab_data::set_column_data(col, column);
+					std::vector<C> out;
+					add(measure(opt_, rows * sizeof(C), [&]() { orglab_data::get_column_data(col, out); }), "simd/get_column_data", type, rows);
+				}
+				if (enabled("simd/set_matrix_data") || enabled("simd/get_matrix_data")) {
+					origin_ns::MatrixObjectPtr mat = env_.new_matrix(n, n);
+					if (enabled("simd/set_matrix_data"))
+						add(measure(opt_, n * n * sizeof(C), [&]() { orglab_data::set_matrix_data(mat, ma); }), "simd/set_matrix_data", type, n, n);
+					if (enabled("simd/get_matrix_data")) {
+						orglab_data::set_matrix_data(mat, ma);
+						orglab_data::matrix_adapter<C> out;
+						add(measure(opt_, n * n * sizeof(C), [&]() { orglab_data::get_matrix_data(mat, out); }), "simd/get_matrix_data", type, n, n);
+					}
+				}
+				if (enabled("simd/interleave_complex")) {
+					std::vector<double> planes(2 * n * n, 1.0);
+					std::vector<C> out(n * n);
+					add(measure(opt_, n * n * sizeof(C), [&]() { orglab_data::impl::interleave_complex(out.data(), planes.data(), planes.data() + n * n, n * n); }),
+						"simd/interleave_complex", type, n, n);
+				}
+				if (enabled("simd/deinterleave_transpose_complex")) {
+					std::vector<double> planes(2 * n * n);
+					add(measure(opt_, n * n * sizeof(C), [&]() { orglab_data::impl::deinterleave_transpose_complex(planes.data(), planes.data() + n * n, ma.data(), n, n, n); }),
+						"simd/deinterleave_transpose_complex", type, n, n);
+				}
+				if (enabled("simd/convert")) {
+					std::vector<short> out(rows);
+					std::string conv = std::string("double->short/") + names[static_cast<int>(level)];
+					add(measure(opt_, rows * sizeof(double), [&]() { orglab_data::impl::convert_values(out.data(), real.data(), rows); }), "simd/convert", conv, rows);
+				}
+			}
+			orglab_data::set_simd_level(initial);
+		}
+
+		/* Tiled transpose engine at each SIMD level against the plain double loop it replaced */
+		/* in set_matrix_data and matrix_adapter::transpose, plus the in-place transpose_self. */
+		/* Non-square to keep both strides odd. */
+		template<class T>
+		void transposes() {
+			const orglab_data::simd_level initial = orglab_data::get_simd_level();
+			const char* names[] = { "scalar", "sse2", "avx2" };
+			for (std::size_t n : matrix_sizes()) {
+				std::size_t rows = n, cols = n > 8 ? n - 3 : n;
+				std::vector<T> src = make_data<T>(rows * cols);
+				std::vector<T> dst(rows * cols);
+				std::size_t bytes = rows * cols * sizeof(T);
+				if (enabled("transpose/naive"))
+					add(measure(opt_, bytes, [&]() {
+						for (std::size_t k = 0; k < cols; ++k)
+							for (std::size_t j = 0; j < rows; ++j)
+								dst[cols * j + k] = src[rows * k + j];
+						}), "transpose/naive", type_traits<T>::name(), rows, cols);
+				if (enabled("transpose/in_place")) {
+					orglab_data::matrix_adapter<T> work(rows, cols);
+					std::copy(src.begin(), src.end(), work.data());
+					add(measure(opt_, bytes, [&]() { work.transpose_self(); }), "transpose/in_place", type_traits<T>::name(), rows, cols);
+				}
+				if (!enabled("transpose/tiled"))
+					continue;
+				for (orglab_data::simd_level level : { orglab_data::simd_level::scalar, orglab_data::simd_level::sse2, orglab_data::simd_level::avx2 }) {
+					if (orglab_data::set_simd_level(level) != level)
+						continue;
+					std::string type = std::string(type_traits<T>::name()) + "/" + names[static_cast<int>(level)];
+					add(measure(opt_, bytes, [&]() { orglab_data::impl::transpose(dst.data(), cols, src.data(), rows, rows, cols); }),
+						"transpose/tiled", type, rows, cols);
+				}
+			}
+			orglab_data::set_simd_level(initial);
+		}
+
+		template<class T>
+		void matrices() {
+			const char* type = type_traits<T>::name();
+			for (std::size_t n : matrix_sizes()) {
+				orglab_data::matrix_adapter<T> ma = make_matrix_data<T>(n, n);
+				std::size_t bytes = n * n * sizeof(T);
+				if (enabled("set_matrix_data") || enabled("get_matrix_data")) {
+					origin_ns::MatrixObjectPtr mat = env_.new_matrix(n, n);
+					if (enabled("set_matrix_data"))
+						add(measure(opt_, bytes, [&]() { orglab_data::set_matrix_data(mat, ma); }), "set_matrix_data", type, n, n);
+					if (enabled("get_matrix_data")) {
+						orglab_data::set_matrix_data(mat, ma);
+						add(measure(opt_, bytes, [&]() {
+							orglab_data::matrix_adapter<T> out = orglab_data::get_matrix_data<T>(mat);
+							}), "get_matrix_data", type, n, n);
+					}
+					if (enabled("get_matrix_data/reuse")) {
+						orglab_data::set_matrix_data(mat, ma);
+						orglab_data::matrix_adapter<T> out(n, n);
+						add(measure(opt_, bytes, [&]() { orglab_data::get_matrix_data(mat, out); }), "get_matrix_data/reuse", type, n, n);
+					}
+				}
+				if (enabled("matrix_adapter::transpose")) {
+					add(measure(opt_, bytes, [&]() { orglab_data::matrix_adapter<T> t = ma.transpose(); }),
+						"matrix_adapter::transpose", type, n, n);
+				}
+				if (enabled("matrix_adapter::transpose_self")) {
+					orglab_data::matrix_adapter<T> work = ma;
+					add(measure(opt_, bytes, [&]() { work.transpose_self(); }), "matrix_adapter::transpose_self", type, n, n);
+				}
+				if (enabled("matrix_adapter::operator<<") && n <= 1024) {
+					std::size_t dumped = 0;
+					result r = measure(opt_, bytes, [&]() {
+						std::ostringstream os;
+						os << ma;
+						dumped = os.str().size();
+						});
+					r.mb_per_s = r.p50_ns > 0 ? dumped / r.p50_ns * 1e9 / (1024.0 * 1024.0) : 0; // Text produced.
+					add(r, "matrix_adapter::operator<<", type, n, n);
+				}
+			}
+		}
+
+		/* Matrices in caller memory (as from Eigen or Armadillo), copied into a matrix_adapter */
+		/* and set or got and copied out, against a matrix_view of the same buffer */
+		void views() {
+			for (std::size_t n : matrix_sizes()) {
+				std::vector<double> buf = make_data<double>(n * n);
+				std::size_t bytes = n * n * sizeof(double);
+				origin_ns::MatrixObjectPtr mat = env_.new_matrix(n, n);
+				if (enabled("view/set_matrix_data")) {
+					add(measure(opt_, bytes, [&]() {
+						orglab_data::matrix_adapter<double> ma(buf.data(), n, n);
+						orglab_data::set_matrix_data(mat, ma);
+						}), "view/set_matrix_data", "double/adapter", n, n);
+					orglab_data::matrix_view<const double> v(buf.data(), n, n);
+					add(measure(opt_, bytes, [&]() { orglab_data::set_matrix_data(mat, v); }), "view/set_matrix_data", "double/view", n, n);
+				}
+				if (enabled("view/get_matrix_data")) {
+					add(measure(opt_, bytes, [&]() {
+						orglab_data::matrix_adapter<double> ma = orglab_data::get_matrix_data<double>(mat);
+						std::copy(ma.begin(), ma.end(), buf.begin());
+						}), "view/get_matrix_data", "double/adapter", n, n);
+					orglab_data::matrix_view<double> v(buf.data(), n, n);
+					add(measure(opt_, bytes, [&]() { orglab_data::get_matrix_data(mat, v); }), "view/get_matrix_data", "double/view", n, n);
+				}
+			}
+		}
+
+		/* Matrix transfers of column major and row major matrix_adapters. Row major matches */
+		/* the SetData layout, so it packs with a copy (or none with ORGLAB_DATA_ZERO_COPY). */
+		template<orglab_data::storage_order O>
+		void orders(const char* type) {
+			for (std::size_t n : matrix_sizes()) {
+				orglab_data::matrix_adapter<double, O> ma(n, n);
+				std::vector<double> data = make_data<double>(n * n);
+				std::copy(data.begin(), data.end(), ma.begin());
+				std::size_t bytes = n * n * sizeof(double);
+				origin_ns::MatrixObjectPtr mat = env_.new_matrix(n, n);
+				if (enabled("order/set_matrix_data"))
+					add(measure(opt_, bytes, [&]() { orglab_data::set_matrix_data(mat, ma); }), "order/set_matrix_data", type, n, n);
+				if (enabled("order/get_matrix_data")) {
+					orglab_data::set_matrix_data(mat, ma);
+					orglab_data::matrix_adapter<double, O> out(n, n);
+					add(measure(opt_, bytes, [&]() { orglab_data::get_matrix_data(mat, out); }), "order/get_matrix_data", type, n, n);
+				}
+			}
+		}
+
+		/* Updating and reading back an n/8 square region of interest of the largest matrix, */
+		/* moving the whole matrix against only the region. rows and cols are the region's. */
+		void regions() {
+			std::size_t n = opt_.max_matrix, m = (std::max)(std::size_t(1), n / 8);
+			orglab_data::matrix_adapter<double> ma = make_matrix_data<double>(n, n);
+			orglab_data::matrix_adapter<double> roi = make_matrix_data<double>(m, m);
+			origin_ns::MatrixObjectPtr mat = env_.new_matrix(n, n);
+			orglab_data::set_matrix_data(mat, ma);
+			std::size_t bytes = m * m * sizeof(double);
+			if (enabled("region/set_matrix_data")) {
+				add(measure(opt_, bytes, [&]() { orglab_data::set_matrix_data(mat, ma); }), "region/set_matrix_data", "double/whole", m, m);
+				add(measure(opt_, bytes, [&]() { orglab_data::set_matrix_data(mat, roi, n / 2, n / 2); }), "region/set_matrix_data", "double/region", m, m);
+			}
+			if (enabled("region/get_matrix_data")) {
+				orglab_data::matrix_adapter<double> out;
+				add(measure(opt_, bytes, [&]() { orglab_data::get_matrix_data(mat, out); }), "region/get_matrix_data", "double/whole", m, m);
+				add(measure(opt_, bytes, [&]() { orglab_data::get_matrix_data(mat, out, n / 2, n / 2, m, m); }), "region/get_matrix_data", "double/region", m, m);
+			}
+		}
+
+		void syncs() {
+			if (!enabled("sync/sync_matrix_data"))
+				return;
+			std::size_t n = opt_.max_matrix, m = (std::min)(n, std::size_t(64));
+			orglab_data::matrix_adapter<double> ma = make_matrix_data<double>(n, n);
+			origin_ns::MatrixObjectPtr mat = env_.new_matrix(n, n);
+			orglab_data::set_matrix_data(mat, ma);
+			std::size_t bytes = m * m * sizeof(double), frame = 0;
+			// Each frame changes one m x m patch, moving across the matrix.
+			auto edit = [&]() {
+				std::size_t r0 = (frame * m) % (n - m + 1), c0 = (frame * 3 * m) % (n - m + 1);
+				for (std::size_t c = c0; c < c0 + m; ++c)
+					for (std::size_t r = r0; r < r0 + m; ++r)
+						ma(r, c) += 1.0;
+				++frame;
+			};
+			add(measure(opt_, bytes, [&]() { edit(); orglab_data::sync_matrix_data(mat, ma); }), "sync/sync_matrix_data", "double/untracked", m, m);
+			ma.track_dirty(m);
+			orglab_data::sync_matrix_data(mat, ma);
+			add(measure(opt_, bytes, [&]() { edit(); orglab_data::sync_matrix_data(mat, ma); }), "sync/sync_matrix_data", "double/dirty", m, m);
+		}
+
+		/* Writes a block of columns with set_worksheet_data and checks each column read */
+		/* on its own (1D, no layout involved) and the block read back with one 2D GetData. */
+		/* Catches a server whose 2D layouts differ from what the library assumes, which */
+		/* would transpose every block. Throws on a mismatch. */
+		void check_block_layout() {
+			const std::size_t rows = 5, cols = 3;
+			std::vector<std::vector<double>> block(cols, std::vector<double>(rows));
+			for (std::size_t c = 0; c < cols; ++c)
+				for (std::size_t r = 0; r < rows; ++r)
+					block[c][r] = 100.0 * c + r;
+			origin_ns::WorksheetPtr wks = env_.new_worksheet();
+			orglab_data::set_worksheet_data(wks, block);
+			origin_ns::ColumnsPtr columns = orglab_data::impl::do_get_wks_columns(wks);
+			for (std::size_t c = 0; c < cols; ++c) {
+				std::vector<double> col = orglab_data::get_column_data<double>(orglab_data::impl::do_get_wks_col(columns, static_cast<long>(c)));
+				if (col != block[c])
+					throw std::runtime_error("Worksheet block write layout does not match the server");
+			}
+			std::vector<double> frame;
+			std::size_t frame_rows = 0;
+			orglab_data::get_worksheet_data(wks, frame, frame_rows, 0, cols);
+			for (std::size_t c = 0; c < cols; ++c)
+				for (std::size_t r = 0; r < rows; ++r)
+					if (frame_rows != rows || frame[rows * c + r] != block[c][r])
+						throw std::runtime_error("Worksheet block read layout does not match the server");
+		}
+
+		void run() {
+			check_block_layout();
+			columns<double>();
+			columns<float>();
+			columns<int>();
+			columns<long>();
+			columns<unsigned long>();
+			columns<short>();
+			columns<unsigned short>();
+			columns<byte>();
+			columns<char>();
+			columns<std::complex<double>>();
+			columns<std::wstring>();
+			columns<std::string>();
+			appends<double>();
+			appends<short>();
+			scans();
+			tables<double>();
+			tables<short>();
+			asyncs();
+			ingests();
+			pools();
+			zero_copies<double>();
+			zero_copies<std::complex<double>>();
+			transcodes();
+			arenas<char>();
+			arenas<wchar_t>();
+			categoricals();
+			conversions<float>(origin_ns::DF_FLOAT);
+			conversions<short>(origin_ns::DF_SHORT);
+			conversions<unsigned short>(origin_ns::DF_USHORT);
+			conversions<byte>(origin_ns::DF_BYTE);
+			simd_levels();
+			transposes<double>();
+			transposes<float>();
+			transposes<short>();
+			transposes<std::complex<double>>();
+			views();
+			orders<orglab_data::storage_order::col_major>("double/col_major");
+			orders<orglab_data::storage_order::row_major>("double/row_major");
+			regions();
+			syncs();
+			column_syncs();
+			matrices<double>();
+			matrices<float>();
+			matrices<int>();
+			matrices<long>();
+			matrices<unsigned long>();
+			matrices<short>();
+			matrices<unsigned short>();
+			matrices<byte>();
+			matrices<char>();
+			matrices<std::complex<double>>();
+		}
+	};
+
+	inline void write_json(std::ostream& os, const options& opt, const std::vector<result>& results) {
+		os << "{\n  \"benchmark\": \"orglab_data\",\n  \"backend\": \"" << env::name() << "\",\n"
+			<< "  \"latency_us\": " << opt.latency_us << ",\n  \"max_rows\": " << opt.max_rows << ",\n"
+			<< "  \"max_matrix\": " << opt.max_matrix << ",\n  \"results\": [\n";
+		char buf[512];
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			const result& r = results[i];
+			std::snprintf(buf, sizeof(buf),
+				"    {\"name\": \"%s\", \"type\": \"%s\", \"rows\": %zu, \"cols\": %zu, \"offset\": %zu, \"iterations\": %zu, "
+				"\"p50_ns\": %.0f, \"p99_ns\": %.0f, \"rows_per_s\": %.6g, \"mb_per_s\": %.6g, \"peak_bytes\": %zu, \"allocs\": %.6g}%s\n",
+				r.name.c_str(), r.type.c_str(), r.rows, r.cols, r.offset, r.iterations, r.p50_ns, r.p99_ns,
+				r.rows_per_s, r.mb_per_s, r.peak_bytes, r.allocs, i + 1 < results.size() ? "," : "");
+			os << buf;
+		}
+		os << "  ]\n}\n";
+	}
+
+	inline options parse(int argc, char** argv) {
+		options opt;
+		for (int i = 1; i < argc; ++i) {
+			std::string a = argv[i];
+			auto next = [&]() -> std::string {
+				if (i + 1 >= argc)
+					throw std::runtime_error("Missing value for " + a);
+				return argv[++i];
+			};
+			if ("--max-rows" == a) opt.max_rows = static_cast<std::size_t>(std::stod(next()));
+			else if ("--max-matrix" == a) opt.max_matrix = (std::min)(static_cast<std::size_t>(std::stod(next())), std::size_t(65535));
+			else if ("--latency-us" == a) opt.latency_us = std::stol(next());
+			else if ("--min-iters" == a) opt.min_iters = (std::max)(std::size_t(1), static_cast<std::size_t>(std::stoul(next())));
+			else if ("--max-seconds" == a) opt.max_seconds = std::stod(next());
+			else if ("--filter" == a) opt.filter = next();
+			else if ("--out" == a) opt.out = next();
+			else throw std::runtime_error("Unknown option " + a);
+		}
+		return opt;
+	}
+
+}
+
+int main(int argc, char** argv) {
+	try {
+		bench::options opt = bench::parse(argc, argv);
+#ifdef ORGLAB_DATA_BENCH_LIVE
+		bench::env e;
+#else
+		bench::env e(opt.latency_us);
+#endif
+		bench::suite s(opt, e);
+		s.run();
+		if (opt.out.empty())
+			bench::write_json(std::cout, opt, s.results());
+		else {
+			std::ofstream f(opt.out);
+			bench::write_json(f, opt, s.results());
+		}
+	}
+	catch (const std::exception& e) {
+		std::cerr << "orglab_data_benchmark: " << e.what() << "\n";
+		return 1;
+	}
+#ifdef ORGLAB_DATA_BENCH_LIVE
+	catch (const _com_error& e) {
+		std::cerr << "orglab_data_benchmark: COM error 0x" << std::hex << static_cast<unsigned long>(e.Error()) << "\n";
+		return 1;
+	}
+#endif
+	return 0;
+}
@@ -2,8 +2,6 @@
 #include <conio.h>
 #include <exception>
 #include <vector>
-#include <random>
-#include <chrono>
 #include <mutex>
 #include <filesystem>
 #include <Shlobj.h>
@@ -32,21 +30,6 @@
 
 
 namespace my_utils {
-	template <typename T>
-	std::vector<T> get_test_data(long n, long initial = 0, bool sort = false) {
-		std::random_device rd;
-		std::default_random_engine rng(rd());
-		std::uniform_real_distribution<> dist(0, n);
-		std::vector<T> data;
-		data.reserve(n);
-		std::generate_n(std::back_inserter(data), n, [&]() {
-			return initial + dist(rng);
-			});
-		if (sort)
-			std::sort(data.begin(), data.end());
-		return data;
-	}
-
 	std::wstring get_user_documents_folder() {
 		std::wstring wstr;
 		PWSTR buf1 = NULL;
@@ -225,21 +208,7 @@ int main()
 		}
 
 
-		// How about a performance test?!?
-		wks_ptr->Cols = wks_ptr->Cols++;
-		origin::ColumnPtr col_ptr_1e6 = wks_ptr->Columns->Item[wks_ptr->Cols - 1];
-		std::vector<double> vec_in_1e6 = my_utils::get_test_data<double>(1e6);
-
-		// Quick and dirty perf counter.
-		std::chrono::time_point<std::chrono::steady_clock> start = std::chrono::steady_clock::now();
-		orglab_data::set_column_data<double>(col_ptr_1e6, vec_in_1e6);
-		auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
-		std::cout << "Write 1E6 rows: " << duration.count() << " ms" << std::endl;
-
-		start = std::chrono::steady_clock::now();
-		std::vector<double> vec_out_1e6 = orglab_data::get_column_data<double>(col_ptr_1e6);
-		duration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
-		std::cout << "Write 1E6 rows: " << duration.count() << " ms" << std::endl;
+		// For performance measurements see ../orglab_data_benchmark.
 
 
 		// Setting and getting matrix data.
@@ -0,0 +1,1535 @@
+/*
+MIT License
+
+Copyright(c) 2020 OriginLab Corporation
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/*
+In-process fake Origin server for orglab_data.hpp.
+
+Stands in for the namespace produced by #import'ing Origin8.tlb or orglab.tlb.
+Include it instead of the #import and before orglab_data.hpp:
+
+	#include "orglab_data_fake.hpp"
+	#include "orglab_data.hpp"
+
+	orglab_data_fake::ColumnPtr col = orglab_data_fake::make_column();
+	orglab_data::set_column_data(col, vec);
+
+Columns and matrices are stored the way Origin stores them: typed per their
+COLDATAFORMAT, complex values interleaved (re,im,re,im...), matrices column
+major and text as BSTR cells. Worksheets hold columns. Every COM-shaped method counts as one round-trip
+and can be given an artificial latency to mimic the out-of-process server.
+
+On Windows the real OLE Automation SAFEARRAY, BSTR and VARIANT functions are
+used. Everywhere else a minimal portable implementation of the subset used by
+orglab_data.hpp is provided below so the library builds with GCC and Clang.
+*/
+#ifndef ORGLAB_DATA_FAKE_HPP
+#define ORGLAB_DATA_FAKE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <comutil.h>
+#include <comdef.h>
+#include <atlsafe.h>
+#else
+
+//// PORTABLE OLE AUTOMATION SUBSET (NON-WINDOWS ONLY) ////
+
+typedef long LONG;
+typedef unsigned long ULONG;
+typedef unsigned long DWORD;
+typedef unsigned int UINT;
+typedef int INT;
+typedef short SHORT;
+typedef unsigned short USHORT;
+typedef unsigned short WORD;
+typedef unsigned short VARTYPE;
+typedef unsigned char BYTE;
+typedef unsigned char byte;
+typedef float FLOAT;
+typedef double DOUBLE;
+typedef int HRESULT; // 32 bits as on Windows, so FAILED sees the severity bit.
+typedef short VARIANT_BOOL;
+typedef wchar_t OLECHAR;
+typedef OLECHAR* BSTR;
+typedef const OLECHAR* LPCOLESTR;
+
+#define S_OK ((HRESULT)0L)
+#define S_FALSE ((HRESULT)1L)
+#define E_UNEXPECTED ((HRESULT)0x8000FFFFL)
+#define E_INVALIDARG ((HRESULT)0x80070057L)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000EL)
+#define DISP_E_BADINDEX ((HRESULT)0x8002000BL)
+#define DISP_E_ARRAYISLOCKED ((HRESULT)0x8002000DL)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define VARIANT_TRUE ((VARIANT_BOOL)-1)
+#define VARIANT_FALSE ((VARIANT_BOOL)0)
+#define CP_UTF8 65001
+#define COINIT_MULTITHREADED 0x0
+#define COINIT_APARTMENTTHREADED 0x2
+#define COINIT_DISABLE_OLE1DDE 0x4
+
+/* What a failed call through a #import wrapper throws */
+class _com_error {
+	HRESULT hr_;
+public:
+	explicit _com_error(HRESULT hr) : hr_(hr) {}
+	HRESULT Error() const { return hr_; }
+};
+
+enum VARENUM {
+	VT_EMPTY = 0, VT_NULL = 1, VT_I2 = 2, VT_I4 = 3, VT_R4 = 4, VT_R8 = 5, VT_BSTR = 8,
+	VT_ERROR = 10, VT_BOOL = 11, VT_VARIANT = 12, VT_I1 = 16, VT_UI1 = 17, VT_UI2 = 18,
+	VT_UI4 = 19, VT_I8 = 20, VT_UI8 = 21, VT_INT = 22, VT_UINT = 23,
+	VT_ARRAY = 0x2000, VT_BYREF = 0x4000, VT_TYPEMASK = 0xfff
+};
+
+#define FADF_AUTO 0x0001
+#define FADF_STATIC 0x0002
+#define FADF_EMBEDDED 0x0004
+#define FADF_FIXEDSIZE 0x0010
+#define FADF_HAVEVARTYPE 0x0080
+#define FADF_BSTR 0x0100
+#define FADF_VARIANT 0x0800
+
+struct SAFEARRAYBOUND {
+	ULONG cElements;
+	LONG lLbound;
+};
+
+struct SAFEARRAY {
+	USHORT cDims;
+	USHORT fFeatures;
+	ULONG cbElements;
+	ULONG cLocks;
+	void* pvData;
+	SAFEARRAYBOUND rgsabound[1]; // Stored right-most dimension first, as on Windows.
+};
+
+struct VARIANT {
+	VARTYPE vt;
+	WORD wReserved1, wReserved2, wReserved3;
+	union {
+		long long llVal;
+		LONG lVal;
+		BYTE bVal;
+		SHORT iVal;
+		FLOAT fltVal;
+		DOUBLE dblVal;
+		VARIANT_BOOL boolVal;
+		char cVal;
+		USHORT uiVal;
+		ULONG ulVal;
+		INT intVal;
+		UINT uintVal;
+		BSTR bstrVal;
+		SAFEARRAY* parray;
+	};
+};
+typedef VARIANT VARIANTARG;
+
+namespace orglab_data_fake {
+	namespace ole { // Implementation details of the portable subset.
+
+		// Hidden header in front of every descriptor holds the VARTYPE, like Windows does.
+		constexpr std::size_t sa_header = 16;
+
+		inline std::size_t vt_size(VARTYPE vt) {
+			switch (vt) {
+			case VT_I1: case VT_UI1: return 1;
+			case VT_I2: case VT_UI2: case VT_BOOL: return 2;
+			case VT_I4: case VT_UI4: case VT_R4: case VT_INT: case VT_UINT: case VT_ERROR: return 4;
+			case VT_R8: case VT_I8: case VT_UI8: return 8;
+			case VT_BSTR: return sizeof(BSTR);
+			case VT_VARIANT: return sizeof(VARIANT);
+			default: return 0;
+			}
+		}
+
+		inline std::size_t element_count(const SAFEARRAY* psa) {
+			std::size_t n = 1;
+			for (USHORT i = 0; i < psa->cDims; ++i)
+				n *= psa->rgsabound[i].cElements;
+			return n;
+		}
+
+		inline VARTYPE& vartype_of(SAFEARRAY* psa) {
+			return *reinterpret_cast<VARTYPE*>(reinterpret_cast<unsigned char*>(psa) - 4);
+		}
+
+	}
+}
+
+inline BSTR SysAllocStringLen(const OLECHAR* str, UINT len) {
+	void* base = ::operator new(sizeof(std::uint64_t) + (static_cast<std::size_t>(len) + 1) * sizeof(OLECHAR), std::nothrow);
+	if (!base)
+		return nullptr;
+	*reinterpret_cast<std::uint32_t*>(static_cast<unsigned char*>(base) + 4) = static_cast<std::uint32_t>(len * sizeof(OLECHAR));
+	BSTR bstr = reinterpret_cast<BSTR>(static_cast<unsigned char*>(base) + sizeof(std::uint64_t));
+	if (str)
+		std::memcpy(bstr, str, len * sizeof(OLECHAR));
+	bstr[len] = L'\0';
+	return bstr;
+}
+
+inline BSTR SysAllocString(const OLECHAR* str) {
+	if (!str)
+		return nullptr;
+	return ::SysAllocStringLen(str, static_cast<UINT>(std::wcslen(str)));
+}
+
+inline UINT SysStringLen(BSTR bstr) {
+	if (!bstr)
+		return 0;
+	return *reinterpret_cast<const std::uint32_t*>(reinterpret_cast<const unsigned char*>(bstr) - 4) / sizeof(OLECHAR);
+}
+
+inline void SysFreeString(BSTR bstr) {
+	if (bstr)
+		::operator delete(reinterpret_cast<unsigned char*>(bstr) - sizeof(std::uint64_t));
+}
+
+inline HRESULT SafeArrayAllocDescriptor(UINT cDims, SAFEARRAY** ppsaOut) {
+	if (!ppsaOut || 0 == cDims)
+		return E_INVALIDARG;
+	std::size_t sz = orglab_data_fake::ole::sa_header + sizeof(SAFEARRAY) + (cDims - 1) * sizeof(SAFEARRAYBOUND);
+	unsigned char* base = static_cast<unsigned char*>(::operator new(sz, std::nothrow));
+	if (!base)
+		return E_OUTOFMEMORY;
+	std::memset(base, 0, sz);
+	SAFEARRAY* psa = reinterpret_cast<SAFEARRAY*>(base + orglab_data_fake::ole::sa_header);
+	psa->cDims = static_cast<USHORT>(cDims);
+	*ppsaOut = psa;
+	return S_OK;
+}
+
+inline HRESULT SafeArrayAllocDescriptorEx(VARTYPE vt, UINT cDims, SAFEARRAY** ppsaOut) {
+	std::size_t cb = orglab_data_fake::ole::vt_size(vt);
+	if (0 == cb)
+		return E_INVALIDARG;
+	HRESULT hr = ::SafeArrayAllocDescriptor(cDims, ppsaOut);
+	if (FAILED(hr))
+		return hr;
+	SAFEARRAY* psa = *ppsaOut;
+	psa->cbElements = static_cast<ULONG>(cb);
+	psa->fFeatures = FADF_HAVEVARTYPE;
+	if (VT_BSTR == vt)
+		psa->fFeatures |= FADF_BSTR;
+	if (VT_VARIANT == vt)
+		psa->fFeatures |= FADF_VARIANT;
+	orglab_data_fake::ole::vartype_of(psa) = vt;
+	return S_OK;
+}
+
+inline HRESULT SafeArrayAllocData(SAFEARRAY* psa) {
+	if (!psa)
+		return E_INVALIDARG;
+	std::size_t sz = orglab_data_fake::ole::element_count(psa) * psa->cbElements;
+	psa->pvData = ::operator new(sz ? sz : 1, std::nothrow);
+	if (!psa->pvData)
+		return E_OUTOFMEMORY;
+	std::memset(psa->pvData, 0, sz);
+	return S_OK;
+}
+
+inline HRESULT VariantClear(VARIANTARG* pvarg);
+
+inline HRESULT SafeArrayDestroyData(SAFEARRAY* psa) {
+	if (!psa)
+		return E_INVALIDARG;
+	if (psa->cLocks > 0)
+		return DISP_E_ARRAYISLOCKED;
+	if (psa->pvData) {
+		std::size_t n = orglab_data_fake::ole::element_count(psa);
+		if (psa->fFeatures & FADF_BSTR) {
+			BSTR* p = static_cast<BSTR*>(psa->pvData);
+			for (std::size_t i = 0; i < n; ++i) {
+				::SysFreeString(p[i]);
+				p[i] = nullptr;
+			}
+		}
+		else if (psa->fFeatures & FADF_VARIANT) {
+			VARIANT* p = static_cast<VARIANT*>(psa->pvData);
+			for (std::size_t i = 0; i < n; ++i)
+				::VariantClear(&p[i]);
+		}
+		if (psa->fFeatures & FADF_STATIC)
+			std::memset(psa->pvData, 0, n * psa->cbElements); // oleaut32 zero-fills static data it does not own.
+		else if (0 == (psa->fFeatures & (FADF_AUTO | FADF_EMBEDDED))) {
+			::operator delete(psa->pvData);
+			psa->pvData = nullptr;
+		}
+	}
+	return S_OK;
+}
+
+inline HRESULT SafeArrayDestroyDescriptor(SAFEARRAY* psa) {
+	if (!psa)
+		return S_OK;
+	if (psa->cLocks > 0)
+		return DISP_E_ARRAYISLOCKED;
+	::operator delete(reinterpret_cast<unsigned char*>(psa) - orglab_data_fake::ole::sa_header);
+	return S_OK;
+}
+
+inline HRESULT SafeArrayDestroy(SAFEARRAY* psa) {
+	if (!psa)
+		return S_OK;
+	HRESULT hr = ::SafeArrayDestroyData(psa);
+	if (FAILED(hr))
+		return hr;
+	return ::SafeArrayDestroyDescriptor(psa);
+}
+
+inline SAFEARRAY* SafeArrayCreate(VARTYPE vt, UINT cDims, SAFEARRAYBOUND* rgsabound) {
+	SAFEARRAY* psa = nullptr;
+	if (!rgsabound || FAILED(::SafeArrayAllocDescriptorEx(vt, cDims, &psa)))
+		return nullptr;
+	for (UINT i = 0; i < cDims; ++i)
+		psa->rgsabound[cDims - 1 - i] = rgsabound[i];
+	if (FAILED(::SafeArrayAllocData(psa))) {
+		::SafeArrayDestroyDescriptor(psa);
+		return nullptr;
+	}
+	return psa;
+}
+
+inline SAFEARRAY* SafeArrayCreateVector(VARTYPE vt, LONG lLbound, ULONG cElements) {
+	SAFEARRAYBOUND bound = { cElements, lLbound };
+	return ::SafeArrayCreate(vt, 1, &bound);
+}
+
+inline UINT SafeArrayGetDim(SAFEARRAY* psa) {
+	return psa ? psa->cDims : 0;
+}
+
+inline UINT SafeArrayGetElemsize(SAFEARRAY* psa) {
+	return psa ? static_cast<UINT>(psa->cbElements) : 0;
+}
+
+inline HRESULT SafeArrayGetVartype(SAFEARRAY* psa, VARTYPE* pvt) {
+	if (!psa || !pvt)
+		return E_INVALIDARG;
+	*pvt = (psa->fFeatures & FADF_HAVEVARTYPE) ? orglab_data_fake::ole::vartype_of(psa) : static_cast<VARTYPE>(VT_EMPTY);
+	return S_OK;
+}
+
+inline HRESULT SafeArrayGetLBound(SAFEARRAY* psa, UINT nDim, LONG* plLbound) {
+	if (!psa || !plLbound)
+		return E_INVALIDARG;
+	if (nDim < 1 || nDim > psa->cDims)
+		return DISP_E_BADINDEX;
+	*plLbound = psa->rgsabound[psa->cDims - nDim].lLbound;
+	return S_OK;
+}
+
+inline HRESULT SafeArrayGetUBound(SAFEARRAY* psa, UINT nDim, LONG* plUbound) {
+	if (!psa || !plUbound)
+		return E_INVALIDARG;
+	if (nDim < 1 || nDim > psa->cDims)
+		return DISP_E_BADINDEX;
+	const SAFEARRAYBOUND& b = psa->rgsabound[psa->cDims - nDim];
+	*plUbound = b.lLbound + static_cast<LONG>(b.cElements) - 1;
+	return S_OK;
+}
+
+inline HRESULT SafeArrayLock(SAFEARRAY* psa) {
+	if (!psa)
+		return E_INVALIDARG;
+	++psa->cLocks;
+	return S_OK;
+}
+
+inline HRESULT SafeArrayUnlock(SAFEARRAY* psa) {
+	if (!psa || 0 == psa->cLocks)
+		return E_UNEXPECTED;
+	--psa->cLocks;
+	return S_OK;
+}
+
+inline HRESULT SafeArrayAccessData(SAFEARRAY* psa, void** ppvData) {
+	if (!psa || !ppvData)
+		return E_INVALIDARG;
+	++psa->cLocks;
+	*ppvData = psa->pvData;
+	return S_OK;
+}
+
+inline HRESULT SafeArrayUnaccessData(SAFEARRAY* psa) {
+	return ::SafeArrayUnlock(psa);
+}
+
+inline HRESULT VariantCopy(VARIANTARG* pvargDest, const VARIANTARG* pvargSrc);
+
+inline HRESULT SafeArrayCopy(SAFEARRAY* psa, SAFEARRAY** ppsaOut) {
+	if (!ppsaOut)
+		return E_INVALIDARG;
+	*ppsaOut = nullptr;
+	if (!psa)
+		return S_OK;
+	SAFEARRAY* out = nullptr;
+	HRESULT hr = ::SafeArrayAllocDescriptor(psa->cDims, &out);
+	if (FAILED(hr))
+		return hr;
+	out->fFeatures = psa->fFeatures & (FADF_HAVEVARTYPE | FADF_BSTR | FADF_VARIANT);
+	out->cbElements = psa->cbElements;
+	orglab_data_fake::ole::vartype_of(out) = orglab_data_fake::ole::vartype_of(psa);
+	for (USHORT i = 0; i < psa->cDims; ++i)
+		out->rgsabound[i] = psa->rgsabound[i];
+	hr = ::SafeArrayAllocData(out);
+	if (FAILED(hr)) {
+		::SafeArrayDestroyDescriptor(out);
+		return hr;
+	}
+	std::size_t n = orglab_data_fake::ole::element_count(psa);
+	if (psa->fFeatures & FADF_BSTR) {
+		BSTR* src = static_cast<BSTR*>(psa->pvData);
+		BSTR* dst = static_cast<BSTR*>(out->pvData);
+		for (std::size_t i = 0; i < n; ++i)
+			dst[i] = src[i] ? ::SysAllocStringLen(src[i], ::SysStringLen(src[i])) : nullptr;
+	}
+	else if (psa->fFeatures & FADF_VARIANT) {
+		VARIANT* src = static_cast<VARIANT*>(psa->pvData);
+		VARIANT* dst = static_cast<VARIANT*>(out->pvData);
+		for (std::size_t i = 0; i < n; ++i)
+			::VariantCopy(&dst[i], &src[i]);
+	}
+	else if (n > 0)
+		std::memcpy(out->pvData, psa->pvData, n * psa->cbElements);
+	*ppsaOut = out;
+	return S_OK;
+}
+
+inline void VariantInit(VARIANTARG* pvarg) {
+	std::memset(pvarg, 0, sizeof(VARIANT));
+}
+
+inline HRESULT VariantClear(VARIANTARG* pvarg) {
+	if (!pvarg)
+		return E_INVALIDARG;
+	if (pvarg->vt & VT_ARRAY)
+		::SafeArrayDestroy(pvarg->parray);
+	else if (VT_BSTR == pvarg->vt)
+		::SysFreeString(pvarg->bstrVal);
+	std::memset(pvarg, 0, sizeof(VARIANT));
+	return S_OK;
+}
+
+inline HRESULT VariantCopy(VARIANTARG* pvargDest, const VARIANTARG* pvargSrc) {
+	if (!pvargDest || !pvargSrc)
+		return E_INVALIDARG;
+	if (pvargDest == pvargSrc)
+		return S_OK;
+	::VariantClear(pvargDest);
+	VARIANT tmp = *pvargSrc;
+	if (tmp.vt & VT_ARRAY) {
+		HRESULT hr = ::SafeArrayCopy(pvargSrc->parray, &tmp.parray);
+		if (FAILED(hr))
+			return hr;
+	}
+	else if (VT_BSTR == tmp.vt && tmp.bstrVal)
+		tmp.bstrVal = ::SysAllocStringLen(tmp.bstrVal, ::SysStringLen(tmp.bstrVal));
+	*pvargDest = tmp;
+	return S_OK;
+}
+
+inline HRESULT CoInitializeEx(void*, DWORD) {
+	return S_OK;
+}
+
+inline void CoUninitialize() {}
+
+// UTF-8 <==> wchar_t (UTF-32 here). Same contract as the Win32 functions for CP_UTF8
+// with no flags: invalid input becomes U+FFFD, a NULL output returns the required size.
+inline int MultiByteToWideChar(UINT, DWORD, const char* src, int src_len, wchar_t* dst, int dst_len) {
+	if (!src)
+		return 0;
+	std::size_t n = src_len < 0 ? std::strlen(src) + 1 : static_cast<std::size_t>(src_len);
+	const unsigned char* s = reinterpret_cast<const unsigned char*>(src);
+	int out = 0;
+	for (std::size_t i = 0; i < n;) {
+		std::uint32_t cp = 0xFFFD;
+		unsigned char c = s[i];
+		std::size_t len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+		if (0 == len || i + len > n)
+			++i;
+		else {
+			cp = 1 == len ? c : 2 == len ? (c & 0x1F) : 3 == len ? (c & 0x0F) : (c & 0x07);
+			bool ok = true;
+			for (std::size_t k = 1; k < len; ++k) {
+				if ((s[i + k] & 0xC0) != 0x80) { ok = false; break; }
+				cp = (cp << 6) | (s[i + k] & 0x3F);
+			}
+			if (!ok || (2 == len && cp < 0x80) || (3 == len && cp < 0x800) || (4 == len && (cp < 0x10000 || cp > 0x10FFFF))
+				|| (cp >= 0xD800 && cp <= 0xDFFF)) {
+				cp = 0xFFFD;
+				++i;
+			}
+			else
+				i += len;
+		}
+		if (dst) {
+			if (out >= dst_len)
+				return 0;
+			dst[out] = static_cast<wchar_t>(cp);
+		}
+		++out;
+	}
+	return out;
+}
+
+inline int WideCharToMultiByte(UINT, DWORD, const wchar_t* src, int src_len, char* dst, int dst_len, const char*, int*) {
+	if (!src)
+		return 0;
+	std::size_t n = src_len < 0 ? std::wcslen(src) + 1 : static_cast<std::size_t>(src_len);
+	int out = 0;
+	for (std::size_t i = 0; i < n; ++i) {
+		std::uint32_t cp = static_cast<std::uint32_t>(src[i]);
+		if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+			cp = 0xFFFD;
+		char buf[4];
+		int len = 0;
+		if (cp < 0x80)
+			buf[len++] = static_cast<char>(cp);
+		else if (cp < 0x800) {
+			buf[len++] = static_cast<char>(0xC0 | (cp >> 6));
+			buf[len++] = static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		else if (cp < 0x10000) {
+			buf[len++] = static_cast<char>(0xE0 | (cp >> 12));
+			buf[len++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+			buf[len++] = static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		else {
+			buf[len++] = static_cast<char>(0xF0 | (cp >> 18));
+			buf[len++] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+			buf[len++] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+			buf[len++] = static_cast<char>(0x80 | (cp & 0x3F));
+		}
+		if (dst) {
+			if (out + len > dst_len)
+				return 0;
+			std::memcpy(dst + out, buf, len);
+		}
+		out += len;
+	}
+	return out;
+}
+
+/* Minimal _variant_t. Owns its contents like the comutil.h class. */
+class _variant_t : public VARIANT {
+public:
+	_variant_t() { ::VariantInit(this); }
+	_variant_t(const VARIANT& src) { ::VariantInit(this); ::VariantCopy(this, &src); }
+	_variant_t(const _variant_t& src) { ::VariantInit(this); ::VariantCopy(this, &src); }
+	_variant_t(_variant_t&& src) noexcept : VARIANT(src) { ::VariantInit(&src); }
+	_variant_t(short v) { ::VariantInit(this); vt = VT_I2; iVal = v; }
+	_variant_t(int v) { ::VariantInit(this); vt = VT_I4; lVal = v; }
+	_variant_t(long v) { ::VariantInit(this); vt = VT_I4; lVal = v; }
+	_variant_t(long long v) { ::VariantInit(this); vt = VT_I8; llVal = v; }
+	_variant_t(float v) { ::VariantInit(this); vt = VT_R4; fltVal = v; }
+	_variant_t(double v) { ::VariantInit(this); vt = VT_R8; dblVal = v; }
+	_variant_t(const wchar_t* v) { ::VariantInit(this); vt = VT_BSTR; bstrVal = ::SysAllocString(v); }
+	~_variant_t() { ::VariantClear(this); }
+	_variant_t& operator=(const _variant_t& src) { ::VariantCopy(this, &src); return *this; }
+	_variant_t& operator=(_variant_t&& src) noexcept {
+		if (this != &src) {
+			::VariantClear(this);
+			*static_cast<VARIANT*>(this) = src;
+			::VariantInit(&src);
+		}
+		return *this;
+	}
+	void Clear() { ::VariantClear(this); }
+	void Attach(VARIANT& src) { ::VariantClear(this); *static_cast<VARIANT*>(this) = src; ::VariantInit(&src); }
+	VARIANT Detach() { VARIANT v = *this; ::VariantInit(this); return v; }
+	operator long() const {
+		switch (vt) {
+		case VT_I1: return cVal;
+		case VT_UI1: return bVal;
+		case VT_I2: return iVal;
+		case VT_UI2: return uiVal;
+		case VT_I4: case VT_INT: return lVal;
+		case VT_UI4: case VT_UINT: return static_cast<long>(ulVal);
+		case VT_I8: case VT_UI8: return static_cast<long>(llVal);
+		case VT_R4: return static_cast<long>(fltVal);
+		case VT_R8: return static_cast<long>(dblVal);
+		case VT_EMPTY: return 0;
+		default: throw std::runtime_error("Type mismatch");
+		}
+	}
+};
+
+/* Minimal _bstr_t. Deep copies instead of reference counting. */
+class _bstr_t {
+	BSTR str_;
+public:
+	_bstr_t() : str_(nullptr) {}
+	_bstr_t(const wchar_t* s) : str_(::SysAllocString(s)) {}
+	_bstr_t(BSTR s, bool copy) : str_(copy ? ::SysAllocStringLen(s, ::SysStringLen(s)) : s) {}
+	_bstr_t(const _bstr_t& other) : str_(other.str_ ? ::SysAllocStringLen(other.str_, ::SysStringLen(other.str_)) : nullptr) {}
+	_bstr_t(_bstr_t&& other) noexcept : str_(other.str_) { other.str_ = nullptr; }
+	~_bstr_t() { ::SysFreeString(str_); }
+	_bstr_t& operator=(_bstr_t other) noexcept { std::swap(str_, other.str_); return *this; }
+	operator const wchar_t* () const { return str_; }
+	operator wchar_t* () const { return str_; }
+	unsigned int length() const { return ::SysStringLen(str_); }
+};
+
+/* Minimal CComBSTR */
+class CComBSTR {
+public:
+	BSTR m_str;
+	CComBSTR() : m_str(nullptr) {}
+	CComBSTR(int nSize, LPCOLESTR sz) : m_str(::SysAllocStringLen(sz, static_cast<UINT>(nSize))) {}
+	CComBSTR(LPCOLESTR sz) : m_str(::SysAllocString(sz)) {}
+	CComBSTR(const CComBSTR& other) : m_str(other.m_str ? ::SysAllocStringLen(other.m_str, ::SysStringLen(other.m_str)) : nullptr) {}
+	CComBSTR(CComBSTR&& other) noexcept : m_str(other.m_str) { other.m_str = nullptr; }
+	~CComBSTR() { ::SysFreeString(m_str); }
+	CComBSTR& operator=(CComBSTR other) noexcept { std::swap(m_str, other.m_str); return *this; }
+	operator BSTR() const { return m_str; }
+	unsigned int Length() const { return ::SysStringLen(m_str); }
+	BSTR Detach() { BSTR s = m_str; m_str = nullptr; return s; }
+	void Attach(BSTR src) { ::SysFreeString(m_str); m_str = src; }
+};
+
+namespace orglab_data_fake {
+	namespace ole {
+		template<class T> struct vartype_of_t;
+		template<> struct vartype_of_t<BSTR> { static constexpr VARTYPE value = VT_BSTR; };
+		template<> struct vartype_of_t<double> { static constexpr VARTYPE value = VT_R8; };
+		template<> struct vartype_of_t<float> { static constexpr VARTYPE value = VT_R4; };
+		template<> struct vartype_of_t<LONG> { static constexpr VARTYPE value = VT_I4; };
+		template<> struct vartype_of_t<ULONG> { static constexpr VARTYPE value = VT_UI4; };
+		template<> struct vartype_of_t<int> { static constexpr VARTYPE value = VT_I4; };
+		template<> struct vartype_of_t<unsigned int> { static constexpr VARTYPE value = VT_UI4; };
+		template<> struct vartype_of_t<SHORT> { static constexpr VARTYPE value = VT_I2; };
+		template<> struct vartype_of_t<USHORT> { static constexpr VARTYPE value = VT_UI2; };
+		template<> struct vartype_of_t<char> { static constexpr VARTYPE value = VT_I1; };
+		template<> struct vartype_of_t<BYTE> { static constexpr VARTYPE value = VT_UI1; };
+		template<> struct vartype_of_t<VARIANT> { static constexpr VARTYPE value = VT_VARIANT; };
+	}
+}
+
+/* Minimal CComSafeArray */
+template<class T>
+class CComSafeArray {
+public:
+	SAFEARRAY* m_psa;
+	CComSafeArray() : m_psa(nullptr) {}
+	explicit CComSafeArray(ULONG ulCount, LONG lLBound = 0) : m_psa(nullptr) { Create(ulCount, lLBound); }
+	CComSafeArray(const CComSafeArray&) = delete;
+	CComSafeArray& operator=(const CComSafeArray&) = delete;
+	~CComSafeArray() { Destroy(); }
+	HRESULT Create(ULONG ulCount = 0, LONG lLBound = 0) {
+		Destroy();
+		m_psa = ::SafeArrayCreateVector(orglab_data_fake::ole::vartype_of_t<T>::value, lLBound, ulCount);
+		return m_psa ? S_OK : E_OUTOFMEMORY;
+	}
+	HRESULT Destroy() {
+		HRESULT hr = S_OK;
+		if (m_psa) {
+			hr = ::SafeArrayDestroy(m_psa);
+			m_psa = nullptr;
+		}
+		return hr;
+	}
+	HRESULT Attach(const SAFEARRAY* psaSrc) {
+		Destroy();
+		m_psa = const_cast<SAFEARRAY*>(psaSrc);
+		return S_OK;
+	}
+	SAFEARRAY* Detach() { SAFEARRAY* psa = m_psa; m_psa = nullptr; return psa; }
+	UINT GetDimensions() const { return m_psa ? m_psa->cDims : 0; }
+	LONG GetLowerBound(UINT uDim = 0) const { LONG l = 0; ::SafeArrayGetLBound(m_psa, uDim + 1, &l); return l; }
+	LONG GetUpperBound(UINT uDim = 0) const { LONG u = -1; ::SafeArrayGetUBound(m_psa, uDim + 1, &u); return u; }
+	ULONG GetCount(UINT uDim = 0) const {
+		if (!m_psa)
+			return 0;
+		return static_cast<ULONG>(GetUpperBound(uDim) - GetLowerBound(uDim) + 1);
+	}
+	T& GetAt(LONG lIndex) const { return static_cast<T*>(m_psa->pvData)[lIndex - GetLowerBound()]; }
+	HRESULT SetAt(LONG lIndex, const T& t, bool bCopy = true) {
+		T& dst = static_cast<T*>(m_psa->pvData)[lIndex - GetLowerBound()];
+		if constexpr (std::is_same<T, BSTR>::value) {
+			::SysFreeString(dst);
+			dst = bCopy && t ? ::SysAllocStringLen(t, ::SysStringLen(t)) : t;
+		}
+		else
+			dst = t;
+		return S_OK;
+	}
+	T& operator[](LONG lIndex) const { return GetAt(lIndex); }
+};
+
+#endif // !_WIN32
+
+//// FAKE ORIGIN OBJECTS ////
+
+#ifndef ORGLAB_DATA_ORGLAB_NS
+#define ORGLAB_DATA_ORGLAB_NS orglab_data_fake
+#endif
+
+namespace orglab_data_fake {
+
+	/* Same names and values as in Origin8.tlb and orglab.tlb */
+	enum COLDATAFORMAT {
+		DF_NO_CHANGE = -1, DF_DOUBLE = 0, DF_TEXT = 1, DF_TIME = 2, DF_DATE = 3, DF_MONTH = 4,
+		DF_WEEKDAY = 5, DF_TEXT_NUMERIC = 9, DF_FLOAT = 32, DF_SHORT = 33, DF_LONG = 34,
+		DF_CHAR = 35, DF_BYTE = 38, DF_USHORT = 39, DF_ULONG = 40, DF_COMPLEX = 41
+	};
+
+	/* Same names and values as in Origin8.tlb and orglab.tlb */
+	enum ARRAYDATAFORMAT {
+		ARRAY2D_VARIANT = 0, ARRAY1D_NUMERIC = 1, ARRAY2D_NUMERIC = 2, ARRAY2D_TEXT = 3,
+		ARRAY2D_TEXT_FULL_PRECISION = 4, ARRAY1D_VARIANT = 5, ARRAY1D_TEXT = 6,
+		ARRAY1D_TEXT_FULL_PRECISION = 7, ARRAY1D_STR = 8, ARRAY2D_STR = 9,
+		ARRAY1D_STR_FULL_PRECISION = 10, ARRAY2D_STR_FULL_PRECISION = 11
+	};
+
+	/* Round-trip counters. One call to a COM-shaped method is one round-trip. */
+	struct server_stats {
+		std::uint64_t calls = 0;
+		std::uint64_t get_format = 0;
+		std::uint64_t put_format = 0;
+		std::uint64_t set_data = 0;
+		std::uint64_t get_data = 0;
+		std::uint64_t other = 0; // Property access and collection lookups.
+		std::uint64_t bytes_in = 0; // Payload bytes received by SetData.
+		std::uint64_t bytes_out = 0; // Payload bytes returned by GetData.
+	};
+
+	namespace detail {
+
+		struct server_state {
+			std::mutex mtx; // The server handles one call at a time, like Origin.
+			std::atomic<std::int64_t> latency_ns{ 0 };
+			std::atomic<bool> refuse_static{ false };
+			std::atomic<HRESULT> fail_set_data{ S_OK }; // Fails the next SetData once.
+			std::atomic<std::size_t> max_array_bytes{ 0 }; // Zero is no limit.
+			server_stats stats;
+		};
+
+		inline server_state& server() {
+			static server_state s;
+			return s;
+		}
+
+		/* Throws what the server gives for a SetData it will not take */
+		inline void check_set_data(const _variant_t& data) {
+			HRESULT hr = server().fail_set_data.exchange(S_OK, std::memory_order_relaxed);
+			if (FAILED(hr))
+				throw _com_error(hr);
+			if ((data.parray->fFeatures & FADF_STATIC) && server().refuse_static.load(std::memory_order_relaxed))
+				throw _com_error(DISP_E_ARRAYISLOCKED); // The array must be owned by the server.
+		}
+
+		/* Throws if a matrix payload is over set_max_array_bytes */
+		inline void check_array_bytes(std::size_t bytes) {
+			std::size_t limit = server().max_array_bytes.load(std::memory_order_relaxed);
+			if (limit && bytes > limit)
+				throw std::runtime_error("Array too large");
+		}
+
+		enum class call_kind { get_format, put_format, set_data, get_data, other };
+
+		/* Held for the duration of one fake round-trip */
+		class round_trip {
+			std::unique_lock<std::mutex> lock_;
+		public:
+			explicit round_trip(call_kind kind) : lock_(server().mtx) {
+				server_stats& st = server().stats;
+				++st.calls;
+				switch (kind) {
+				case call_kind::get_format: ++st.get_format; break;
+				case call_kind::put_format: ++st.put_format; break;
+				case call_kind::set_data: ++st.set_data; break;
+				case call_kind::get_data: ++st.get_data; break;
+				case call_kind::other: ++st.other; break;
+				}
+				std::chrono::nanoseconds latency(server().latency_ns.load(std::memory_order_relaxed));
+				if (latency.count() <= 0)
+					return;
+				auto until = std::chrono::steady_clock::now() + latency;
+				if (latency >= std::chrono::milliseconds(1))
+					std::this_thread::sleep_until(until);
+				else
+					while (std::chrono::steady_clock::now() < until) {} // Sleep granularity is too coarse below 1 ms.
+			}
+		};
+
+		/* Storage type of each COLDATAFORMAT */
+		enum class storage { real, single, int32, uint32, int16, uint16, int8, uint8, complex, text };
+
+		inline storage storage_of(COLDATAFORMAT fmt) {
+			switch (fmt) {
+			case DF_FLOAT: return storage::single;
+			case DF_LONG: return storage::int32;
+			case DF_ULONG: return storage::uint32;
+			case DF_SHORT: return storage::int16;
+			case DF_USHORT: return storage::uint16;
+			case DF_CHAR: return storage::int8;
+			case DF_BYTE: return storage::uint8;
+			case DF_COMPLEX: return storage::complex;
+			case DF_TEXT: return storage::text;
+			default: return storage::real; // Double, text & numeric, date, time, month, weekday.
+			}
+		}
+
+		inline std::size_t storage_size(storage s) {
+			switch (s) {
+			case storage::real: return 8;
+			case storage::single: case storage::int32: case storage::uint32: return 4;
+			case storage::int16: case storage::uint16: return 2;
+			case storage::int8: case storage::uint8: return 1;
+			case storage::complex: return 16;
+			default: return 0;
+			}
+		}
+
+		inline VARTYPE storage_vt(storage s) {
+			switch (s) {
+			case storage::single: return VT_R4;
+			case storage::int32: return VT_I4;
+			case storage::uint32: return VT_UI4;
+			case storage::int16: return VT_I2;
+			case storage::uint16: return VT_UI2;
+			case storage::int8: return VT_I1;
+			case storage::uint8: return VT_UI1;
+			default: return VT_R8;
+			}
+		}
+
+		inline bool is_integer(storage s) {
+			return s != storage::real && s != storage::single && s != storage::complex && s != storage::text;
+		}
+
+		inline storage storage_of_vt(VARTYPE vt) {
+			switch (vt) {
+			case VT_R4: return storage::single;
+			case VT_I4: case VT_INT: return storage::int32;
+			case VT_UI4: case VT_UINT: return storage::uint32;
+			case VT_I2: return storage::int16;
+			case VT_UI2: return storage::uint16;
+			case VT_I1: return storage::int8;
+			case VT_UI1: return storage::uint8;
+			case VT_R8: return storage::real;
+			case VT_BSTR: return storage::text;
+			default: throw std::runtime_error("Unsupported array type");
+			}
+		}
+
+		inline double load(storage s, const unsigned char* p) {
+			switch (s) {
+			case storage::real: { double v; std::memcpy(&v, p, 8); return v; }
+			case storage::single: { float v; std::memcpy(&v, p, 4); return v; }
+			case storage::int32: { std::int32_t v; std::memcpy(&v, p, 4); return v; }
+			case storage::uint32: { std::uint32_t v; std::memcpy(&v, p, 4); return v; }
+			case storage::int16: { std::int16_t v; std::memcpy(&v, p, 2); return v; }
+			case storage::uint16: { std::uint16_t v; std::memcpy(&v, p, 2); return v; }
+			case storage::int8: return static_cast<std::int8_t>(*p);
+			case storage::uint8: return *p;
+			case storage::complex: { double v; std::memcpy(&v, p, 8); return v; }
+			default: return std::numeric_limits<double>::quiet_NaN();
+			}
+		}
+
+		template<class I>
+		inline I saturate(double v) {
+			if (std::isnan(v))
+				return 0;
+			if (v <= static_cast<double>((std::numeric_limits<I>::min)()))
+				return (std::numeric_limits<I>::min)();
+			if (v >= static_cast<double>((std::numeric_limits<I>::max)()))
+				return (std::numeric_limits<I>::max)();
+			return static_cast<I>(std::nearbyint(v));
+		}
+
+		inline void store(storage s, unsigned char* p, double v) {
+			switch (s) {
+			case storage::real: std::memcpy(p, &v, 8); break;
+			case storage::single: { float f = static_cast<float>(v); std::memcpy(p, &f, 4); break; }
+			case storage::int32: { std::int32_t i = saturate<std::int32_t>(v); std::memcpy(p, &i, 4); break; }
+			case storage::uint32: { std::uint32_t i = saturate<std::uint32_t>(v); std::memcpy(p, &i, 4); break; }
+			case storage::int16: { std::int16_t i = saturate<std::int16_t>(v); std::memcpy(p, &i, 2); break; }
+			case storage::uint16: { std::uint16_t i = saturate<std::uint16_t>(v); std::memcpy(p, &i, 2); break; }
+			case storage::int8: { std::int8_t i = saturate<std::int8_t>(v); std::memcpy(p, &i, 1); break; }
+			case storage::uint8: *p = saturate<std::uint8_t>(v); break;
+			case storage::complex: { double c[2] = { v, 0.0 }; std::memcpy(p, c, 16); break; }
+			default: break;
+			}
+		}
+
+		/* Missing value Origin shows for rows never written */
+		inline void store_missing(storage s, unsigned char* p) {
+			if (storage::real == s || storage::single == s || storage::complex == s)
+				store(s, p, std::numeric_limits<double>::quiet_NaN());
+			else
+				std::memset(p, 0, storage_size(s));
+		}
+
+		/* Copies n wire values into typed storage. Same-sized integers keep their bits */
+		/* so unsigned data sent as VT_I2/VT_I4 round-trips unchanged. */
+		inline void convert(storage dst_s, unsigned char* dst, storage src_s, const unsigned char* src, std::size_t n) {
+			std::size_t dsz = storage_size(dst_s), ssz = storage_size(src_s);
+			if (dst_s == src_s || (dsz == ssz && is_integer(dst_s) && is_integer(src_s))) {
+				std::memcpy(dst, src, n * dsz);
+				return;
+			}
+			for (std::size_t i = 0; i < n; ++i, dst += dsz, src += ssz)
+				store(dst_s, dst, load(src_s, src));
+		}
+
+		inline std::wstring format_number(double v, bool full_precision) {
+			if (std::isnan(v))
+				return std::wstring(); // Missing value.
+			wchar_t buf[64];
+			std::swprintf(buf, 64, full_precision ? L"%.17g" : L"%.15g", v);
+			return std::wstring(buf);
+		}
+
+		inline double parse_number(const std::wstring& s) {
+			if (s.empty())
+				return std::numeric_limits<double>::quiet_NaN();
+			wchar_t* end = nullptr;
+			double v = std::wcstod(s.c_str(), &end);
+			if (end == s.c_str() || *end != L'\0')
+				return std::numeric_limits<double>::quiet_NaN();
+			return v;
+		}
+
+		inline long to_long(const _variant_t& v, long def) {
+			if (VT_EMPTY == v.vt)
+				return def;
+			return static_cast<long>(v);
+		}
+
+		/* Fetches 1D array geometry. Throws if vt_array is not an array. */
+		inline std::size_t array_count(const VARIANT& v, UINT dim = 1) {
+			if (!(v.vt & VT_ARRAY) || !v.parray || ::SafeArrayGetDim(v.parray) < dim)
+				throw std::runtime_error("Type mismatch");
+			LONG lb = 0, ub = -1;
+			::SafeArrayGetLBound(v.parray, dim, &lb);
+			::SafeArrayGetUBound(v.parray, dim, &ub);
+			return ub >= lb ? static_cast<std::size_t>(ub - lb + 1) : 0;
+		}
+
+		inline _variant_t make_array(VARTYPE vt, UINT dims, SAFEARRAYBOUND* bounds, void** data) {
+			SAFEARRAY* psa = ::SafeArrayCreate(vt, dims, bounds);
+			if (!psa)
+				throw std::bad_alloc();
+			_variant_t v;
+			v.vt = static_cast<VARTYPE>(vt | VT_ARRAY);
+			v.parray = psa;
+			::SafeArrayAccessData(psa, data);
+			::SafeArrayUnaccessData(psa); // Data pointer stays valid while v owns the array.
+			return v;
+		}
+
+	}
+
+	/* Sets artificial latency added to every round-trip */
+	inline void set_latency(std::chrono::nanoseconds latency) {
+		detail::server().latency_ns.store(latency.count(), std::memory_order_relaxed);
+	}
+
+	/* Returns artificial latency added to every round-trip */
+	inline std::chrono::nanoseconds get_latency() {
+		return std::chrono::nanoseconds(detail::server().latency_ns.load(std::memory_order_relaxed));
+	}
+
+	/* Makes SetData fail for arrays the caller owns (FADF_STATIC), like a server that keeps the array */
+	inline void set_refuse_static_arrays(bool refuse) {
+		detail::server().refuse_static.store(refuse, std::memory_order_relaxed);
+	}
+
+	/* Makes the next column or matrix SetData throw _com_error(hr), like a server that */
+	/* fails one call */
+	inline void set_fail_next_set_data(HRESULT hr) {
+		detail::server().fail_set_data.store(hr, std::memory_order_relaxed);
+	}
+
+	/* Makes matrix SetData and GetData fail for payloads over bytes, like a server that */
+	/* cannot marshal an array that big. Zero, the default, removes the limit. */
+	inline void set_max_array_bytes(std::size_t bytes) {
+		detail::server().max_array_bytes.store(bytes, std::memory_order_relaxed);
+	}
+
+	/* Returns a snapshot of the round-trip counters */
+	inline server_stats get_stats() {
+		std::lock_guard<std::mutex> lock(detail::server().mtx);
+		return detail::server().stats;
+	}
+
+	/* Resets the round-trip counters */
+	inline void reset_stats() {
+		std::lock_guard<std::mutex> lock(detail::server().mtx);
+		detail::server().stats = server_stats();
+	}
+
+	/* Fake worksheet column. Mirrors the Column interface of the type library. */
+	class Column {
+	protected:
+		COLDATAFORMAT fmt_;
+		std::size_t rows_;
+		std::vector<unsigned char> num_; // Numeric cells, typed per fmt_.
+		std::vector<std::wstring> text_; // Text cells. Empty unless fmt_ holds text.
+
+		detail::storage kind() const { return detail::storage_of(fmt_); }
+
+		double number_at(std::size_t i) const {
+			detail::storage s = kind();
+			if (detail::storage::text == s)
+				return detail::parse_number(text_[i]);
+			if (!text_.empty() && !text_[i].empty())
+				return detail::parse_number(text_[i]);
+			return detail::load(s, num_.data() + i * detail::storage_size(s));
+		}
+
+		std::wstring text_at(std::size_t i, bool full_precision) const {
+			detail::storage s = kind();
+			if (!text_.empty() && (detail::storage::text == s || !text_[i].empty()))
+				return text_[i];
+			if (detail::storage::complex == s) {
+				const double* c = reinterpret_cast<const double*>(num_.data()) + 2 * i;
+				return detail::format_number(c[0], full_precision) + (c[1] < 0 ? L"-" : L"+")
+					+ detail::format_number(std::fabs(c[1]), full_precision) + L"i";
+			}
+			if (detail::storage::text == s)
+				return std::wstring();
+			return detail::format_number(number_at(i), full_precision);
+		}
+
+		void grow(std::size_t rows) {
+			if (rows <= rows_)
+				return;
+			detail::storage s = kind();
+			if (detail::storage::text != s) {
+				std::size_t sz = detail::storage_size(s);
+				num_.resize(rows * sz);
+				for (std::size_t i = rows_; i < rows; ++i)
+					detail::store_missing(s, num_.data() + i * sz);
+			}
+			if (!text_.empty() || detail::storage::text == s)
+				text_.resize(rows);
+			rows_ = rows;
+		}
+
+		/* Stores n wire values of type src at row start. Caller holds the round-trip. */
+		void put_cells(detail::storage src, const void* p, std::size_t n, std::size_t start) {
+			detail::storage dst = kind();
+			if (detail::storage::text == src) {
+				const BSTR* cells = static_cast<const BSTR*>(p);
+				grow(start + n);
+				if (detail::storage::text == dst || DF_TEXT_NUMERIC == fmt_) {
+					text_.resize(rows_);
+					for (std::size_t i = 0; i < n; ++i)
+						text_[start + i].assign(cells[i] ? cells[i] : L"", ::SysStringLen(cells[i]));
+				}
+				else {
+					std::size_t sz = detail::storage_size(dst);
+					for (std::size_t i = 0; i < n; ++i)
+						detail::store(dst, num_.data() + (start + i) * sz, detail::parse_number(std::wstring(cells[i] ? cells[i] : L"", ::SysStringLen(cells[i]))));
+				}
+				detail::server().stats.bytes_in += n * sizeof(BSTR);
+			}
+			else if (detail::storage::complex == dst) {
+				// Complex columns take interleaved re,im pairs.
+				std::size_t rows = n / 2;
+				grow(start + rows);
+				double* out = reinterpret_cast<double*>(num_.data()) + 2 * start;
+				detail::convert(detail::storage::real, reinterpret_cast<unsigned char*>(out), src, static_cast<const unsigned char*>(p), 2 * rows);
+				detail::server().stats.bytes_in += n * detail::storage_size(src);
+			}
+			else if (detail::storage::text == dst) {
+				grow(start + n);
+				std::size_t ssz = detail::storage_size(src);
+				for (std::size_t i = 0; i < n; ++i)
+					text_[start + i] = detail::format_number(detail::load(src, static_cast<const unsigned char*>(p) + i * ssz), false);
+				detail::server().stats.bytes_in += n * ssz;
+			}
+			else {
+				grow(start + n);
+				std::size_t sz = detail::storage_size(dst);
+				detail::convert(dst, num_.data() + start * sz, src, static_cast<const unsigned char*>(p), n);
+				if (!text_.empty())
+					for (std::size_t i = 0; i < n; ++i)
+						text_[start + i].clear();
+				detail::server().stats.bytes_in += n * detail::storage_size(src);
+			}
+		}
+
+		friend class Worksheet;
+
+	public:
+		explicit Column(COLDATAFORMAT fmt = DF_TEXT_NUMERIC) : fmt_(fmt), rows_(0) {}
+
+		COLDATAFORMAT GetDataFormat() {
+			detail::round_trip rt(detail::call_kind::get_format);
+			return fmt_;
+		}
+
+		/* Changes column type converting existing cells, as Origin does */
+		void PutDataFormat(COLDATAFORMAT fmt) {
+			detail::round_trip rt(detail::call_kind::put_format);
+			if (fmt == fmt_ || DF_NO_CHANGE == fmt)
+				return;
+			detail::storage from = kind(), to = detail::storage_of(fmt);
+			if (from == to) {
+				fmt_ = fmt;
+				return;
+			}
+			std::vector<unsigned char> num;
+			std::vector<std::wstring> text;
+			if (detail::storage::text == to) {
+				text.resize(rows_);
+				for (std::size_t i = 0; i < rows_; ++i)
+					text[i] = text_at(i, true);
+			}
+			else {
+				std::size_t sz = detail::storage_size(to);
+				num.resize(rows_ * sz);
+				for (std::size_t i = 0; i < rows_; ++i)
+					detail::store(to, num.data() + i * sz, number_at(i));
+				if (DF_TEXT_NUMERIC == fmt && detail::storage::text == from)
+					text = text_; // Text & numeric keeps the text cells.
+			}
+			fmt_ = fmt;
+			num_.swap(num);
+			text_.swap(text);
+		}
+
+		VARIANT_BOOL SetData(const _variant_t& data, const _variant_t& offset) {
+			detail::round_trip rt(detail::call_kind::set_data);
+			std::size_t n = detail::array_count(data);
+			long off = detail::to_long(offset, 0);
+			if (off < 0)
+				throw std::runtime_error("Invalid offset");
+			detail::check_set_data(data);
+			void* p = nullptr;
+			::SafeArrayAccessData(data.parray, &p);
+			put_cells(detail::storage_of_vt(static_cast<VARTYPE>(data.vt & VT_TYPEMASK)), p, n, static_cast<std::size_t>(off));
+			::SafeArrayUnaccessData(data.parray);
+			return VARIANT_TRUE;
+		}
+
+		_variant_t GetData(ARRAYDATAFORMAT format, const _variant_t& r1, const _variant_t& r2, const _variant_t& lowbound) {
+			detail::round_trip rt(detail::call_kind::get_data);
+			long first = detail::to_long(r1, 0);
+			long last = detail::to_long(r2, -1);
+			if (first < 0)
+				first = 0;
+			if (last < 0 || static_cast<std::size_t>(last) >= rows_)
+				last = static_cast<long>(rows_) - 1;
+			if (static_cast<std::size_t>(first) >= rows_ || last < first)
+				return _variant_t();
+			std::size_t start = static_cast<std::size_t>(first);
+			std::size_t n = static_cast<std::size_t>(last - first + 1);
+			SAFEARRAYBOUND bound = { 0, detail::to_long(lowbound, 0) };
+			detail::storage s = kind();
+			void* p = nullptr;
+			if (ARRAY1D_NUMERIC == format) {
+				if (detail::storage::complex == s) {
+					bound.cElements = static_cast<ULONG>(2 * n);
+					_variant_t v = detail::make_array(VT_R8, 1, &bound, &p);
+					std::memcpy(p, num_.data() + start * 16, n * 16);
+					detail::server().stats.bytes_out += n * 16;
+					return v;
+				}
+				bound.cElements = static_cast<ULONG>(n);
+				_variant_t v = detail::make_array(detail::storage_vt(s), 1, &bound, &p);
+				if (detail::storage::text == s || !text_.empty()) {
+					std::size_t sz = detail::storage_size(detail::storage_of_vt(detail::storage_vt(s)));
+					for (std::size_t i = 0; i < n; ++i)
+						detail::store(detail::storage_of_vt(detail::storage_vt(s)), static_cast<unsigned char*>(p) + i * sz, number_at(start + i));
+				}
+				else
+					std::memcpy(p, num_.data() + start * detail::storage_size(s), n * detail::storage_size(s));
+				detail::server().stats.bytes_out += n * ::SafeArrayGetElemsize(v.parray);
+				return v;
+			}
+			if (ARRAY1D_STR == format || ARRAY1D_TEXT == format || ARRAY1D_STR_FULL_PRECISION == format || ARRAY1D_TEXT_FULL_PRECISION == format) {
+				bool full = ARRAY1D_STR_FULL_PRECISION == format || ARRAY1D_TEXT_FULL_PRECISION == format;
+				bound.cElements = static_cast<ULONG>(n);
+				_variant_t v = detail::make_array(VT_BSTR, 1, &bound, &p);
+				BSTR* cells = static_cast<BSTR*>(p);
+				for (std::size_t i = 0; i < n; ++i) {
+					std::wstring str = text_at(start + i, full);
+					cells[i] = ::SysAllocStringLen(str.data(), static_cast<UINT>(str.size()));
+				}
+				detail::server().stats.bytes_out += n * sizeof(BSTR);
+				return v;
+			}
+			if (ARRAY1D_VARIANT == format) {
+				bound.cElements = static_cast<ULONG>(n);
+				_variant_t v = detail::make_array(VT_VARIANT, 1, &bound, &p);
+				VARIANT* cells = static_cast<VARIANT*>(p);
+				for (std::size_t i = 0; i < n; ++i) {
+					if (detail::storage::text == s || (!text_.empty() && !text_[start + i].empty())) {
+						cells[i].vt = VT_BSTR;
+						cells[i].bstrVal = ::SysAllocStringLen(text_[start + i].data(), static_cast<UINT>(text_[start + i].size()));
+					}
+					else {
+						cells[i].vt = VT_R8;
+						cells[i].dblVal = number_at(start + i);
+					}
+				}
+				detail::server().stats.bytes_out += n * sizeof(VARIANT);
+				return v;
+			}
+			throw std::runtime_error("Unsupported data format");
+		}
+
+		/* Fake-only helper. Number of rows currently held by the column. */
+		std::size_t rows() const { return rows_; }
+	};
+
+	/* Fake matrix object. Mirrors the MatrixObject interface of the type library. */
+	/* Like in Origin, its dimensions come from the owning sheet and SetData must fit. */
+	class MatrixObject {
+	protected:
+		COLDATAFORMAT fmt_;
+		std::size_t rows_, cols_;
+		std::vector<unsigned char> num_; // Column major, typed per fmt_. Complex interleaved.
+
+		detail::storage kind() const {
+			detail::storage s = detail::storage_of(fmt_);
+			return detail::storage::text == s ? detail::storage::real : s;
+		}
+
+	public:
+		MatrixObject(std::size_t rows = 32, std::size_t cols = 32, COLDATAFORMAT fmt = DF_DOUBLE) : fmt_(fmt), rows_(0), cols_(0) {
+			resize(rows, cols);
+		}
+
+		COLDATAFORMAT GetDataFormat() {
+			detail::round_trip rt(detail::call_kind::get_format);
+			return fmt_;
+		}
+
+		void PutDataFormat(COLDATAFORMAT fmt) {
+			detail::round_trip rt(detail::call_kind::put_format);
+			if (fmt == fmt_ || DF_NO_CHANGE == fmt)
+				return;
+			detail::storage from = kind(), to = detail::storage_of(fmt);
+			if (detail::storage::text == to)
+				to = detail::storage::real;
+			std::size_t n = rows_ * cols_, fsz = detail::storage_size(from), tsz = detail::storage_size(to);
+			std::vector<unsigned char> num(n * tsz);
+			for (std::size_t i = 0; i < n; ++i)
+				detail::store(to, num.data() + i * tsz, detail::load(from, num_.data() + i * fsz));
+			fmt_ = fmt;
+			num_.swap(num);
+		}
+
+		/* Expects data as orglab_data sends it: dimension 1 is columns, dimension 2 is */
+		/* rows (row major memory) and, for complex, dimension 3 selects real/imaginary plane. */
+		VARIANT_BOOL SetData(const _variant_t& data, const _variant_t& r1, const _variant_t& c1) {
+			detail::round_trip rt(detail::call_kind::set_data);
+			std::size_t ncols = detail::array_count(data, 1);
+			std::size_t nrows = detail::array_count(data, 2);
+			long row0 = detail::to_long(r1, 0), col0 = detail::to_long(c1, 0);
+			if (row0 < 0 || col0 < 0 || static_cast<std::size_t>(row0) + nrows > rows_ || static_cast<std::size_t>(col0) + ncols > cols_)
+				throw std::runtime_error("Matrix dimensions mismatch");
+			detail::storage src = detail::storage_of_vt(static_cast<VARTYPE>(data.vt & VT_TYPEMASK));
+			detail::storage dst = kind();
+			std::size_t ssz = detail::storage_size(src), dsz = detail::storage_size(dst);
+			detail::check_array_bytes(ssz * nrows * ncols * (detail::storage::complex == dst ? 2 : 1));
+			detail::check_set_data(data);
+			void* p = nullptr;
+			::SafeArrayAccessData(data.parray, &p);
+			const unsigned char* in = static_cast<const unsigned char*>(p);
+			if (detail::storage::complex == dst) {
+				if (::SafeArrayGetDim(data.parray) < 3 || detail::array_count(data, 3) < 2)
+					throw std::runtime_error("Type mismatch");
+				std::size_t plane = nrows * ncols * ssz;
+				for (std::size_t j = 0; j < nrows; ++j) {
+					for (std::size_t k = 0; k < ncols; ++k) {
+						double* out = reinterpret_cast<double*>(num_.data() + ((col0 + k) * rows_ + row0 + j) * dsz);
+						out[0] = detail::load(src, in + (ncols * j + k) * ssz);
+						out[1] = detail::load(src, in + plane + (ncols * j + k) * ssz);
+					}
+				}
+			}
+			else {
+				for (std::size_t j = 0; j < nrows; ++j)
+					for (std::size_t k = 0; k < ncols; ++k)
+						detail::convert(dst, num_.data() + ((col0 + k) * rows_ + row0 + j) * dsz, src, in + (ncols * j + k) * ssz, 1);
+			}
+			detail::server().stats.bytes_in += ssz * nrows * ncols * (detail::storage::complex == dst ? 2 : 1);
+			::SafeArrayUnaccessData(data.parray);
+			return VARIANT_TRUE;
+		}
+
+		/* Returns data as orglab_data expects it: dimension 1 is rows, dimension 2 is */
+		/* columns (column major memory) and, for complex, dimension 3 selects the plane. */
+		_variant_t GetData(const _variant_t& r1, const _variant_t& c1, const _variant_t& r2, const _variant_t& c2, ARRAYDATAFORMAT format, const _variant_t& lowbound) {
+			detail::round_trip rt(detail::call_kind::get_data);
+			if (ARRAY2D_NUMERIC != format)
+				throw std::runtime_error("Unsupported data format");
+			long row0 = detail::to_long(r1, 0), col0 = detail::to_long(c1, 0);
+			long row1 = detail::to_long(r2, -1), col1 = detail::to_long(c2, -1);
+			if (row1 < 0 || static_cast<std::size_t>(row1) >= rows_)
+				row1 = static_cast<long>(rows_) - 1;
+			if (col1 < 0 || static_cast<std::size_t>(col1) >= cols_)
+				col1 = static_cast<long>(cols_) - 1;
+			if (row0 < 0 || col0 < 0 || row1 < row0 || col1 < col0)
+				return _variant_t();
+			std::size_t nrows = static_cast<std::size_t>(row1 - row0 + 1), ncols = static_cast<std::size_t>(col1 - col0 + 1);
+			long lb = detail::to_long(lowbound, 0);
+			detail::storage s = kind();
+			detail::check_array_bytes(nrows * ncols * detail::storage_size(s));
+			void* p = nullptr;
+			if (detail::storage::complex == s) {
+				SAFEARRAYBOUND bounds[3] = { { static_cast<ULONG>(nrows), lb }, { static_cast<ULONG>(ncols), lb }, { 2, lb } };
+				_variant_t v = detail::make_array(VT_R8, 3, bounds, &p);
+				double* re = static_cast<double*>(p);
+				double* im = re + nrows * ncols;
+				for (std::size_t k = 0; k < ncols; ++k) {
+					const double* src = reinterpret_cast<const double*>(num_.data()) + 2 * ((col0 + k) * rows_ + row0);
+					for (std::size_t j = 0; j < nrows; ++j, src += 2) {
+						*re++ = src[0];
+						*im++ = src[1];
+					}
+				}
+				detail::server().stats.bytes_out += nrows * ncols * 16;
+				return v;
+			}
+			SAFEARRAYBOUND bounds[2] = { { static_cast<ULONG>(nrows), lb }, { static_cast<ULONG>(ncols), lb } };
+			_variant_t v = detail::make_array(detail::storage_vt(s), 2, bounds, &p);
+			std::size_t sz = detail::storage_size(s);
+			for (std::size_t k = 0; k < ncols; ++k)
+				std::memcpy(static_cast<unsigned char*>(p) + k * nrows * sz, num_.data() + ((col0 + k) * rows_ + row0) * sz, nrows * sz);
+			detail::server().stats.bytes_out += nrows * ncols * sz;
+			return v;
+		}
+
+		/* Fake-only helper. Same as setting Rows and Cols on the owning matrix sheet. */
+		void resize(std::size_t rows, std::size_t cols) {
+			std::lock_guard<std::mutex> lock(detail::server().mtx);
+			detail::storage s = kind();
+			std::size_t sz = detail::storage_size(s);
+			std::vector<unsigned char> num(rows * cols * sz);
+			for (std::size_t i = 0; i < rows * cols; ++i)
+				detail::store_missing(s, num.data() + i * sz);
+			for (std::size_t k = 0; k < (std::min)(cols, cols_); ++k)
+				std::memcpy(num.data() + k * rows * sz, num_.data() + k * rows_ * sz, (std::min)(rows, rows_) * sz);
+			rows_ = rows;
+			cols_ = cols;
+			num_.swap(num);
+		}
+
+		/* Fake-only helper. Number of rows. */
+		std::size_t rows() const { return rows_; }
+
+		/* Fake-only helper. Number of columns. */
+		std::size_t cols() const { return cols_; }
+	};
+
+	using ColumnPtr = std::shared_ptr<Column>;
+	using MatrixObjectPtr = std::shared_ptr<MatrixObject>;
+
+	/* Fake column collection of a worksheet. Mirrors the Columns interface of the type library. */
+	class Columns {
+		std::shared_ptr<std::vector<ColumnPtr>> cols_;
+	public:
+		explicit Columns(std::shared_ptr<std::vector<ColumnPtr>> cols) : cols_(std::move(cols)) {}
+
+		long GetCount() {
+			detail::round_trip rt(detail::call_kind::other);
+			return static_cast<long>(cols_->size());
+		}
+
+		/* Zero-based index, or a column name ("A", "B"...) */
+		ColumnPtr GetItem(const _variant_t& index) {
+			detail::round_trip rt(detail::call_kind::other);
+			std::size_t i = 0;
+			if (VT_BSTR == index.vt) {
+				std::wstring name(index.bstrVal, ::SysStringLen(index.bstrVal));
+				for (wchar_t ch : name)
+					i = i * 26 + static_cast<std::size_t>(ch - L'A' + 1);
+				--i;
+			}
+			else if (detail::to_long(index, -1) >= 0)
+				i = static_cast<std::size_t>(detail::to_long(index, -1));
+			else
+				throw std::runtime_error("Invalid index");
+			if (i >= cols_->size())
+				throw std::runtime_error("Invalid index");
+			return (*cols_)[i];
+		}
+	};
+
+	using ColumnsPtr = std::shared_ptr<Columns>;
+
+	/* Fake worksheet. Mirrors the Worksheet interface of the type library. */
+	class Worksheet {
+		std::shared_ptr<std::vector<ColumnPtr>> cols_;
+		COLDATAFORMAT fmt_; // Format of new columns.
+
+		void resize(std::size_t cols) {
+			while (cols_->size() < cols)
+				cols_->push_back(std::make_shared<Column>(fmt_));
+			cols_->resize(cols);
+		}
+
+	public:
+		explicit Worksheet(std::size_t cols = 2, COLDATAFORMAT fmt = DF_TEXT_NUMERIC) : cols_(std::make_shared<std::vector<ColumnPtr>>()), fmt_(fmt) {
+			resize(cols);
+		}
+
+		long GetCols() {
+			detail::round_trip rt(detail::call_kind::other);
+			return static_cast<long>(cols_->size());
+		}
+
+		/* Adds or removes columns at the right, as Origin does */
+		void PutCols(long cols) {
+			detail::round_trip rt(detail::call_kind::other);
+			resize(cols < 0 ? 0 : static_cast<std::size_t>(cols));
+		}
+
+		ColumnsPtr GetColumns() {
+			detail::round_trip rt(detail::call_kind::other);
+			return std::make_shared<Columns>(cols_);
+		}
+
+		/* Expects data as orglab_data sends it: dimension 1 is columns, dimension 2 is rows */
+		/* (row major memory). Each column converts the values as its own SetData would. */
+		/* Adds columns when data reaches past the last one. */
+		VARIANT_BOOL SetData(const _variant_t& data, const _variant_t& r1, const _variant_t& c1) {
+			detail::round_trip rt(detail::call_kind::set_data);
+			std::size_t ncols = detail::array_count(data, 1);
+			std::size_t nrows = detail::array_count(data, 2);
+			long row0 = detail::to_long(r1, 0), col0 = detail::to_long(c1, 0);
+			if (row0 < 0 || col0 < 0)
+				throw std::runtime_error("Invalid offset");
+			if (static_cast<std::size_t>(col0) + ncols > cols_->size())
+				resize(static_cast<std::size_t>(col0) + ncols);
+			detail::storage src = detail::storage_of_vt(static_cast<VARTYPE>(data.vt & VT_TYPEMASK));
+			std::size_t ssz = detail::storage::text == src ? sizeof(BSTR) : detail::storage_size(src);
+			void* p = nullptr;
+			::SafeArrayAccessData(data.parray, &p);
+			std::vector<unsigned char> cells(nrows * ssz);
+			for (std::size_t k = 0; k < ncols; ++k) {
+				const unsigned char* in = static_cast<const unsigned char*>(p) + k * ssz;
+				for (std::size_t j = 0; j < nrows; ++j)
+					std::memcpy(cells.data() + j * ssz, in + j * ncols * ssz, ssz);
+				(*cols_)[col0 + k]->put_cells(src, cells.data(), nrows, static_cast<std::size_t>(row0));
+			}
+			::SafeArrayUnaccessData(data.parray);
+			return VARIANT_TRUE;
+		}
+
+		/* Returns rows r1 to r2 (-1 for the end of the longest column) of columns c1 to c2 as */
+		/* a 2D array: dimension 1 is rows, dimension 2 is columns (column major memory). */
+		/* ARRAY2D_NUMERIC gives doubles, the text formats BSTRs. Short columns are padded */
+		/* with missing values. */
+		_variant_t GetData(const _variant_t& r1, const _variant_t& c1, const _variant_t& r2, const _variant_t& c2, ARRAYDATAFORMAT format, const _variant_t& lowbound) {
+			detail::round_trip rt(detail::call_kind::get_data);
+			bool text = ARRAY2D_STR == format || ARRAY2D_TEXT == format || ARRAY2D_STR_FULL_PRECISION == format || ARRAY2D_TEXT_FULL_PRECISION == format;
+			if (!text && ARRAY2D_NUMERIC != format)
+				throw std::runtime_error("Unsupported data format");
+			bool full = ARRAY2D_STR_FULL_PRECISION == format || ARRAY2D_TEXT_FULL_PRECISION == format;
+			long row0 = detail::to_long(r1, 0), col0 = detail::to_long(c1, 0);
+			long row1 = detail::to_long(r2, -1), col1 = detail::to_long(c2, -1);
+			if (col1 < 0 || static_cast<std::size_t>(col1) >= cols_->size())
+				col1 = static_cast<long>(cols_->size()) - 1;
+			if (row0 < 0 || col0 < 0 || col1 < col0)
+				return _variant_t();
+			std::size_t longest = 0;
+			for (long k = col0; k <= col1; ++k)
+				longest = (std::max)(longest, (*cols_)[k]->rows_);
+			if (row1 < 0 || static_cast<std::size_t>(row1) >= longest)
+				row1 = static_cast<long>(longest) - 1;
+			if (row1 < row0)
+				return _variant_t();
+			std::size_t nrows = static_cast<std::size_t>(row1 - row0 + 1), ncols = static_cast<std::size_t>(col1 - col0 + 1);
+			long lb = detail::to_long(lowbound, 0);
+			SAFEARRAYBOUND bounds[2] = { { static_cast<ULONG>(nrows), lb }, { static_cast<ULONG>(ncols), lb } };
+			void* p = nullptr;
+			_variant_t v = detail::make_array(text ? VT_BSTR : VT_R8, 2, bounds, &p);
+			for (std::size_t k = 0; k < ncols; ++k) {
+				const Column& col = *(*cols_)[col0 + k];
+				for (std::size_t j = 0; j < nrows; ++j) {
+					std::size_t i = static_cast<std::size_t>(row0) + j;
+					if (text) {
+						std::wstring str = i < col.rows_ ? col.text_at(i, full) : std::wstring();
+						static_cast<BSTR*>(p)[k * nrows + j] = ::SysAllocStringLen(str.data(), static_cast<UINT>(str.size()));
+					}
+					else
+						static_cast<double*>(p)[k * nrows + j] = i < col.rows_ ? col.number_at(i) : std::numeric_limits<double>::quiet_NaN();
+				}
+			}
+			detail::server().stats.bytes_out += nrows * ncols * (text ? sizeof(BSTR) : sizeof(double));
+			return v;
+		}
+
+		/* Fake-only helper. Column at zero-based index without a round-trip. */
+		ColumnPtr column(std::size_t index) const { return cols_->at(index); }
+
+		/* Fake-only helper. Number of columns. */
+		std::size_t cols() const { return cols_->size(); }
+	};
+
+	using WorksheetPtr = std::shared_ptr<Worksheet>;
+
+	/* Creates a fake worksheet column */
+	inline ColumnPtr make_column(COLDATAFORMAT fmt = DF_TEXT_NUMERIC) {
+		return std::make_shared<Column>(fmt);
+	}
+
+	/* Creates a fake worksheet with cols columns of format fmt */
+	inline WorksheetPtr make_worksheet(std::size_t cols = 2, COLDATAFORMAT fmt = DF_TEXT_NUMERIC) {
+		return std::make_shared<Worksheet>(cols, fmt);
+	}
+
+	/* Creates a fake matrix object with fixed dimensions */
+	inline MatrixObjectPtr make_matrix(std::size_t rows, std::size_t cols, COLDATAFORMAT fmt = DF_DOUBLE) {
+		return std::make_shared<MatrixObject>(rows, cols, fmt);
+	}
+
+} /* End namespace orglab_data_fake */
+
+#endif /* ORGLAB_DATA_FAKE_HPP */